@@ -0,0 +1,124 @@
+/*
+ * 落ちている文字列の一覧
+ */
+
+#include <stdlib.h>
+#include "active_list.h"
+
+/**
+ * 空の一覧を作る
+ *
+ * @param list 一覧
+ * @param capacity 文字列の数 (番号は0からcapacity-1まで)
+ *
+ * @return 0:成功 -1:メモリの確保に失敗
+ */
+int active_list_init(ActiveList *list, int capacity){
+    list->links = (ActiveLink*) calloc(capacity > 0 ? capacity : 1, sizeof(ActiveLink));
+    if(list->links == NULL){
+        return -1;
+    }
+    list->capacity = capacity;
+    list->head = -1;
+    list->tail = -1;
+    list->num = 0;
+    return 0;
+}
+
+/**
+ * 一覧のメモリを解放する
+ *
+ * @param list 一覧
+ */
+void active_list_free(ActiveList *list){
+    free(list->links);
+    list->links = NULL;
+    list->capacity = 0;
+    list->head = -1;
+    list->tail = -1;
+    list->num = 0;
+}
+
+/**
+ * 文字列を末尾に追加する
+ *
+ * @param list 一覧
+ * @param index 文字列の番号
+ *
+ * @return 0:成功 -1:番号が範囲外か、すでに一覧に入っている
+ */
+int active_list_push(ActiveList *list, int index){
+    ActiveLink *link; // 追加する文字列のつながり
+
+    if(index < 0 || list->capacity <= index || list->links[index].isActive == 1){
+        return -1;
+    }
+    link = &list->links[index];
+    link->prev = list->tail;
+    link->next = -1;
+    link->isActive = 1;
+    if(list->tail != -1){
+        list->links[list->tail].next = index;
+    }else{
+        list->head = index;
+    }
+    list->tail = index;
+    list->num++;
+    return 0;
+}
+
+/**
+ * 文字列を一覧から外す ほかの文字列の順番は変わらない
+ *
+ * @param list 一覧
+ * @param index 文字列の番号
+ *
+ * @return 0:成功 -1:番号が範囲外か、一覧に入っていない
+ */
+int active_list_remove(ActiveList *list, int index){
+    ActiveLink *link; // 外す文字列のつながり
+
+    if(index < 0 || list->capacity <= index || list->links[index].isActive == 0){
+        return -1;
+    }
+    link = &list->links[index];
+    if(link->prev != -1){
+        list->links[link->prev].next = link->next;
+    }else{
+        list->head = link->next;
+    }
+    if(link->next != -1){
+        list->links[link->next].prev = link->prev;
+    }else{
+        list->tail = link->prev;
+    }
+    link->prev = -1;
+    link->next = -1;
+    link->isActive = 0;
+    list->num--;
+    return 0;
+}
+
+/**
+ * 先頭の文字列の番号を返す
+ *
+ * @param list 一覧
+ *
+ * @return 文字列の番号 空の時は-1
+ */
+int active_list_first(const ActiveList *list){
+    return list->head;
+}
+
+/**
+ * 次の文字列の番号を返す
+ * 今の文字列を外しても続けられるように、外す前に次の番号を取っておくこと
+ *
+ * @param list 一覧
+ * @param index 今の文字列の番号
+ *
+ * @return 次の文字列の番号 末尾の時は-1
+ */
+int active_list_next(const ActiveList *list, int index){
+    return list->links[index].next;
+}
@@ -0,0 +1,36 @@
+/*
+ * 落ちている文字列の一覧
+ * 文字列の番号ごとに前後の番号を持つ双方向リストなので、追加と削除は一覧の長さによらず一定の時間で終わる。
+ * 一覧の順番は追加した順のまま変わらず、先頭が一番早く落ち始めた文字列になる。
+ * 同時に入れられる文字列の数は、作る時に指定した文字列の数まで。
+ */
+
+#ifndef FALLTYPING_ACTIVE_LIST_H
+#define FALLTYPING_ACTIVE_LIST_H
+
+/* ------ 構造体の宣言 ------*/
+// 一つの文字列の前後のつながり
+typedef struct{
+    int prev;     // 前の文字列の番号 (-1は先頭)
+    int next;     // 次の文字列の番号 (-1は末尾)
+    int isActive; // 一覧に入っているかどうか
+}ActiveLink;
+
+// 落ちている文字列の一覧
+typedef struct{
+    ActiveLink *links; // 文字列の番号ごとのつながり
+    int capacity;      // 文字列の数
+    int head;          // 先頭の文字列の番号 (-1は空)
+    int tail;          // 末尾の文字列の番号 (-1は空)
+    int num;           // 一覧に入っている文字列の数
+}ActiveList;
+
+/* ------ プロトタイプ宣言 ------ */
+int active_list_init(ActiveList *list, int capacity); // 空の一覧を作る
+void active_list_free(ActiveList *list); // 一覧のメモリを解放する
+int active_list_push(ActiveList *list, int index); // 文字列を末尾に追加する
+int active_list_remove(ActiveList *list, int index); // 文字列を一覧から外す
+int active_list_first(const ActiveList *list); // 先頭の文字列の番号を返す
+int active_list_next(const ActiveList *list, int index); // 次の文字列の番号を返す
+
+#endif
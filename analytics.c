@@ -0,0 +1,307 @@
+/*
+ * キー入力ごとの速さと正確さの集計
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "analytics.h"
+
+#define NS_PER_MS 1000000LL   // 1ミリ秒のナノ秒
+#define NS_PER_MIN 60000000000LL // 1分のナノ秒
+#define WORST_KANA_MIN 3      // 苦手な仮名として選ぶのに必要なキー入力の回数
+
+/* ------ プロトタイプ宣言 ------ */
+static void histogram_add(LatencyHistogram *histogram, long long latency); // 度数分布に時間を一つ数える
+static void write_histogram(FILE *fp, const char *name, const LatencyHistogram *histogram); // 度数分布の要約を書き出す
+
+/**
+ * 空の集計を作る
+ *
+ * @param analytics 集計
+ * @param patternNum 入力パターンの番号の数 (romajiTable.nodeNum)
+ *
+ * @return 0:成功 -1:メモリの確保に失敗
+ */
+int analytics_init(Analytics *analytics, int patternNum){
+    memset(analytics, 0, sizeof(Analytics));
+    analytics->patternAttempt = (int*) calloc(patternNum > 0 ? patternNum : 1, sizeof(int));
+    analytics->patternFailure = (int*) calloc(patternNum > 0 ? patternNum : 1, sizeof(int));
+    if(analytics->patternAttempt == NULL || analytics->patternFailure == NULL){
+        analytics_free(analytics);
+        return -1;
+    }
+    analytics->patternNum = patternNum;
+    return 0;
+}
+
+/**
+ * 集計のメモリを解放する
+ *
+ * @param analytics 集計
+ */
+void analytics_free(Analytics *analytics){
+    free(analytics->patternAttempt);
+    free(analytics->patternFailure);
+    analytics->patternAttempt = NULL;
+    analytics->patternFailure = NULL;
+    analytics->patternNum = 0;
+}
+
+/**
+ * キー入力を一つ数える
+ *
+ * @param analytics 集計
+ * @param time キー入力のゲームの時間 (ナノ秒)
+ * @param kana 入力していた仮名の番号 (-1は文字列がない)
+ * @param pattern 入力していた入力パターンの番号 (-1は文字列がない)
+ * @param isAccept 正しい入力かどうか 0 : 間違い 1 : 正しい
+ */
+void analytics_key(Analytics *analytics, long long time, int kana, int pattern, int isAccept){
+    if(analytics->hasLastKey == 1){
+        histogram_add(&analytics->interval, time - analytics->lastKeyTime);
+        if(0 <= kana && kana < JPN_CHAR_NUM){
+            analytics->kanaTime[kana] += time - analytics->lastKeyTime;
+            analytics->kanaTimeNum[kana]++;
+        }
+    }
+    analytics->lastKeyTime = time;
+    analytics->hasLastKey = 1;
+    isAccept == 1 ? analytics->acceptNum++ : analytics->failureNum++;
+    if(0 <= kana && kana < JPN_CHAR_NUM){
+        analytics->kanaAttempt[kana]++;
+        if(isAccept == 0)analytics->kanaFailure[kana]++;
+    }
+    if(0 <= pattern && pattern < analytics->patternNum){
+        analytics->patternAttempt[pattern]++;
+        if(isAccept == 0)analytics->patternFailure[pattern]++;
+    }
+}
+
+/**
+ * 反応時間を一つ数える
+ *
+ * @param analytics 集計
+ * @param latency 入力先の文字列が打てるようになってから最初のキー入力までの時間 (ナノ秒)
+ */
+void analytics_reaction(Analytics *analytics, long long latency){
+    histogram_add(&analytics->reaction, latency);
+}
+
+/**
+ * 入力し終えた文字列を一つ数える
+ *
+ * @param analytics 集計
+ */
+void analytics_complete(Analytics *analytics){
+    analytics->completeNum++;
+}
+
+/**
+ * 度数分布の百分位数を返す
+ * 1ミリ秒ごとに数えているので、値はその区間の上端になる
+ *
+ * @param histogram 度数分布
+ * @param rate 求める割合 (0.5 で中央値)
+ *
+ * @return 百分位数 (ミリ秒) 数えた回数が0の時は0
+ */
+double analytics_percentile(const LatencyHistogram *histogram, double rate){
+    long long target = (long long)(histogram->num * rate + 0.999999); // 百分位数になる順位
+    long long count = 0; // 数えた回数の累計
+
+    if(histogram->num == 0){
+        return 0;
+    }
+    if(target < 1)target = 1;
+    for(int i = 0; i < ANALYTICS_BUCKET_NUM; i++){
+        count += histogram->buckets[i];
+        if(count >= target){
+            return i + 1;
+        }
+    }
+    return ANALYTICS_BUCKET_NUM;
+}
+
+/**
+ * 正しく入力した割合を返す
+ *
+ * @param analytics 集計
+ *
+ * @return 0から1までの割合 キー入力がない時は0
+ */
+double analytics_accuracy(const Analytics *analytics){
+    int keyNum = analytics->acceptNum + analytics->failureNum; // キー入力の数
+
+    return keyNum > 0 ? (double)analytics->acceptNum / keyNum : 0;
+}
+
+/**
+ * 1分あたりの正しいキー入力の数を返す
+ *
+ * @param analytics 集計
+ * @param gameTime ゲームにかかった時間 (ナノ秒)
+ *
+ * @return 1分あたりの正しいキー入力の数
+ */
+double analytics_kpm(const Analytics *analytics, long long gameTime){
+    return gameTime > 0 ? analytics->acceptNum * (double)NS_PER_MIN / gameTime : 0;
+}
+
+/**
+ * 1分あたりの入力し終えた文字列の数を返す
+ *
+ * @param analytics 集計
+ * @param gameTime ゲームにかかった時間 (ナノ秒)
+ *
+ * @return 1分あたりの入力し終えた文字列の数
+ */
+double analytics_wpm(const Analytics *analytics, long long gameTime){
+    return gameTime > 0 ? analytics->completeNum * (double)NS_PER_MIN / gameTime : 0;
+}
+
+/**
+ * 一番間違えた割合が高い仮名を返す
+ * キー入力の回数が少ない仮名は選ばない
+ *
+ * @param analytics 集計
+ * @param errorRate 間違えた割合を保存する変数
+ *
+ * @return 仮名の番号 間違えた仮名がない時は-1
+ */
+int analytics_worst_kana(const Analytics *analytics, double *errorRate){
+    int worst = -1; // 一番間違えた割合が高い仮名の番号
+    double worstRate = 0; // その割合
+
+    for(int i = 0; i < JPN_CHAR_NUM; i++){
+        if(analytics->kanaAttempt[i] < WORST_KANA_MIN || analytics->kanaFailure[i] == 0)continue;
+        double rate = (double)analytics->kanaFailure[i] / analytics->kanaAttempt[i]; // 間違えた割合
+        if(rate > worstRate){
+            worst = i;
+            worstRate = rate;
+        }
+    }
+    *errorRate = worstRate;
+    return worst;
+}
+
+/**
+ * 仮名の入力が、全体のキー入力の間隔の平均より何倍遅いかを返す
+ * 前のキー入力からの時間を数えた回数が少ない仮名は、平均と同じとする
+ *
+ * @param analytics 集計
+ * @param kana 仮名の番号
+ *
+ * @return 仮名のキー入力の間隔の平均 / 全体のキー入力の間隔の平均
+ */
+double analytics_kana_slowness(const Analytics *analytics, int kana){
+    if(kana < 0 || JPN_CHAR_NUM <= kana || analytics->kanaTimeNum[kana] < WORST_KANA_MIN
+       || analytics->interval.sum <= 0){
+        return 1.0;
+    }
+    return ((double)analytics->kanaTime[kana] / analytics->kanaTimeNum[kana])
+           / ((double)analytics->interval.sum / analytics->interval.num);
+}
+
+/**
+ * 集計をJSONのファイルに書き出す
+ * 入力パターンは番号が違っても入力例が同じものをまとめる
+ *
+ * @param analytics 集計
+ * @param path 書き出すファイルのパス
+ * @param result ゲームの結果 (「CLEAR」か「FAILURE」)
+ * @param level 難易度
+ * @param score スコア
+ * @param gameTime ゲームにかかった時間 (ナノ秒)
+ *
+ * @return 0:成功 -1:失敗
+ */
+int analytics_write(const Analytics *analytics, const char *path, const char *result,
+                    int level, int score, long long gameTime){
+    FILE *fp; // 書き出すファイルのポインタ
+    char kanaName[4]; // 仮名の文字
+    int isFirst = 1; // 配列の最初の要素かどうか
+
+    if((fp = fopen(path, "w")) == NULL){
+        printf("ファイルのオープンに失敗しました\n%sに書き込めるかを確認してください\n", path);
+        return -1;
+    }
+    fprintf(fp, "{\n  \"result\": \"%s\",\n  \"level\": %d,\n  \"score\": %d,\n  \"game_sec\": %.3f,\n",
+            result, level, score, gameTime / 1000000000.0);
+    fprintf(fp, "  \"accept\": %d,\n  \"failure\": %d,\n  \"complete\": %d,\n",
+            analytics->acceptNum, analytics->failureNum, analytics->completeNum);
+    fprintf(fp, "  \"accuracy\": %.4f,\n  \"kpm\": %.1f,\n  \"wpm\": %.2f,\n",
+            analytics_accuracy(analytics), analytics_kpm(analytics, gameTime), analytics_wpm(analytics, gameTime));
+    write_histogram(fp, "interval_ms", &analytics->interval);
+    write_histogram(fp, "reaction_ms", &analytics->reaction);
+
+    fprintf(fp, "  \"kana\": [");
+    for(int i = 0; i < JPN_CHAR_NUM; i++){
+        if(analytics->kanaAttempt[i] == 0)continue;
+        romaji_kana_name(i, kanaName);
+        fprintf(fp, "%s\n    {\"kana\": \"%s\", \"attempt\": %d, \"failure\": %d, \"error_rate\": %.4f}",
+                isFirst == 1 ? "" : ",", kanaName, analytics->kanaAttempt[i], analytics->kanaFailure[i],
+                (double)analytics->kanaFailure[i] / analytics->kanaAttempt[i]);
+        isFirst = 0;
+    }
+    fprintf(fp, "%s],\n", isFirst == 1 ? "" : "\n  ");
+
+    isFirst = 1;
+    fprintf(fp, "  \"pattern\": [");
+    for(int i = 0; i < analytics->patternNum; i++){
+        int attempt = 0, failure = 0; // 同じ入力例のパターンの合計
+        int isDuplicate = 0; // 前に同じ入力例のパターンを書き出したかどうか
+        if(analytics->patternAttempt[i] == 0)continue;
+        for(int j = 0; j < i && isDuplicate == 0; j++){
+            if(analytics->patternAttempt[j] > 0 && strcmp(romaji_pattern_str(j), romaji_pattern_str(i)) == 0)isDuplicate = 1;
+        }
+        if(isDuplicate == 1)continue;
+        for(int j = i; j < analytics->patternNum; j++){
+            if(analytics->patternAttempt[j] > 0 && strcmp(romaji_pattern_str(j), romaji_pattern_str(i)) == 0){
+                attempt += analytics->patternAttempt[j];
+                failure += analytics->patternFailure[j];
+            }
+        }
+        fprintf(fp, "%s\n    {\"pattern\": \"%s\", \"attempt\": %d, \"failure\": %d, \"error_rate\": %.4f}",
+                isFirst == 1 ? "" : ",", romaji_pattern_str(i), attempt, failure, (double)failure / attempt);
+        isFirst = 0;
+    }
+    fprintf(fp, "%s]\n}\n", isFirst == 1 ? "" : "\n  ");
+
+    if(fclose(fp) != 0){
+        printf("%sへの書き込みに失敗しました\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 度数分布に時間を一つ数える
+ * 負の時間は0、区間に収まらない時間は最後の区間に数える
+ *
+ * @param histogram 度数分布
+ * @param latency 時間 (ナノ秒)
+ */
+static void histogram_add(LatencyHistogram *histogram, long long latency){
+    long long bucket; // 数える区間
+
+    if(latency < 0)latency = 0;
+    bucket = latency / NS_PER_MS;
+    if(bucket >= ANALYTICS_BUCKET_NUM)bucket = ANALYTICS_BUCKET_NUM - 1;
+    histogram->buckets[bucket]++;
+    histogram->num++;
+    histogram->sum += latency;
+}
+
+/**
+ * 度数分布の要約を書き出す
+ *
+ * @param fp 書き出すファイルのポインタ
+ * @param name 要素の名前
+ * @param histogram 度数分布
+ */
+static void write_histogram(FILE *fp, const char *name, const LatencyHistogram *histogram){
+    fprintf(fp, "  \"%s\": {\"count\": %d, \"mean\": %.1f, \"p50\": %.0f, \"p95\": %.0f, \"p99\": %.0f},\n",
+            name, histogram->num, histogram->num > 0 ? (double)histogram->sum / histogram->num / NS_PER_MS : 0,
+            analytics_percentile(histogram, 0.50), analytics_percentile(histogram, 0.95), analytics_percentile(histogram, 0.99));
+}
@@ -0,0 +1,59 @@
+/*
+ * キー入力ごとの速さと正確さの集計
+ *
+ * キー入力の間隔と、入力先の文字列が打てるようになってから最初のキー入力までの時間 (反応時間) を
+ * 1ミリ秒ごとの度数分布に数えるので、キー入力が何回あっても使うメモリは変わらず、
+ * p50/p95/p99 もゲームの後に度数分布をなぞるだけで求まる。
+ * 仮名ごと、入力パターン (「shi」「kya」など) ごとの間違いの数も数える。
+ * メモリは analytics_init で全て確保するので、ゲーム中にメモリを確保することはない。
+ */
+
+#ifndef FALLTYPING_ANALYTICS_H
+#define FALLTYPING_ANALYTICS_H
+
+#include "romaji.h"
+
+#define ANALYTICS_BUCKET_NUM 2000 // 度数分布の区間の数 (1ミリ秒ごと 最後の区間は それ以上 をまとめる)
+
+/* ------ 構造体の宣言 ------*/
+// 時間の度数分布
+typedef struct{
+    unsigned int buckets[ANALYTICS_BUCKET_NUM]; // 1ミリ秒ごとの回数
+    int num;                                    // 数えた回数
+    long long sum;                              // 時間の合計 (ナノ秒)
+}LatencyHistogram;
+
+// 一回のゲームの集計
+typedef struct{
+    LatencyHistogram interval; // キー入力の間隔
+    LatencyHistogram reaction; // 反応時間
+    long long lastKeyTime;     // 前のキー入力のゲームの時間 (ナノ秒)
+    int hasLastKey;            // 前のキー入力があるかどうか
+    int acceptNum;             // 正しく入力された回数
+    int failureNum;            // 入力を間違った回数
+    int completeNum;           // 入力し終えた文字列の数
+    int kanaAttempt[JPN_CHAR_NUM]; // 仮名ごとのキー入力の回数
+    int kanaFailure[JPN_CHAR_NUM]; // 仮名ごとの間違いの回数
+    long long kanaTime[JPN_CHAR_NUM]; // 仮名ごとの、前のキー入力からの時間の合計 (ナノ秒)
+    int kanaTimeNum[JPN_CHAR_NUM];    // 仮名ごとの、前のキー入力からの時間を数えた回数
+    int *patternAttempt;       // 入力パターンごとのキー入力の回数
+    int *patternFailure;       // 入力パターンごとの間違いの回数
+    int patternNum;            // 入力パターンの番号の数
+}Analytics;
+
+/* ------ プロトタイプ宣言 ------ */
+int analytics_init(Analytics *analytics, int patternNum); // 空の集計を作る
+void analytics_free(Analytics *analytics); // 集計のメモリを解放する
+void analytics_key(Analytics *analytics, long long time, int kana, int pattern, int isAccept); // キー入力を一つ数える
+void analytics_reaction(Analytics *analytics, long long latency); // 反応時間を一つ数える
+void analytics_complete(Analytics *analytics); // 入力し終えた文字列を一つ数える
+double analytics_percentile(const LatencyHistogram *histogram, double rate); // 度数分布の百分位数をミリ秒で返す
+double analytics_accuracy(const Analytics *analytics); // 正しく入力した割合を返す
+double analytics_kpm(const Analytics *analytics, long long gameTime); // 1分あたりの正しいキー入力の数を返す
+double analytics_wpm(const Analytics *analytics, long long gameTime); // 1分あたりの入力し終えた文字列の数を返す
+int analytics_worst_kana(const Analytics *analytics, double *errorRate); // 一番間違えた割合が高い仮名を返す
+double analytics_kana_slowness(const Analytics *analytics, int kana); // 仮名の入力が全体の平均より何倍遅いかを返す
+int analytics_write(const Analytics *analytics, const char *path, const char *result,
+                    int level, int score, long long gameTime); // 集計をJSONのファイルに書き出す
+
+#endif
@@ -0,0 +1,454 @@
+/*
+ * falltyping-bench
+ * 描画なしでゲームの中身の速さを測り、結果をJSONで標準出力に書き出すツール
+ * ローマ字の入力判定を変えた時に、遅くなっていないかを前の結果と比べて確かめるのに使う。
+ *
+ * 測るもの
+ *   corpus_load          文字列のファイルを読み込む時間
+ *   set_string_example   全ての文字列の入力例を作り直す速さ
+ *   check_input_char     一つのキー入力の判定の時間
+ *                        (正しい入力、間違った入力、入力例と違う打ち方で入力例を作り直す入力)
+ *   get_japanese_index   仮名の文字の番号を引く速さ
+ *   round                決まった速さと間違える割合で打つ人を真似て、一回のゲームを最後まで進める時間
+ * それぞれ BENCH_MIN_SEC 秒以上になるまで繰り返し、一回あたりの平均を書き出す。
+ * キー入力の判定は一回ずつの時間も測り、p50/p99 も書き出す (時間の取得にかかる時間を含む)。
+ *
+ * 使い方
+ *   falltyping-bench [string.txt string_kana.txt youon.txt]
+ * 引数を省略した時は、ゲームと同じく ./../ のファイルを使う。
+ *
+ * コンパイル
+ *   cc -O2 -pthread -o falltyping-bench bench.c romaji.c corpus.c corpus_image.c game_clock.c text_metrics.c trace.c active_list.c rng.c shuffle_bag.c span_index.c target_index.c game.c game_rules.c replay.c analytics.c difficulty.c render_headless.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "romaji.h"
+#include "corpus.h"
+#include "game.h"
+#include "game_clock.h"
+#include "text_metrics.h"
+#include "render.h"
+
+#define BENCH_MIN_SEC 0.2       // 一つの計測を繰り返す最小の時間 (秒)
+#define BENCH_SAMPLE_MAX 200000 // 一回ずつの時間を保存するキー入力の数
+#define BENCH_WND_WIDTH 1000    // ゲームを進める時の画面の幅
+#define BENCH_WND_HEIGHT 600    // ゲームを進める時の画面の高さ
+#define BENCH_ROUND_MAX_SEC 600 // 一回のゲームを進める最大の時間 (秒)
+
+/* ------ 構造体の宣言 ------*/
+// 一回ずつ測った時間
+typedef struct{
+    long long *samples; // 時間 (ナノ秒)
+    int num;            // 保存した数
+    long long sum;      // 全ての時間の合計 (保存しなかった分も含む)
+    long long count;    // 測った回数
+}LatencySamples;
+
+// 真似をして打つ人
+typedef struct{
+    double kps;       // 1秒あたりのキー入力の数
+    double errorRate; // 間違える割合
+}Typist;
+
+/* ------ プロトタイプ宣言 ------ */
+static int load_youon(const char *path); // 拗音のパターンを読み込んで、入力判定の表を作る
+static void bench_corpus_load(const char *stringPath, const char *stringKanaPath); // 文字列のファイルを読み込む時間を測る
+static void bench_set_example(Str *strings, int strNum); // 入力例を作り直す速さを測る
+static void bench_check_input(Str *strings, int strNum); // キー入力の判定の時間を測る
+static void bench_japanese_index(const Corpus *corpus); // 仮名の文字の番号を引く速さを測る
+static void bench_round(const Corpus *corpus, const Typist *typist, int isLast); // 一回のゲームを最後まで進める時間を測る
+static int wrong_key(const Str *str); // 今の入力位置で間違いになるキーを返す
+static int other_key(const Str *str); // 今の入力位置で正しいが、入力例とは違うキーを返す
+static void samples_add(LatencySamples *latency, long long time); // 時間を一つ保存する
+static long long samples_percentile(LatencySamples *latency, double rate); // 保存した時間の百分位数を返す
+static int compare_long(const void *a, const void *b); // qsort で時間を比べる
+
+/* ------ グローバル変数の宣言 ------*/
+// 拗音がくるパターンを保存する二次元配列
+int youon[KANA_NUM][SMALL_KANA_NUM];
+// 最適化で計測する処理が消されないように、結果を足しておく変数
+volatile long long benchSink;
+// 入力例の選び方に使う打ち方の好み (check_input_char で打った打ち方を数える)
+RomajiProfile benchProfile;
+
+/* ---------------------- */
+/* ------ メイン処理 ------ */
+/* ---------------------- */
+int main(int argc, char *argv[]) {
+    const char *stringPath = "./../string.txt"; // 落とす文字列のあるファイルのパス
+    const char *stringKanaPath = "./../string_kana.txt"; // 落とす文字列の仮名のあるファイルのパス
+    const char *youonPath = "./../youon.txt"; // 拗音がくるパターンのあるファイルのパス
+    Corpus corpus; // 読み込んだ文字列
+    Str *strings; // 文字列の情報を保持する構造体
+    Typist typists[] = {{3.0, 0.10}, {6.0, 0.05}, {12.0, 0.02}}; // 真似をして打つ人
+    int typistNum = sizeof(typists) / sizeof(typists[0]); // 真似をして打つ人の数
+
+    if(argc == 4){
+        stringPath = argv[1];
+        stringKanaPath = argv[2];
+        youonPath = argv[3];
+    }else if(argc != 1){
+        printf("使い方: %s [string.txt string_kana.txt youon.txt]\n", argv[0]);
+        return 1;
+    }
+    if(load_youon(youonPath) != 0){
+        return 1;
+    }
+    if(corpus_load(&corpus, stringPath, stringKanaPath) != 0){
+        romaji_free();
+        return 1;
+    }
+    if(corpus.wordNum == 0){
+        printf("%sに文字列がありません\n", stringPath);
+        corpus_free(&corpus);
+        romaji_free();
+        return 1;
+    }
+    // 入力例の描画位置の計算に描画範囲のキャッシュを使うので、描画しない描画先を開いておく
+    render_open(BENCH_WND_WIDTH, BENCH_WND_HEIGHT);
+    text_metrics_init(render_add_layer());
+
+    strings = (Str*) calloc(corpus.wordNum, sizeof(Str));
+    if(strings == NULL){
+        printf("文字列を保存するメモリの確保に失敗しました\n");
+        corpus_free(&corpus);
+        romaji_free();
+        return 1;
+    }
+    for(int i = 0; i < corpus.wordNum; i++){
+        prepare_string(strings, i, &corpus, &benchProfile);
+    }
+
+    printf("{\n  \"words\": %d,\n  \"nodes\": %d,\n", corpus.wordNum, romajiTable.nodeNum);
+    bench_corpus_load(stringPath, stringKanaPath);
+    bench_set_example(strings, corpus.wordNum);
+    bench_check_input(strings, corpus.wordNum);
+    bench_japanese_index(&corpus);
+    printf("  \"round\": [");
+    for(int i = 0; i < typistNum; i++){
+        bench_round(&corpus, &typists[i], i == typistNum - 1);
+    }
+    printf("\n  ]\n}\n");
+
+    free(strings);
+    corpus_free(&corpus);
+    romaji_free();
+    return 0;
+}
+
+/**
+ * 拗音のパターンをファイルから読み込んで、入力判定の表を作る
+ *
+ * @param path youon.txt のパス
+ *
+ * @return 0:成功 -1:失敗
+ */
+static int load_youon(const char *path){
+    FILE *fpInYouon; // 拗音がくるパターンのあるファイル用のポインタ
+
+    if((fpInYouon = fopen(path,"r")) == NULL){
+        printf("ファイルのオープンに失敗しました\nyouon.txtがあるかを確認してください\n");
+        return -1;
+    }
+    for(int i = 0; i < KANA_NUM; i++){
+        for(int j = 0; j < SMALL_KANA_NUM; j++){
+            if(fscanf(fpInYouon,"%d", &youon[i][j]) != 1){
+                printf("youon.txtの形式が正しくありません\n");
+                fclose(fpInYouon);
+                return -1;
+            }
+        }
+    }
+    fclose(fpInYouon);
+    if(romaji_init(youon) != 0){
+        printf("入力判定の表の作成に失敗しました\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 文字列のファイルを読み込んで解放するのを繰り返し、一回の時間を書き出す
+ *
+ * @param stringPath 落とす文字列のあるファイルのパス
+ * @param stringKanaPath 落とす文字列の仮名のあるファイルのパス
+ */
+static void bench_corpus_load(const char *stringPath, const char *stringKanaPath){
+    Corpus corpus; // 読み込んだ文字列
+    long long start = game_clock_real_ns(); // 測り始めた時間
+    long long elapsed; // かかった時間
+    int repeat = 0; // 繰り返した回数
+
+    do{
+        if(corpus_load(&corpus, stringPath, stringKanaPath) != 0){
+            return;
+        }
+        benchSink += corpus.wordNum;
+        corpus_free(&corpus);
+        repeat++;
+        elapsed = game_clock_real_ns() - start;
+    }while(elapsed < game_clock_from_sec(BENCH_MIN_SEC));
+    printf("  \"corpus_load\": {\"repeat\": %d, \"ms\": %.4f},\n", repeat, elapsed / 1e6 / repeat);
+}
+
+/**
+ * 全ての文字列の入力例を作り直すのを繰り返し、一つの文字列あたりの時間を書き出す
+ *
+ * @param strings 文字列の情報を保持する構造体
+ * @param strNum 文字列の数
+ */
+static void bench_set_example(Str *strings, int strNum){
+    long long start = game_clock_real_ns(); // 測り始めた時間
+    long long elapsed; // かかった時間
+    long long count = 0; // 入力例を作った回数
+
+    do{
+        for(int i = 0; i < strNum; i++){
+            set_string_example(strings, i, &benchProfile);
+            benchSink += strings[i].exampleLen;
+        }
+        count += strNum;
+        elapsed = game_clock_real_ns() - start;
+    }while(elapsed < game_clock_from_sec(BENCH_MIN_SEC));
+    printf("  \"set_string_example\": {\"count\": %lld, \"ns\": %.1f, \"per_sec\": %.0f},\n",
+           count, (double)elapsed / count, count / game_clock_to_sec(elapsed));
+}
+
+/**
+ * 全ての文字列を最後まで打つのを繰り返し、一つのキー入力の判定の時間を書き出す
+ * 入力例と違う打ち方の時は、check_input_char の中で change_string_example が入力例を作り直すまでを一回とする
+ *   accept   入力例の通りに打つ
+ *   failure  間違いになるキーを打つ (入力位置は変わらない)
+ *   rebuild  入力例とは違うが正しいキーを打てる所では、そのキーを打って入力例を作り直す
+ *
+ * @param strings 文字列の情報を保持する構造体
+ * @param strNum 文字列の数
+ */
+static void bench_check_input(Str *strings, int strNum){
+    const char *names[] = {"accept", "failure", "rebuild"}; // 打ち方の名前
+    LatencySamples latency[3]; // 打ち方ごとの時間
+    long long start, elapsed; // 測り始めた時間とかかった時間
+    long long keyStart, keyTime; // 一つのキー入力の判定を始めた時間とかかった時間
+    int ch, other; // 打つキーと、入力例とは違うが正しいキー
+
+    for(int mode = 0; mode < 3; mode++){
+        memset(&latency[mode], 0, sizeof(LatencySamples));
+        latency[mode].samples = (long long*) malloc(BENCH_SAMPLE_MAX * sizeof(long long));
+        if(latency[mode].samples == NULL){
+            printf("時間を保存するメモリの確保に失敗しました\n");
+            exit(0);
+        }
+        start = game_clock_real_ns();
+        do{
+            for(int i = 0; i < strNum; i++){
+                Str *str = &strings[i]; // 打つ文字列
+
+                set_string_example(strings, i, &benchProfile);
+                while(str->cursor.kanaPos < str->codeLen && str->example.head < ROMAJI_EXAMPLE_SIZE - 1){
+                    ch = (unsigned char)str->example.text[str->example.head];
+                    if(mode == 1){
+                        int wrong = wrong_key(str); // 間違いになるキー
+                        keyStart = game_clock_real_ns();
+                        benchSink += check_input_char(strings, i, wrong, &benchProfile, &benchProfile);
+                        samples_add(&latency[mode], game_clock_real_ns() - keyStart);
+                        check_input_char(strings, i, ch, &benchProfile, &benchProfile); // 入力位置を進める
+                        continue;
+                    }
+                    int isRebuild = mode == 2 && (other = other_key(str)) != -1; // 入力例を作り直すかどうか
+                    if(isRebuild == 1){
+                        ch = other;
+                    }
+                    keyStart = game_clock_real_ns();
+                    if(check_input_char(strings, i, ch, &benchProfile, &benchProfile) != 0){ // 入力例の通りに打って間違いになることはない
+                        break;
+                    }
+                    keyTime = game_clock_real_ns() - keyStart;
+                    benchSink += str->exampleLen;
+                    if(mode == 0 || isRebuild == 1){
+                        samples_add(&latency[mode], keyTime);
+                    }
+                }
+            }
+            elapsed = game_clock_real_ns() - start;
+        }while(elapsed < game_clock_from_sec(BENCH_MIN_SEC));
+    }
+
+    printf("  \"check_input_char\": {");
+    for(int mode = 0; mode < 3; mode++){
+        printf("%s\n    \"%s\": {\"count\": %lld, \"ns\": %.1f, \"p50_ns\": %lld, \"p99_ns\": %lld}",
+               mode == 0 ? "" : ",", names[mode], latency[mode].count,
+               latency[mode].count > 0 ? (double)latency[mode].sum / latency[mode].count : 0,
+               samples_percentile(&latency[mode], 0.50), samples_percentile(&latency[mode], 0.99));
+        free(latency[mode].samples);
+    }
+    printf("\n  },\n");
+    // 後の計測のために、入力位置を先頭に戻しておく
+    for(int i = 0; i < strNum; i++){
+        set_string_example(strings, i, &benchProfile);
+    }
+}
+
+/**
+ * 全ての文字列の仮名の文字の番号を引くのを繰り返し、一回の時間を書き出す
+ *
+ * @param corpus ファイルから読み込んだ文字列
+ */
+static void bench_japanese_index(const Corpus *corpus){
+    CorpusWord word; // 読み込んだ文字列
+    long long start = game_clock_real_ns(); // 測り始めた時間
+    long long elapsed; // かかった時間
+    long long count = 0; // 番号を引いた回数
+
+    do{
+        for(int i = 0; i < corpus->wordNum; i++){
+            if(corpus_get_word(corpus, i, &word) != 0){
+                continue;
+            }
+            for(int j = 0; word.kana[j] != '\0' && word.kana[j+1] != '\0' && word.kana[j+2] != '\0'; j += 3){
+                benchSink += get_japanese_index(word.kana, j);
+                count++;
+            }
+        }
+        elapsed = game_clock_real_ns() - start;
+    }while(elapsed < game_clock_from_sec(BENCH_MIN_SEC) && count > 0);
+    printf("  \"get_japanese_index\": {\"count\": %lld, \"ns\": %.2f, \"per_sec\": %.0f},\n",
+           count, count > 0 ? (double)elapsed / count : 0, count / game_clock_to_sec(elapsed));
+}
+
+/**
+ * 真似をして打つ人で一回のゲームを最後まで進めるのを、乱数の種を変えて繰り返し、一回の時間を書き出す
+ * 難易度は Normal で、打つ人は 1 / SIM_RATE 秒ごとに kps / SIM_RATE の確率でキーを押し、
+ * errorRate の確率で間違ったキーを押す
+ *
+ * @param corpus ファイルから読み込んだ文字列
+ * @param typist 真似をして打つ人
+ * @param isLast 最後の打つ人かどうか (JSONの区切りに使う)
+ */
+static void bench_round(const Corpus *corpus, const Typist *typist, int isLast){
+    GameLevel level = {0}; // Normal と同じ難易度
+    Game game; // ゲームの状態
+    Rng rng; // 打つ人の乱数生成器
+    long long start = game_clock_real_ns(); // 測り始めた時間
+    long long elapsed; // かかった時間
+    long long steps = 0, keys = 0; // 全てのゲームで落下を進めた回数とキー入力の数
+    int rounds = 0, clears = 0; // 進めたゲームの数と、最後まで入力し終えたゲームの数
+    int ch; // 打つキー
+
+    game_level_preset(2, &level);
+    do{
+        if(game_init(&game, corpus, &level, (unsigned long long)rounds + 1, BENCH_WND_WIDTH, BENCH_WND_HEIGHT - 60, 60) != 0){
+            printf("文字列を保存するメモリの確保に失敗しました\n");
+            exit(0);
+        }
+        rng_seed(&rng, (unsigned long long)rounds + 1, 2);
+        while(game_is_over(&game) == 0 && game.step < (long long)SIM_RATE * BENCH_ROUND_MAX_SEC){
+            game_step(&game);
+            if(game.strIndex == -1 || rng_double(&rng) >= typist->kps / SIM_RATE){
+                continue;
+            }
+            Str *str = &game.strings[game.strIndex]; // 入力中の文字列
+            ch = rng_double(&rng) < typist->errorRate ? wrong_key(str) : (unsigned char)str->example.text[str->example.head];
+            game_key(&game, ch, game.nowTime);
+            keys++;
+        }
+        steps += game.step;
+        clears += game.touchEndLine == 0;
+        rounds++;
+        game_free(&game);
+        elapsed = game_clock_real_ns() - start;
+    }while(elapsed < game_clock_from_sec(BENCH_MIN_SEC));
+    printf("\n    {\"kps\": %.1f, \"error_rate\": %.2f, \"rounds\": %d, \"clear_rate\": %.3f, \"ms\": %.4f, "
+           "\"steps_per_round\": %.1f, \"keys_per_round\": %.1f, \"ns_per_step\": %.1f}%s",
+           typist->kps, typist->errorRate, rounds, (double)clears / rounds, elapsed / 1e6 / rounds,
+           (double)steps / rounds, (double)keys / rounds, (double)elapsed / steps, isLast == 1 ? "" : ",");
+}
+
+/**
+ * 今の入力位置で間違いになるキーを返す
+ *
+ * @param str 文字列
+ *
+ * @return キー 全てのキーが正しい時は入力できない文字
+ */
+static int wrong_key(const Str *str){
+    RomajiCursor cursor; // 試しに入力する入力位置
+
+    for(int ch = 'a'; ch <= 'z'; ch++){
+        cursor = str->cursor;
+        if(romaji_input(&cursor, str->code, str->codeLen, ch) != 0){
+            return ch;
+        }
+    }
+    return '!';
+}
+
+/**
+ * 今の入力位置で正しいが、入力例の次の文字とは違うキーを返す (「shi」の代わりに「si」など)
+ *
+ * @param str 文字列
+ *
+ * @return キー ない時は-1
+ */
+static int other_key(const Str *str){
+    RomajiCursor cursor; // 試しに入力する入力位置
+    int exampleCh = (unsigned char)str->example.text[str->example.head]; // 入力例の次の文字
+
+    for(int ch = 'a'; ch <= 'z'; ch++){
+        if(ch == exampleCh)continue;
+        cursor = str->cursor;
+        if(romaji_input(&cursor, str->code, str->codeLen, ch) == 0){
+            return ch;
+        }
+    }
+    return -1;
+}
+
+/**
+ * 時間を一つ保存する 保存できる数を超えた分は、平均にだけ数える
+ *
+ * @param latency 一回ずつ測った時間
+ * @param time 時間 (ナノ秒)
+ */
+static void samples_add(LatencySamples *latency, long long time){
+    if(latency->num < BENCH_SAMPLE_MAX){
+        latency->samples[latency->num++] = time;
+    }
+    latency->sum += time;
+    latency->count++;
+}
+
+/**
+ * 保存した時間の百分位数を返す
+ *
+ * @param latency 一回ずつ測った時間
+ * @param rate 求める割合 (0.5 で中央値)
+ *
+ * @return 百分位数 (ナノ秒) 保存した時間がない時は0
+ */
+static long long samples_percentile(LatencySamples *latency, double rate){
+    int rank; // 百分位数になる順位
+
+    if(latency->num == 0){
+        return 0;
+    }
+    qsort(latency->samples, latency->num, sizeof(long long), compare_long);
+    rank = (int)(latency->num * rate);
+    if(rank >= latency->num)rank = latency->num - 1;
+    return latency->samples[rank];
+}
+
+/**
+ * qsort で時間を小さい順に並べるために比べる
+ *
+ * @param a 時間へのポインタ
+ * @param b 時間へのポインタ
+ *
+ * @return a が小さい時は負、等しい時は0、大きい時は正
+ */
+static int compare_long(const void *a, const void *b){
+    long long x = *(const long long*)a, y = *(const long long*)b; // 比べる時間
+
+    return (x > y) - (x < y);
+}
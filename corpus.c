@@ -0,0 +1,287 @@
+/*
+ * 落とす文字列とその仮名を読み込む処理
+ *
+ * 二つのファイルを行ごとに対応させて読み込む。
+ * 行の中の空白もそのまま文字列として扱い、文字列の数に上限はない。
+ * 仮名に打てない文字がある行は、最後まで打てない文字列にならないように読み飛ばす。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "romaji.h"
+#include "corpus.h"
+#include "corpus_image.h"
+
+/* ------ プロトタイプ宣言 ------ */
+static char *read_text(const char *path); // ファイルの内容を全て読み込む
+static int count_lines(const char *text); // 行の数を数える
+static char *next_line(char **text); // 次の行を取り出す
+
+/**
+ * 文字列とその仮名をファイルから読み込む
+ * 両方のファイルで空の行は読み飛ばし、片方だけが空の行や行数の違いはエラーにする
+ * 仮名に romaji_decode_kana で変換できない文字があるか、仮名が KANA_LEN_MAX 文字より多い行は、行番号を書き出して読み飛ばす
+ * 一番長い打ち方のローマ字が ROMAJI_INPUT_MAX 文字より多い行も、途中から打てなくなるので読み飛ばす
+ * 入力判定の表は romaji_init で作っておく必要がある
+ *
+ * @param corpus 読み込んだ文字列を保存する構造体
+ * @param originPath 落とす文字列のあるファイルのパス
+ * @param kanaPath 落とす文字列の仮名のあるファイルのパス
+ *
+ * @return 0:成功 -1:失敗
+ */
+int corpus_load(Corpus *corpus, const char *originPath, const char *kanaPath){
+    char *originCursor; // 読み込み中の string.txt の位置
+    char *kanaCursor; // 読み込み中の string_kana.txt の位置
+    char *originLine; // 取り出した string.txt の行
+    char *kanaLine; // 取り出した string_kana.txt の行
+    int lineNum = 0; // 読み込んだ行の数
+    unsigned char code[KANA_LEN_MAX]; // 仮名を変換した文字の番号の列 (打てるかを確かめるためだけに使う)
+    int codeLen; // 変換できた仮名の数
+    int inputMax; // 一番長い打ち方をした時のローマ字の数
+
+    memset(corpus, 0, sizeof(Corpus));
+    if((corpus->originText = read_text(originPath)) == NULL){
+        printf("ファイルのオープンに失敗しました\nstring.txtがあるかを確認してください\n");
+        corpus_free(corpus);
+        return -1;
+    }
+    if((corpus->kanaText = read_text(kanaPath)) == NULL){
+        printf("ファイルのオープンに失敗しました\nstring_kana.txtがあるかを確認してください\n");
+        corpus_free(corpus);
+        return -1;
+    }
+
+    // 多い方の行数で配列を確保する
+    int capacity = count_lines(corpus->originText); // 確保した文字列の数
+    if(capacity < count_lines(corpus->kanaText)){
+        capacity = count_lines(corpus->kanaText);
+    }
+    corpus->words = (CorpusWord*) malloc((capacity + 1) * sizeof(CorpusWord));
+    if(corpus->words == NULL){
+        printf("文字列を保存するメモリの確保に失敗しました\n");
+        corpus_free(corpus);
+        return -1;
+    }
+
+    originCursor = corpus->originText;
+    kanaCursor = corpus->kanaText;
+    while(1){
+        originLine = next_line(&originCursor);
+        kanaLine = next_line(&kanaCursor);
+        lineNum++;
+        if(originLine == NULL && kanaLine == NULL){ // 両方のファイルを読み終えた時
+            break;
+        }
+        if((originLine == NULL || originLine[0] == '\0') && (kanaLine == NULL || kanaLine[0] == '\0')){
+            continue; // 空の行は読み飛ばす
+        }
+        if(originLine == NULL || originLine[0] == '\0' || kanaLine == NULL || kanaLine[0] == '\0'){
+            printf("string.txtとstring_kana.txtの%d行目が対応していません\n", lineNum);
+            corpus_free(corpus);
+            return -1;
+        }
+        codeLen = romaji_decode_kana(kanaLine, code);
+        if(codeLen == 0 || codeLen * 3 < (int)strlen(kanaLine)){ // 仮名は全て3バイトなので、途中で変換が止まった時は足りない
+            printf("string_kana.txtの%d行目「%s」に打てない文字があるか長すぎるので、読み飛ばします\n", lineNum, kanaLine);
+            continue;
+        }
+        inputMax = romaji_input_max(code, codeLen);
+        if(inputMax < 0 || inputMax > ROMAJI_INPUT_MAX){
+            printf("string_kana.txtの%d行目「%s」はローマ字で%d文字より長くなるので、読み飛ばします\n", lineNum, kanaLine, ROMAJI_INPUT_MAX);
+            continue;
+        }
+        corpus->words[corpus->wordNum].origin = originLine;
+        corpus->words[corpus->wordNum].kana = kanaLine;
+        corpus->words[corpus->wordNum].code = NULL;
+        corpus->words[corpus->wordNum].codeLen = 0;
+        corpus->wordNum++;
+    }
+
+    if(corpus->wordNum == 0){
+        printf("string.txtに文字列がありません\n");
+        corpus_free(corpus);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 指定した番号の文字列を取り出す
+ * イメージから読み込んだ時は、その文字列の部分だけを確認して返す
+ * 仮名の番号も最初の状態の表で引ける範囲にあるかをここで確かめるので、読み込みの時に全ての番号を読む必要はない
+ *
+ * @param corpus 読み込んだ文字列を保存する構造体
+ * @param index 文字列の番号
+ * @param word 取り出した文字列を保存する構造体
+ *
+ * @return 0:成功 -1:失敗
+ */
+int corpus_get_word(const Corpus *corpus, int index, CorpusWord *word){
+    const CorpusImageHeader *header; // イメージのヘッダ
+    const CorpusImageWord *imageWord; // イメージの中の文字列
+    const char *base; // イメージの先頭
+    const unsigned char *code; // 文字列の仮名の番号
+
+    if(index < 0 || index >= corpus->wordNum){
+        return -1;
+    }
+    if(corpus->image == NULL){
+        *word = corpus->words[index];
+        return 0;
+    }
+
+    base = (const char*)corpus->image;
+    header = (const CorpusImageHeader*)base;
+    imageWord = (const CorpusImageWord*)(base + header->wordOffset) + index;
+    if(imageWord->origin >= header->textSize || imageWord->kana >= header->textSize ||
+       imageWord->codeLen == 0 || imageWord->codeLen > KANA_LEN_MAX || imageWord->code > header->codeSize ||
+       imageWord->codeLen > header->codeSize - imageWord->code){
+        return -1;
+    }
+    code = (const unsigned char*)(base + header->codeOffset + imageWord->code);
+    for(uint32_t i = 0; i < imageWord->codeLen; i++){
+        if(code[i] >= JPN_CHAR_NUM){
+            return -1;
+        }
+    }
+    word->origin = base + header->textOffset + imageWord->origin;
+    word->kana = base + header->textOffset + imageWord->kana;
+    word->code = code;
+    word->codeLen = (int)imageWord->codeLen;
+    return 0;
+}
+
+/**
+ * 文字列の仮名と入力判定の表のチェックサムを計算する (FNV-1a)
+ * 記録を再生する時に、記録した時と同じ文字列と表かを確かめるのに使う
+ * テキストファイルから読み込んだ文字列は、仮名をその場で文字の番号に変換して計算するので、
+ * 同じファイルから作ったイメージと同じ値になる
+ * 入力判定の表は romaji_init か romaji_attach で用意しておく必要がある
+ *
+ * @param corpus 読み込んだ文字列
+ *
+ * @return チェックサム
+ */
+unsigned int corpus_checksum(const Corpus *corpus){
+    unsigned int hash = 2166136261u; // ハッシュ値
+    unsigned char codeBuf[KANA_LEN_MAX]; // 変換した仮名の番号
+    CorpusWord word; // 取り出した文字列
+
+    for(int i = 0; i < corpus->wordNum; i++){
+        if(corpus_get_word(corpus, i, &word) != 0){ // イメージの中で壊れている文字列は、落とさないので区切りだけ数える
+            hash = (hash ^ 0xffu) * 16777619u;
+            continue;
+        }
+        if(word.code == NULL){
+            word.codeLen = romaji_decode_kana(word.kana, codeBuf);
+            word.code = codeBuf;
+        }
+        for(int j = 0; j < word.codeLen; j++){
+            hash = (hash ^ word.code[j]) * 16777619u;
+        }
+        hash = (hash ^ 0xffu) * 16777619u; // 文字列の区切り
+    }
+    return romaji_table_checksum(hash);
+}
+
+/**
+ * 読み込んだ文字列を解放する
+ *
+ * @param corpus 読み込んだ文字列を保存する構造体
+ */
+void corpus_free(Corpus *corpus){
+    if(corpus->image != NULL){
+        munmap((void*)corpus->image, corpus->imageSize);
+    }
+    free(corpus->originText);
+    free(corpus->kanaText);
+    free(corpus->words);
+    memset(corpus, 0, sizeof(Corpus));
+}
+
+/**
+ * ファイルの内容を全て読み込み、終端文字をつけて返す
+ * 先頭にBOMがあった時は取り除く
+ *
+ * @param path ファイルのパス
+ *
+ * @return 読み込んだ内容 失敗した時はNULL
+ */
+static char *read_text(const char *path){
+    FILE *fp; // ファイルのポインタ
+    long size; // ファイルの大きさ
+    char *text; // 読み込んだ内容
+
+    if((fp = fopen(path, "rb")) == NULL){
+        return NULL;
+    }
+    if(fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET) != 0){
+        fclose(fp);
+        return NULL;
+    }
+    text = (char*) malloc((size_t)size + 1);
+    if(text == NULL || fread(text, 1, (size_t)size, fp) != (size_t)size){
+        free(text);
+        fclose(fp);
+        return NULL;
+    }
+    fclose(fp);
+    text[size] = '\0';
+
+    if(size >= 3 && memcmp(text, "\xEF\xBB\xBF", 3) == 0){
+        memmove(text, text + 3, (size_t)size - 2);
+    }
+    return text;
+}
+
+/**
+ * 行の数を数える
+ *
+ * @param text 数える内容
+ *
+ * @return 行の数
+ */
+static int count_lines(const char *text){
+    int num = 0; // 行の数
+
+    for(const char *p = text; *p != '\0'; p++){
+        if(*p == '\n')num++;
+    }
+    if(text[0] != '\0' && text[strlen(text) - 1] != '\n'){ // 最後の行に改行がない時
+        num++;
+    }
+    return num;
+}
+
+/**
+ * 次の行を取り出す
+ * 行末の改行を終端文字に置き換え、その行の先頭を返す
+ *
+ * @param text 読み込み中の位置 取り出した行の次の行の先頭に進める
+ *
+ * @return 行の先頭 読み終えていた時はNULL
+ */
+static char *next_line(char **text){
+    char *line = *text; // 取り出す行
+    char *end; // 行末の位置
+
+    if(line == NULL || *line == '\0'){
+        return NULL;
+    }
+    end = strchr(line, '\n');
+    if(end == NULL){
+        *text = line + strlen(line);
+    }else{
+        *end = '\0';
+        *text = end + 1;
+    }
+    // Windowsの改行の \r を取り除く
+    size_t len = strlen(line);
+    if(len > 0 && line[len - 1] == '\r'){
+        line[len - 1] = '\0';
+    }
+    return line;
+}
@@ -0,0 +1,37 @@
+/*
+ * 落とす文字列とその仮名を読み込む処理
+ * ファイルの内容をそのまま一つの領域に読み込み、行末を終端文字に置き換えて各行を指す。
+ * corpus-compile で作ったイメージから読み込んだ時は、イメージの中を直接指す。
+ */
+
+#ifndef FALLTYPING_CORPUS_H
+#define FALLTYPING_CORPUS_H
+
+#include <stddef.h>
+
+/* ------ 構造体の宣言 ------*/
+// 一つの文字列とその仮名
+typedef struct{
+    const char *origin; // 落とす文字列
+    const char *kana;   // 落とす文字列の仮名
+    const unsigned char *code; // 仮名ごとの文字の番号 (NULLの時はまだ変換していない)
+    int codeLen;        // 仮名の数
+}CorpusWord;
+
+// 読み込んだ文字列の一覧
+typedef struct{
+    char *originText;  // string.txt の内容を保存する領域
+    char *kanaText;    // string_kana.txt の内容を保存する領域
+    CorpusWord *words; // 文字列の配列
+    int wordNum;       // 文字列の数
+    const void *image; // mmap したイメージ (NULLの時はテキストファイルから読み込んだ)
+    size_t imageSize;  // イメージの大きさ
+}Corpus;
+
+/* ------ プロトタイプ宣言 ------ */
+int corpus_load(Corpus *corpus, const char *originPath, const char *kanaPath); // 文字列とその仮名をファイルから読み込む
+int corpus_get_word(const Corpus *corpus, int index, CorpusWord *word); // 指定した番号の文字列を取り出す
+unsigned int corpus_checksum(const Corpus *corpus); // 文字列の仮名と入力判定の表のチェックサムを計算する
+void corpus_free(Corpus *corpus); // 読み込んだ文字列を解放する
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * corpus-compile
+ * string.txt、string_kana.txt、youon.txt から、ゲームが起動時に mmap するイメージを作るツール
+ *
+ * 使い方
+ *   corpus-compile [string.txt string_kana.txt youon.txt corpus.bin]
+ * 引数を省略した時は、今のディレクトリのファイルから corpus.bin を作る。
+ * ゲームは main.c と同じく ./../corpus.bin を探し、なければテキストファイルを読み込む。
+ *
+ * コンパイル
+ *   cc -o corpus-compile corpus_compile.c corpus_image.c corpus.c romaji.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "romaji.h"
+#include "corpus.h"
+#include "corpus_image.h"
+
+/* ------ グローバル変数の宣言 ------*/
+// 拗音がくるパターンを保存する二次元配列
+int youon[KANA_NUM][SMALL_KANA_NUM];
+
+/* ---------------------- */
+/* ------ メイン処理 ------ */
+/* ---------------------- */
+int main(int argc, char *argv[]) {
+    const char *stringPath = "string.txt"; // 落とす文字列のあるファイルのパス
+    const char *stringKanaPath = "string_kana.txt"; // 落とす文字列の仮名のあるファイルのパス
+    const char *youonPath = "youon.txt"; // 拗音がくるパターンのあるファイルのパス
+    const char *imagePath = "corpus.bin"; // 書き出すイメージのパス
+    FILE *fpInYouon; // 拗音がくるパターンのあるファイル用のポインタ
+    Corpus corpus; // 読み込んだ文字列
+
+    if(argc == 5){
+        stringPath = argv[1];
+        stringKanaPath = argv[2];
+        youonPath = argv[3];
+        imagePath = argv[4];
+    }else if(argc != 1){
+        printf("使い方: %s [string.txt string_kana.txt youon.txt corpus.bin]\n", argv[0]);
+        return 1;
+    }
+
+    // 拗音のパターンをファイルから取得して、入力判定の表を作る
+    if((fpInYouon = fopen(youonPath,"r")) == NULL){
+        printf("ファイルのオープンに失敗しました\nyouon.txtがあるかを確認してください\n");
+        return 1;
+    }
+    for(int i = 0; i < KANA_NUM; i++){
+        for(int j = 0; j < SMALL_KANA_NUM; j++){
+            if(fscanf(fpInYouon,"%d", &youon[i][j]) != 1){
+                printf("youon.txtの形式が正しくありません\n");
+                fclose(fpInYouon);
+                return 1;
+            }
+        }
+    }
+    fclose(fpInYouon);
+    if(romaji_init(youon) != 0){
+        printf("入力判定の表の作成に失敗しました\n");
+        return 1;
+    }
+
+    // 落とす文字列とその仮名を読み込んで、イメージに書き出す
+    if(corpus_load(&corpus, stringPath, stringKanaPath) != 0){
+        romaji_free();
+        return 1;
+    }
+    if(corpus_image_write(imagePath, &corpus) != 0){
+        corpus_free(&corpus);
+        romaji_free();
+        return 1;
+    }
+    printf("%sを作成しました (文字列: %d 状態: %d)\n", imagePath, corpus.wordNum, romajiTable.nodeNum);
+
+    corpus_free(&corpus);
+    romaji_free();
+    return 0;
+}
@@ -0,0 +1,327 @@
+/*
+ * 文字列と入力判定の表をまとめたイメージの書き出しと読み込み
+ *
+ * 書き出しは corpus-compile から、読み込みはゲームの起動時に行う。
+ * 読み込みはイメージを読み込み専用で mmap し、ヘッダと入力判定の表の範囲だけを確かめる。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "corpus_image.h"
+
+/* ------ 構造体の宣言 ------*/
+// 書き出す内容を貯めておく領域
+typedef struct{
+    char *data;      // 貯めた内容
+    size_t size;     // 貯めた大きさ
+    size_t capacity; // 確保した大きさ
+}ImageBuffer;
+
+/* ------ プロトタイプ宣言 ------ */
+static long buffer_append(ImageBuffer *buffer, const void *data, size_t size); // 領域の最後に内容を追加する
+static long intern_string(ImageBuffer *text, uint32_t *slots, size_t slotNum, const char *str); // 同じ文字列を一つにまとめて追加する
+static size_t align_size(size_t size); // 領域の大きさをそろえる
+static int write_region(FILE *fp, const void *data, size_t size); // 領域を書き出し、そろえるための0を足す
+static int check_region(const CorpusImageHeader *header, uint32_t offset, size_t size); // 領域がイメージに収まるかを確かめる
+static int check_tables(const char *image, const CorpusImageHeader *header); // 入力判定の表を確かめる
+
+/**
+ * 読み込んだ文字列と入力判定の表をイメージに書き出す
+ * 入力判定の表は romaji_init で作っておく必要がある
+ *
+ * @param path 書き出すファイルのパス
+ * @param corpus テキストファイルから読み込んだ文字列
+ *
+ * @return 0:成功 -1:失敗
+ */
+int corpus_image_write(const char *path, const Corpus *corpus){
+    CorpusImageHeader header; // イメージのヘッダ
+    CorpusImageWord *words; // イメージの中の文字列の表
+    ImageBuffer text = {NULL, 0, 0}; // 文字列の本体
+    ImageBuffer code = {NULL, 0, 0}; // 仮名の番号
+    uint32_t *slots; // 同じ文字列を探すためのハッシュ表
+    size_t slotNum = 16; // ハッシュ表の大きさ
+    unsigned char wordCode[KANA_LEN_MAX]; // 一つの文字列の仮名の番号
+    CorpusWord word; // 書き出す文字列
+    long offset; // 追加した位置
+    FILE *fp; // 書き出すファイルのポインタ
+    int result = -1; // 結果
+
+    while(slotNum < (size_t)corpus->wordNum * 4)slotNum *= 2;
+    words = (CorpusImageWord*) calloc(corpus->wordNum, sizeof(CorpusImageWord));
+    slots = (uint32_t*) calloc(slotNum, sizeof(uint32_t));
+    if(words == NULL || slots == NULL){
+        printf("イメージを作るメモリの確保に失敗しました\n");
+        goto cleanup;
+    }
+
+    for(int i = 0; i < corpus->wordNum; i++){
+        corpus_get_word(corpus, i, &word);
+        int codeLen = romaji_decode_kana(word.kana, wordCode); // 仮名の数
+        if(codeLen * 3 < (int)strlen(word.kana)){
+            printf("%d番目の文字列「%s」の読みに対応していない文字があります\n", i + 1, word.origin);
+        }
+        if((offset = intern_string(&text, slots, slotNum, word.origin)) < 0)goto cleanup;
+        words[i].origin = (uint32_t)offset;
+        if((offset = intern_string(&text, slots, slotNum, word.kana)) < 0)goto cleanup;
+        words[i].kana = (uint32_t)offset;
+        if((offset = buffer_append(&code, wordCode, (size_t)codeLen)) < 0)goto cleanup;
+        words[i].code = (uint32_t)offset;
+        words[i].codeLen = (uint32_t)codeLen;
+    }
+
+    // 各領域の位置を決める
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CORPUS_IMAGE_MAGIC, sizeof(header.magic));
+    header.version = CORPUS_IMAGE_VERSION;
+    header.byteOrder = CORPUS_IMAGE_BYTE_ORDER;
+    header.nodeSize = sizeof(RomajiNode);
+    header.rootNum = ROMAJI_ROOT_NUM;
+    header.wordNum = (uint32_t)corpus->wordNum;
+    header.nodeNum = (uint32_t)romajiTable.nodeNum;
+    header.wordOffset = (uint32_t)align_size(sizeof(header));
+    header.nodeOffset = (uint32_t)(header.wordOffset + align_size(sizeof(CorpusImageWord) * header.wordNum));
+    header.rootOffset = (uint32_t)(header.nodeOffset + align_size(sizeof(RomajiNode) * header.nodeNum));
+    header.codeOffset = (uint32_t)(header.rootOffset + align_size(sizeof(unsigned short) * ROMAJI_ROOT_NUM));
+    header.codeSize = (uint32_t)code.size;
+    header.textOffset = (uint32_t)(header.codeOffset + align_size(code.size));
+    header.textSize = (uint32_t)text.size;
+    header.fileSize = (uint32_t)(header.textOffset + align_size(text.size));
+    if((size_t)header.textOffset + align_size(text.size) > UINT32_MAX){
+        printf("文字列が多すぎてイメージに収まりません\n");
+        goto cleanup;
+    }
+
+    if((fp = fopen(path, "wb")) == NULL){
+        printf("ファイルのオープンに失敗しました\n%sに書き込めるかを確認してください\n", path);
+        goto cleanup;
+    }
+    if(write_region(fp, &header, sizeof(header)) == 0 &&
+       write_region(fp, words, sizeof(CorpusImageWord) * header.wordNum) == 0 &&
+       write_region(fp, romajiTable.nodes, sizeof(RomajiNode) * header.nodeNum) == 0 &&
+       write_region(fp, romajiTable.root, sizeof(unsigned short) * ROMAJI_ROOT_NUM) == 0 &&
+       write_region(fp, code.data, code.size) == 0 &&
+       write_region(fp, text.data, text.size) == 0){
+        result = 0;
+    }
+    if(fclose(fp) != 0 || result != 0){
+        printf("%sへの書き込みに失敗しました\n", path);
+        result = -1;
+    }
+
+cleanup:
+    free(words);
+    free(slots);
+    free(text.data);
+    free(code.data);
+    return result;
+}
+
+/**
+ * イメージを読み込み専用で mmap して、文字列と入力判定の表を使えるようにする
+ *
+ * @param corpus 読み込んだ文字列を保存する構造体
+ * @param path イメージのパス
+ *
+ * @return 0:成功 -1:イメージがない -2:イメージが壊れているか、使う準備に失敗した
+ */
+int corpus_image_load(Corpus *corpus, const char *path){
+    const CorpusImageHeader *header; // イメージのヘッダ
+    struct stat fileStat; // ファイルの情報
+    void *image; // mmap したイメージ
+    int fd; // ファイルディスクリプタ
+
+    if((fd = open(path, O_RDONLY)) < 0){
+        return -1;
+    }
+    if(fstat(fd, &fileStat) != 0 || fileStat.st_size < (off_t)sizeof(CorpusImageHeader)){
+        close(fd);
+        printf("%sが壊れているか、形式が違います\n", path);
+        return -2;
+    }
+    image = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(image == MAP_FAILED){
+        printf("%sの読み込みに失敗しました\n", path);
+        return -2;
+    }
+
+    header = (const CorpusImageHeader*)image;
+    if(memcmp(header->magic, CORPUS_IMAGE_MAGIC, sizeof(header->magic)) != 0 ||
+       header->version != CORPUS_IMAGE_VERSION ||
+       header->byteOrder != CORPUS_IMAGE_BYTE_ORDER ||
+       header->nodeSize != sizeof(RomajiNode) ||
+       header->rootNum != ROMAJI_ROOT_NUM ||
+       header->fileSize != (uint32_t)fileStat.st_size ||
+       header->wordNum == 0 || header->wordNum > 0x7fffffffu ||
+       header->nodeNum < 2 || header->nodeNum > 65535 ||
+       check_region(header, header->wordOffset, sizeof(CorpusImageWord) * (size_t)header->wordNum) != 0 ||
+       check_region(header, header->nodeOffset, sizeof(RomajiNode) * (size_t)header->nodeNum) != 0 ||
+       check_region(header, header->rootOffset, sizeof(unsigned short) * (size_t)ROMAJI_ROOT_NUM) != 0 ||
+       check_region(header, header->codeOffset, header->codeSize) != 0 ||
+       check_region(header, header->textOffset, header->textSize) != 0 ||
+       header->textSize == 0 || ((const char*)image)[header->textOffset + header->textSize - 1] != '\0' ||
+       check_tables((const char*)image, header) != 0){
+        munmap(image, (size_t)fileStat.st_size);
+        printf("%sが壊れているか、形式が違います\ncorpus-compileで作り直してください\n", path);
+        return -2;
+    }
+
+    if(romaji_attach((const RomajiNode*)((const char*)image + header->nodeOffset), (int)header->nodeNum,
+                     (const unsigned short*)((const char*)image + header->rootOffset)) != 0){
+        munmap(image, (size_t)fileStat.st_size);
+        printf("%sの入力判定の表の準備に失敗しました\n", path);
+        return -2;
+    }
+    memset(corpus, 0, sizeof(Corpus));
+    corpus->image = image;
+    corpus->imageSize = (size_t)fileStat.st_size;
+    corpus->wordNum = (int)header->wordNum;
+    return 0;
+}
+
+/**
+ * 領域の最後に内容を追加する
+ *
+ * @param buffer 追加する領域
+ * @param data 追加する内容
+ * @param size 追加する大きさ
+ *
+ * @return 追加した位置 失敗した時は-1
+ */
+static long buffer_append(ImageBuffer *buffer, const void *data, size_t size){
+    size_t offset = buffer->size; // 追加した位置
+
+    if(buffer->size + size > buffer->capacity){
+        size_t capacity = buffer->capacity == 0 ? 4096 : buffer->capacity; // 新しく確保する大きさ
+        while(capacity < buffer->size + size)capacity *= 2;
+        char *newData = (char*) realloc(buffer->data, capacity);
+        if(newData == NULL){
+            printf("イメージを作るメモリの確保に失敗しました\n");
+            return -1;
+        }
+        buffer->data = newData;
+        buffer->capacity = capacity;
+    }
+    if(size > 0){
+        memcpy(buffer->data + buffer->size, data, size);
+    }
+    buffer->size += size;
+    return (long)offset;
+}
+
+/**
+ * 文字列を本体に追加する
+ * すでに同じ文字列がある時は、その位置を返す
+ *
+ * @param text 文字列の本体
+ * @param slots 追加した位置+1を保存するハッシュ表
+ * @param slotNum ハッシュ表の大きさ (2の累乗)
+ * @param str 追加する文字列
+ *
+ * @return 文字列の位置 失敗した時は-1
+ */
+static long intern_string(ImageBuffer *text, uint32_t *slots, size_t slotNum, const char *str){
+    uint32_t hash = 2166136261u; // ハッシュ値
+    long offset; // 追加した位置
+
+    for(const char *p = str; *p != '\0'; p++){
+        hash = (hash ^ (unsigned char)*p) * 16777619u;
+    }
+    hash &= (uint32_t)(slotNum - 1);
+    while(slots[hash] != 0){
+        if(strcmp(text->data + slots[hash] - 1, str) == 0){
+            return (long)slots[hash] - 1;
+        }
+        hash = (hash + 1) & (uint32_t)(slotNum - 1);
+    }
+    if((offset = buffer_append(text, str, strlen(str) + 1)) < 0){
+        return -1;
+    }
+    slots[hash] = (uint32_t)offset + 1;
+    return offset;
+}
+
+/**
+ * 領域の大きさを CORPUS_IMAGE_ALIGN の倍数にそろえる
+ *
+ * @param size 領域の大きさ
+ *
+ * @return そろえた大きさ
+ */
+static size_t align_size(size_t size){
+    return (size + CORPUS_IMAGE_ALIGN - 1) / CORPUS_IMAGE_ALIGN * CORPUS_IMAGE_ALIGN;
+}
+
+/**
+ * 領域を書き出し、大きさをそろえるための0を足す
+ *
+ * @param fp 書き出すファイルのポインタ
+ * @param data 書き出す内容
+ * @param size 書き出す大きさ
+ *
+ * @return 0:成功 -1:失敗
+ */
+static int write_region(FILE *fp, const void *data, size_t size){
+    static const char zero[CORPUS_IMAGE_ALIGN] = {0}; // そろえるための0
+
+    if(size > 0 && fwrite(data, 1, size, fp) != size){
+        return -1;
+    }
+    if(align_size(size) > size && fwrite(zero, 1, align_size(size) - size, fp) != align_size(size) - size){
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 領域がイメージに収まっていて、先頭がそろっているかを確かめる
+ *
+ * @param header イメージのヘッダ
+ * @param offset 領域の位置
+ * @param size 領域の大きさ
+ *
+ * @return 0:正しい -1:正しくない
+ */
+static int check_region(const CorpusImageHeader *header, uint32_t offset, size_t size){
+    if(offset % CORPUS_IMAGE_ALIGN != 0 || offset < sizeof(CorpusImageHeader) ||
+       offset > header->fileSize || size > header->fileSize - offset){
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 入力判定の表の遷移先が全て表の中にあるかを確かめる
+ *
+ * @param image イメージの先頭
+ * @param header イメージのヘッダ
+ *
+ * @return 0:正しい -1:正しくない
+ */
+static int check_tables(const char *image, const CorpusImageHeader *header){
+    const RomajiNode *nodes = (const RomajiNode*)(image + header->nodeOffset); // 状態の配列
+    const unsigned short *root = (const unsigned short*)(image + header->rootOffset); // 最初の状態の表
+
+    for(uint32_t i = 0; i < header->nodeNum; i++){
+        if(memchr(nodes[i].rest, '\0', ROMAJI_PATTERN_LEN) == NULL || nodes[i].accept > 2 || nodes[i].restAccept > 2){
+            return -1;
+        }
+        for(int j = 0; j < ROMAJI_CHAR_NUM; j++){
+            if(nodes[i].next[j] >= header->nodeNum){
+                return -1;
+            }
+        }
+    }
+    for(int i = 0; i < ROMAJI_ROOT_NUM; i++){
+        if(root[i] == 0 || root[i] >= header->nodeNum){
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,52 @@
+/*
+ * corpus-compile で作る、文字列と入力判定の表をまとめたイメージの形式
+ *
+ * イメージはヘッダ、文字列の表、入力判定の状態、最初の状態の表、仮名の番号、文字列の本体の順に並び、
+ * 位置は全てイメージの先頭からのバイト数で表す。ゲームは mmap するだけで、解析はしない。
+ */
+
+#ifndef FALLTYPING_CORPUS_IMAGE_H
+#define FALLTYPING_CORPUS_IMAGE_H
+
+#include <stdint.h>
+#include "corpus.h"
+#include "romaji.h"
+
+#define CORPUS_IMAGE_MAGIC "FTCORPUS"      // イメージの先頭の8バイト
+#define CORPUS_IMAGE_VERSION 1              // イメージの形式の版
+#define CORPUS_IMAGE_BYTE_ORDER 0x01020304u // バイト順を確かめるための値
+#define CORPUS_IMAGE_ALIGN 8                // 各領域の先頭をそろえるバイト数
+
+/* ------ 構造体の宣言 ------*/
+// イメージのヘッダ
+typedef struct{
+    char magic[8];       // CORPUS_IMAGE_MAGIC
+    uint32_t version;    // CORPUS_IMAGE_VERSION
+    uint32_t byteOrder;  // CORPUS_IMAGE_BYTE_ORDER
+    uint32_t nodeSize;   // sizeof(RomajiNode)
+    uint32_t rootNum;    // ROMAJI_ROOT_NUM
+    uint32_t wordNum;    // 文字列の数
+    uint32_t nodeNum;    // 入力判定の状態の数
+    uint32_t wordOffset; // 文字列の表の位置
+    uint32_t nodeOffset; // 入力判定の状態の位置
+    uint32_t rootOffset; // 最初の状態の表の位置
+    uint32_t codeOffset; // 仮名の番号の位置
+    uint32_t codeSize;   // 仮名の番号の大きさ
+    uint32_t textOffset; // 文字列の本体の位置
+    uint32_t textSize;   // 文字列の本体の大きさ
+    uint32_t fileSize;   // イメージ全体の大きさ
+}CorpusImageHeader;
+
+// イメージの中の一つの文字列
+typedef struct{
+    uint32_t origin;  // 落とす文字列の文字列の本体の中での位置
+    uint32_t kana;    // 仮名の文字列の本体の中での位置
+    uint32_t code;    // 仮名の番号の中での位置
+    uint32_t codeLen; // 仮名の数
+}CorpusImageWord;
+
+/* ------ プロトタイプ宣言 ------ */
+int corpus_image_write(const char *path, const Corpus *corpus); // 読み込んだ文字列と入力判定の表をイメージに書き出す
+int corpus_image_load(Corpus *corpus, const char *path); // イメージを mmap して文字列と入力判定の表を使えるようにする
+
+#endif
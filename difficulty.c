@@ -0,0 +1,93 @@
+/*
+ * 遊んでいる人の入力の速さに合わせた難易度の調整
+ */
+
+#include "difficulty.h"
+
+#define KEYS_PER_WORD_FIRST 6.0 // 入力し終えた文字列がまだない時の、一つの文字列のキー入力の数の見積もり
+#define KEYS_PER_WORD_RATE 0.25 // 入力し終えた文字列のキー入力の数を平均に反映する割合
+
+/**
+ * 難易度ごとの値から調整を始める
+ * 最初は難易度ごとの間隔で入力し終えられると見積もるので、調整を始めた時の値は難易度ごとの値と同じになる
+ *
+ * @param difficulty 難易度の調整の状態
+ * @param baseSpeed 難易度ごとの落下速度
+ * @param baseInterval 難易度ごとの文字列を落とす間隔 (秒)
+ */
+void difficulty_init(Difficulty *difficulty, double baseSpeed, double baseInterval){
+    difficulty->baseSpeed = baseSpeed;
+    difficulty->baseInterval = baseInterval;
+    difficulty->factor = 1.0;
+    difficulty->keysPerWord = KEYS_PER_WORD_FIRST;
+    difficulty->kps = KEYS_PER_WORD_FIRST / baseInterval;
+    difficulty->occupancy = DIFFICULTY_TARGET;
+    difficulty->stepKeyNum = 0;
+}
+
+/**
+ * 正しいキー入力を一つ数える
+ *
+ * @param difficulty 難易度の調整の状態
+ */
+void difficulty_key(Difficulty *difficulty){
+    difficulty->stepKeyNum++;
+}
+
+/**
+ * 入力し終えた文字列のキー入力の数を数える
+ *
+ * @param difficulty 難易度の調整の状態
+ * @param keyNum 文字列を入力するのに使った正しいキー入力の数
+ */
+void difficulty_complete(Difficulty *difficulty, int keyNum){
+    difficulty->keysPerWord += KEYS_PER_WORD_RATE * (keyNum - difficulty->keysPerWord);
+}
+
+/**
+ * 落下を一回進めるごとに、入力の速さと画面の混み具合を平均に反映して、落下速度と落とす間隔を決め直す
+ * 混み具合は、落ちている文字列を今の入力の速さで全て打つのにかかる時間を、
+ * 一番下の文字列が終了の線に当たるまでの時間で割ったもの (1を超えると間に合わない) とする
+ *
+ * @param difficulty 難易度の調整の状態
+ * @param keyNum 落ちている文字列の残りのキー入力の数
+ * @param distance 一番下の文字列の終了の線までの距離 (文字列がない時は0)
+ * @param dt 落下を一回進める時間 (秒)
+ * @param fallSpeed 今の落下速度 調整した落下速度をここに保存する
+ * @param fallInterval 調整した文字列を落とす間隔 (秒) を保存する変数
+ */
+void difficulty_update(Difficulty *difficulty, int keyNum, double distance, double dt,
+                       double *fallSpeed, double *fallInterval){
+    double rate = dt / DIFFICULTY_AVERAGE_SEC; // 新しい値を平均に反映する割合
+    double occupancy = 0; // 今の混み具合
+    double wordsPerSec; // 1秒に入力し終えられる文字列の数の見積もり
+    double skill; // 入力し終えられる速さが難易度ごとの落とす速さの何倍か
+    double interval; // 文字列を落とす間隔
+
+    difficulty->kps += rate * (difficulty->stepKeyNum / dt - difficulty->kps);
+    difficulty->stepKeyNum = 0;
+    wordsPerSec = difficulty->kps / difficulty->keysPerWord;
+    if(keyNum > 0){
+        occupancy = distance > 0 ? keyNum / (difficulty->kps > DIFFICULTY_KPS_MIN ? difficulty->kps : DIFFICULTY_KPS_MIN)
+                                   / (distance / *fallSpeed) : DIFFICULTY_OCCUPANCY_MAX;
+        if(occupancy > DIFFICULTY_OCCUPANCY_MAX)occupancy = DIFFICULTY_OCCUPANCY_MAX;
+    }
+    difficulty->occupancy += dt / DIFFICULTY_OCCUPANCY_SEC * (occupancy - difficulty->occupancy);
+
+    // 混み具合が目標より少ない時は倍率を上げ、多い時は下げる (dt が小さいので exp を1次の式で近似する)
+    difficulty->factor *= 1.0 + DIFFICULTY_GAIN * (DIFFICULTY_TARGET - difficulty->occupancy) * dt;
+    if(difficulty->factor < DIFFICULTY_FACTOR_MIN)difficulty->factor = DIFFICULTY_FACTOR_MIN;
+    if(difficulty->factor > DIFFICULTY_FACTOR_MAX)difficulty->factor = DIFFICULTY_FACTOR_MAX;
+
+    // 入力し終えられる速さに倍率を掛けた速さで文字列を落とす
+    interval = wordsPerSec > 0 ? 1.0 / (wordsPerSec * difficulty->factor) : DIFFICULTY_INTERVAL_MAX;
+    if(interval < DIFFICULTY_INTERVAL_MIN)interval = DIFFICULTY_INTERVAL_MIN;
+    if(interval > DIFFICULTY_INTERVAL_MAX)interval = DIFFICULTY_INTERVAL_MAX;
+    *fallInterval = interval;
+
+    // 落下速度は入力し終えられる速さに合わせる
+    skill = wordsPerSec * difficulty->baseInterval;
+    if(skill < DIFFICULTY_SPEED_MIN)skill = DIFFICULTY_SPEED_MIN;
+    if(skill > DIFFICULTY_SPEED_MAX)skill = DIFFICULTY_SPEED_MAX;
+    *fallSpeed = difficulty->baseSpeed * skill;
+}
@@ -0,0 +1,49 @@
+/*
+ * 遊んでいる人の入力の速さに合わせて、落下速度と文字列を落とす間隔を変え続ける難易度の調整
+ *
+ * 落ちている文字列を今の入力の速さで全て打つのにかかる時間と、一番下の文字列が終了の線に当たるまでの時間の比
+ * (画面の混み具合) を目標の値に保つように調整する。
+ *   - 直近の1秒あたりの正しいキー入力の数と、一つの文字列を入力するのに必要なキー入力の数から、
+ *     1秒に入力し終えられる文字列の数を見積もり、それに倍率を掛けた速さで文字列を落とす
+ *   - 混み具合が目標より少なければ倍率を上げ、多ければ下げる
+ *   - 落下速度は、入力し終えられる速さが難易度ごとの落とす速さの何倍かに合わせる
+ * どれも文字列の落下を進めるたびに、前の値を少しずつ新しい値に近づける (指数移動平均) だけなので、
+ * 一回の調整は落下を進める間隔によらず一定の時間で終わる。
+ */
+
+#ifndef FALLTYPING_DIFFICULTY_H
+#define FALLTYPING_DIFFICULTY_H
+
+#define DIFFICULTY_TARGET 0.5        // 目標の画面の混み具合 (0 : 空 1 : ぎりぎり間に合う)
+#define DIFFICULTY_OCCUPANCY_MAX 2.0 // 混み具合の上限
+#define DIFFICULTY_KPS_MIN 1.0       // 混み具合の計算に使う入力の速さの最小
+#define DIFFICULTY_AVERAGE_SEC 5.0   // 入力の速さを平均する時間 (秒)
+#define DIFFICULTY_OCCUPANCY_SEC 1.0 // 混み具合を平均する時間 (秒)
+#define DIFFICULTY_GAIN 0.2          // 混み具合の差1が続いた時に、1秒で倍率を変える割合
+#define DIFFICULTY_FACTOR_MIN 0.5    // 倍率の最小
+#define DIFFICULTY_FACTOR_MAX 2.0    // 倍率の最大
+#define DIFFICULTY_SPEED_MIN 0.5     // 難易度ごとの落下速度に掛ける値の最小
+#define DIFFICULTY_SPEED_MAX 4.0     // 難易度ごとの落下速度に掛ける値の最大
+#define DIFFICULTY_INTERVAL_MIN 0.25 // 文字列を落とす間隔の最小 (秒)
+#define DIFFICULTY_INTERVAL_MAX 4.0  // 文字列を落とす間隔の最大 (秒)
+
+/* ------ 構造体の宣言 ------*/
+// 難易度の調整の状態
+typedef struct{
+    double baseSpeed;    // 難易度ごとの落下速度
+    double baseInterval; // 難易度ごとの文字列を落とす間隔 (秒)
+    double factor;       // 入力し終えられる速さに掛けて、文字列を落とす速さにする倍率
+    double kps;          // 直近の1秒あたりの正しいキー入力の数
+    double keysPerWord;  // 直近の一つの文字列を入力するのに必要なキー入力の数
+    double occupancy;    // 直近の画面の混み具合 (0 : 空 1 : ぎりぎり間に合う)
+    int stepKeyNum;      // 前の調整から後の正しいキー入力の数
+}Difficulty;
+
+/* ------ プロトタイプ宣言 ------ */
+void difficulty_init(Difficulty *difficulty, double baseSpeed, double baseInterval); // 難易度ごとの値から調整を始める
+void difficulty_key(Difficulty *difficulty); // 正しいキー入力を一つ数える
+void difficulty_complete(Difficulty *difficulty, int keyNum); // 入力し終えた文字列のキー入力の数を数える
+void difficulty_update(Difficulty *difficulty, int keyNum, double distance, double dt,
+                       double *fallSpeed, double *fallInterval); // 落下を一回進めるごとに調整する
+
+#endif
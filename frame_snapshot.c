@@ -0,0 +1,114 @@
+/*
+ * 描画する一枚分のゲームの状態と、それをスレッドの間で受け渡す三重のバッファ
+ * 書き込み側は公開する時に自分の場所と受け渡し用の場所を交換し、読み出し側は新しい内容がある時だけ交換する。
+ * 交換は acq_rel で行うので、書き込んだ内容は交換した後の読み出し側から必ず見える。
+ */
+
+#include <string.h>
+#include "frame_snapshot.h"
+
+/**
+ * 空のバッファを作る
+ * 最初は書き込み側が0、受け渡し用が1、読み出し側が2を持ち、読み出し側の場所には空の状態を入れておく
+ *
+ * @param buffer バッファ
+ */
+void snapshot_buffer_init(SnapshotBuffer *buffer){
+    memset(buffer->slots, 0, sizeof(buffer->slots));
+    buffer->writing = 0;
+    atomic_init(&buffer->shared, 1);
+    buffer->reading = 2;
+}
+
+/**
+ * 書き込む場所を返す
+ * 書き込み側のスレッドだけが使い、中身は前に公開した古い内容なので、使う値は全て書き直す
+ *
+ * @param buffer バッファ
+ *
+ * @return 書き込む場所
+ */
+FrameSnapshot *snapshot_buffer_begin(SnapshotBuffer *buffer){
+    return &buffer->slots[buffer->writing];
+}
+
+/**
+ * 書き込んだ内容を公開する
+ * 書き込んだ場所を受け渡し用にして、それまでの受け渡し用の場所に次を書き込む
+ * 読み出し側が読まなかった古い内容は、そのまま次の書き込みで上書きされる
+ *
+ * @param buffer バッファ
+ */
+void snapshot_buffer_publish(SnapshotBuffer *buffer){
+    int old = atomic_exchange_explicit(&buffer->shared, buffer->writing | SNAPSHOT_FRESH,
+            memory_order_acq_rel); // それまでの受け渡し用の場所
+
+    buffer->writing = old & ~SNAPSHOT_FRESH;
+}
+
+/**
+ * 公開された一番新しい内容を返す
+ * 新しい内容がない時は、前に返したものをもう一度返す
+ * 読み出し側のスレッドだけが使い、返したものは次にこの関数を呼ぶまで書き換えられない
+ *
+ * @param buffer バッファ
+ *
+ * @return 一番新しいスナップショット
+ */
+const FrameSnapshot *snapshot_buffer_latest(SnapshotBuffer *buffer){
+    if((atomic_load_explicit(&buffer->shared, memory_order_relaxed) & SNAPSHOT_FRESH) != 0){
+        int old = atomic_exchange_explicit(&buffer->shared, buffer->reading,
+                memory_order_acq_rel); // 新しい内容が入った受け渡し用の場所
+
+        buffer->reading = old & ~SNAPSHOT_FRESH;
+    }
+    return &buffer->slots[buffer->reading];
+}
+
+/**
+ * ゲームの状態から描画に使う値を書き写す
+ * 文字列と仮名は読み込んだファイルの内容を指したままにし、変わっていく入力と入力例だけを書き写す
+ * 時間に関係する値 (publishTime, accumulator, timeScale, isPaused) は書き込む側で入れる
+ *
+ * @param snapshot 書き込む場所
+ * @param game ゲームの状態
+ */
+void snapshot_capture(FrameSnapshot *snapshot, const Game *game){
+    const Str *strings = game->strings; // 文字列の情報
+    const Str *str; // 入力中の文字列
+    int wordNum = 0; // 書き写した文字列の数
+    int focus = game_focus(game); // 仮名と入力例を表示する文字列の番号
+
+    snapshot->step = game->step;
+    snapshot->isOver = game_is_over(game);
+    snapshot->completeTypingNum = game->completeTypingNum;
+    for(int i = active_list_first(&game->fallList); i != -1 && wordNum < SNAPSHOT_WORD_MAX;
+            i = active_list_next(&game->fallList, i)){
+        SnapshotWord *word = &snapshot->words[wordNum]; // 書き写す場所
+        word->origin = strings[i].origin;
+        word->x = strings[i].x;
+        word->prevY = strings[i].prevY;
+        word->y = strings[i].y;
+        word->isTarget = i == focus;
+        wordNum++;
+    }
+    snapshot->wordNum = wordNum;
+
+    // 入力が終わっていない文字列があれば、仮名と入力例を書き写す
+    snapshot->hasTarget = focus != -1 && strings[focus].canDraw != 2;
+    if(snapshot->hasTarget == 0){
+        return;
+    }
+    str = &strings[focus];
+    snapshot->kana = str->kana;
+    snapshot->kanaCharNum = str->kanaCharNum;
+    snapshot->kanaPos = str->cursor.kanaPos < str->kanaCharNum ? str->cursor.kanaPos : str->kanaCharNum;
+    snapshot->kanaWidth = str->kanaWidth;
+    snapshot->kanaHeight = str->kanaHeight;
+    snapshot->kanaRestX = snapshot->kanaPos < str->kanaCharNum ? str->kanaX[snapshot->kanaPos] : str->kanaWidth;
+    strcpy(snapshot->input, str->input);
+    snapshot->inputWidth = str->inputWidth;
+    strcpy(snapshot->example, str->example.text + str->example.head);
+    snapshot->exampleWidth = str->exampleWidth;
+    snapshot->exampleHeight = str->exampleHeight;
+}
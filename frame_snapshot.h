@@ -0,0 +1,70 @@
+/*
+ * 描画する一枚分のゲームの状態 (スナップショット) と、それをスレッドの間で受け渡す三重のバッファ
+ *
+ * ゲームを進めるスレッドは、落下を進めるたびにゲームの状態から描画に使う値だけを書き写して公開する。
+ * 描画するスレッドは公開された一番新しいものを読むだけなので、ゲームの状態を直接触らず、ロックも使わない。
+ * バッファは3つあり、書き込み側と読み出し側がそれぞれ一つずつ持ち、残りの一つを原子的に交換して受け渡すので、
+ * どちらも相手を待たず、読んでいる途中のものが書き換えられることもない。
+ * 書き込み側と読み出し側はそれぞれ一つのスレッドだけが使う。
+ */
+
+#ifndef FALLTYPING_FRAME_SNAPSHOT_H
+#define FALLTYPING_FRAME_SNAPSHOT_H
+
+#include <stdatomic.h>
+#include "game.h"
+
+#define SNAPSHOT_WORD_MAX 256 // スナップショットに書き写す落ちている文字列の最大の数 (超えた分は描画しない)
+#define SNAPSHOT_FRESH 4      // 受け渡し用のバッファに、まだ読まれていない新しい内容があることを表すビット
+
+/* ------ 構造体の宣言 ------*/
+// 落ちている一つの文字列
+typedef struct{
+    const char *origin; // 落とす文字列 (読み込んだファイルの内容を指す)
+    double x;           // 描画時のx座標
+    double prevY;       // 一つ前に落下を進めた時のy座標
+    double y;           // 今のy座標
+    int isTarget;       // 入力中の文字列かどうか
+}SnapshotWord;
+
+// 描画する一枚分のゲームの状態
+typedef struct{
+    long long step;         // 落下を進めた回数
+    long long publishTime;  // 公開した実際の時間 (ナノ秒)
+    long long accumulator;  // 公開した時にまだ落下を進めていなかったゲームの時間 (ナノ秒)
+    double timeScale;       // 実際の時間に対するゲームの時間の進む速さ
+    int isPaused;           // 一時停止中かどうか
+    int isOver;             // ゲームが終わったかどうか
+    int completeTypingNum;  // タイピングが完了した文字列の数
+    int wordNum;            // 落ちている文字列の数
+    SnapshotWord words[SNAPSHOT_WORD_MAX]; // 落ちている文字列 (落ち始めた順)
+    int hasTarget;          // 入力例を描画するかどうか
+    const char *kana;       // 入力中の文字列の仮名 (読み込んだファイルの内容を指す)
+    int kanaCharNum;        // 仮名の文字数
+    int kanaPos;            // 入力が確定した仮名の数
+    double kanaWidth;       // 仮名の文字列の描画範囲の幅
+    double kanaHeight;      // 仮名の文字列の描画範囲の高さ
+    double kanaRestX;       // 確定していない仮名の、文字列の先頭からの描画位置
+    char input[ROMAJI_INPUT_MAX + 1]; // 入力された文字列
+    double inputWidth;      // 入力された文字列の描画範囲の幅
+    char example[ROMAJI_EXAMPLE_SIZE]; // 残りの入力例
+    double exampleWidth;    // 入力された文字列と残りの入力例を合わせた描画範囲の幅
+    double exampleHeight;   // 入力例の描画範囲の高さ
+}FrameSnapshot;
+
+// スナップショットを受け渡す三重のバッファ
+typedef struct{
+    FrameSnapshot slots[3]; // スナップショットを書き込む場所
+    atomic_int shared;      // 受け渡し用の場所の番号 (新しい内容がある時は SNAPSHOT_FRESH を足す)
+    int writing;            // 書き込み側が今書いている場所の番号
+    int reading;            // 読み出し側が今読んでいる場所の番号
+}SnapshotBuffer;
+
+/* ------ プロトタイプ宣言 ------ */
+void snapshot_buffer_init(SnapshotBuffer *buffer); // 空のバッファを作る
+FrameSnapshot *snapshot_buffer_begin(SnapshotBuffer *buffer); // 書き込む場所を返す
+void snapshot_buffer_publish(SnapshotBuffer *buffer); // 書き込んだ内容を公開する
+const FrameSnapshot *snapshot_buffer_latest(SnapshotBuffer *buffer); // 公開された一番新しい内容を返す
+void snapshot_capture(FrameSnapshot *snapshot, const Game *game); // ゲームの状態から描画に使う値を書き写す
+
+#endif
@@ -0,0 +1,669 @@
+/*
+ * 一回のゲームの中身
+ * main.c のメインループから、描画と時間の取得以外の処理をまとめたもの。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "game.h"
+#include "game_clock.h"
+#include "text_metrics.h"
+#include "trace.h"
+
+/* ------ プロトタイプ宣言 ------ */
+static int pick_word(Game *game); // 次に落とす文字列を選ぶ
+static double word_slowness(const Game *game, int index); // 文字列の仮名の入力の遅さの平均を返す
+static int remaining_keys(const Game *game, double *distance); // 残りのキー入力の数と終了の線までの距離を調べる
+static int key_candidates(Game *game, unsigned int ch, long long time); // 入力先が決まっていない時のキー入力を判定する
+static void release_candidate(Game *game, int strIndex); // 入力先の候補から外した文字列を最初から打てるように戻す
+static void complete_string(Game *game, int strIndex, long long time); // 入力し終えた文字列を一覧から外す
+
+/**
+ * ゲームを始める前の状態を作る
+ * 袋は game の中の乱数生成器を指すので、作った後に game を別の場所へコピーしてはいけない
+ *
+ * @param game ゲームの状態
+ * @param corpus ファイルから読み込んだ文字列
+ * @param level 難易度ごとに決まる値
+ * @param seed 乱数の種
+ * @param width 画面の幅
+ * @param spawnLine 文字列が落ち始めるy座標
+ * @param endLine 文字列が当たると終了の線の位置
+ *
+ * @return 0:成功 -1:メモリの確保に失敗
+ */
+int game_init(Game *game, const Corpus *corpus, const GameLevel *level, unsigned long long seed,
+              double width, double spawnLine, double endLine){
+    memset(game, 0, sizeof(Game));
+    game->level = *level;
+    game->corpus = corpus;
+    game->strNum = corpus->wordNum;
+    game->strIndex = -1;
+    game->width = width;
+    game->spawnLine = spawnLine;
+    game->endLine = endLine;
+    // 選ぶ文字列と落とす位置で乱数の系列を分けるので、位置の選び方で乱数を使う回数が変わっても、選ぶ文字列の順番は変わらない
+    rng_seed(&game->rng, seed, 0);
+    rng_seed(&game->placeRng, seed, 1);
+    game->fallSpeed = level->fallSpeed;
+    game->fallInterval = level->fallInterval;
+    difficulty_init(&game->difficulty, level->fallSpeed, game_clock_to_sec(level->fallInterval));
+
+    // 0で初期化するので、全ての文字列は WAIT_TYPING で入力例を作っていない状態になる
+    // 入力例は文字列が選ばれた時に作るので、文字列の数が多くても起動時間は変わらない
+    game->strings = (Str*) calloc(game->strNum > 0 ? game->strNum : 1, sizeof(Str));
+    game->candidates = (int*) malloc((game->strNum > 0 ? game->strNum : 1) * sizeof(int));
+    if(game->strings == NULL || game->candidates == NULL || active_list_init(&game->fallList, game->strNum) != 0
+       || shuffle_bag_init(&game->wordBag, game->strNum, &game->rng) != 0
+       || span_index_init(&game->spawnSpans, width, SPAWN_MARGIN) != 0 || target_index_init(&game->targets, game->strNum) != 0
+       || analytics_init(&game->analytics, romajiTable.nodeNum) != 0){
+        game_free(game);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * ゲームのメモリを解放する
+ *
+ * @param game ゲームの状態
+ */
+void game_free(Game *game){
+    free(game->strings);
+    free(game->candidates);
+    game->strings = NULL;
+    game->candidates = NULL;
+    active_list_free(&game->fallList);
+    shuffle_bag_free(&game->wordBag);
+    span_index_free(&game->spawnSpans);
+    target_index_free(&game->targets);
+    analytics_free(&game->analytics);
+}
+
+/**
+ * キー入力を一つ判定する
+ * 入力し終えた文字列は一覧から外し、続けて届いたキー入力は次の文字列に対して判定する
+ * 判定の結果は、入力していた仮名と入力パターンと一緒に集計する
+ *
+ * @param game ゲームの状態
+ * @param ch 入力された文字
+ * @param time キー入力のゲームの時間 (ナノ秒) 前のキー入力より小さくしない
+ *
+ * @return GAME_KEY_ACCEPT : 正しい GAME_KEY_FAILURE : 間違い GAME_KEY_IGNORED : 入力する文字列がない
+ */
+int game_key(Game *game, unsigned int ch, long long time){
+    Str *strings = game->strings; // 文字列の情報を保持する構造体
+    int strIndex; // 入力中の文字列の番号
+    int result; // 判定の結果
+    int kana; // 入力していた仮名の番号
+    int pattern; // 入力していた入力パターンの番号
+    long long readyTime; // 入力中の文字列が打てるようになったゲームの時間 (ナノ秒)
+
+    if(game_is_over(game) || game->fallList.num == 0){ // 落ちている文字列がない時は読み捨てる
+        return GAME_KEY_IGNORED;
+    }
+    if(game->level.freeTarget == 1 && game->strIndex == -1){ // 入力先が決まっていない時は候補を絞り込む
+        return key_candidates(game, ch, time);
+    }
+    if(game->strIndex == -1){ // 入力する文字列がない時は読み捨てる
+        return GAME_KEY_IGNORED;
+    }
+    strIndex = game->strIndex;
+
+    // 入力中の文字列への最初のキー入力なら、打てるようになってからの時間を反応時間として数える
+    // 打てるようになるのは、落ち始めた時と前の文字列を入力し終えた時の遅い方
+    if(game->targetKeyed == 0){
+        readyTime = strings[strIndex].startTime > game->completeTime ? strings[strIndex].startTime : game->completeTime;
+        analytics_reaction(&game->analytics, time - readyTime);
+        game->targetKeyed = 1;
+    }
+
+    // 正誤判定とそれの反映の準備
+    kana = strings[strIndex].cursor.kanaPos < strings[strIndex].codeLen ? strings[strIndex].code[strings[strIndex].cursor.kanaPos] : -1;
+    pattern = romaji_pattern_index(&strings[strIndex].cursor, strings[strIndex].code, strings[strIndex].codeLen);
+    if(check_input_char(strings, strIndex, ch, &game->profile, &game->profile) == 0){
+        game->typingAcceptNum += 1;
+        result = GAME_KEY_ACCEPT;
+        difficulty_key(&game->difficulty);
+        TRACE("key %c accept", (int)ch);
+    }else{
+        game->typingFailureNum += 1;
+        result = GAME_KEY_FAILURE;
+        TRACE("key %c failure", (int)ch);
+    }
+    analytics_key(&game->analytics, time, kana, pattern, result == GAME_KEY_ACCEPT);
+
+    // 今選択している文字列が入力終了しているかを判定
+    if(strings[strIndex].cursor.kanaPos >= strings[strIndex].codeLen && strings[strIndex].canDraw == DO_TYPING){
+        complete_string(game, strIndex, time);
+    }
+    return result;
+}
+
+/**
+ * 入力先が決まっていない時のキー入力を判定する
+ * 最初のキー入力では、その文字で始まる文字列を全て入力先の候補にする
+ * 候補が一つに絞れるまでは、候補ごとの入力位置を同じキー入力で進め、合わなくなった候補は最初から打てるように戻す
+ * 候補が一つだけ残るか、入力し終えた候補があればそれを入力先にする
+ * どの候補とも合わない時は間違いとし、候補の入力位置はそのままにする
+ * 反応時間、集計、打ち方の好みは、入力が合った候補のうち一番早く落ち始めたもので数える
+ *
+ * @param game ゲームの状態
+ * @param ch 入力された文字
+ * @param time キー入力のゲームの時間 (ナノ秒)
+ *
+ * @return GAME_KEY_ACCEPT : 正しい GAME_KEY_FAILURE : 間違い
+ */
+static int key_candidates(Game *game, unsigned int ch, long long time){
+    Str *strings = game->strings; // 文字列の情報を保持する構造体
+    RomajiCursor cursor; // 入力が合うかを確かめるための入力位置
+    int first = -1; // 入力が合った候補のうち一番早く落ち始めた文字列の番号
+    int focus = -1; // 入力先に決まった文字列の番号
+    int num = 0; // 入力が合って残った候補の数
+    int kana; // 入力していた仮名の番号
+    int pattern; // 入力していた入力パターンの番号
+    long long readyTime; // 候補が打てるようになったゲームの時間 (ナノ秒)
+
+    if(game->candidateNum == 0){
+        game->candidateNum = target_index_collect(&game->targets, ch, game->candidates, game->strNum);
+        for(int i = 0; i < game->candidateNum; i++){
+            target_index_remove(&game->targets, game->candidates[i]);
+        }
+        game->targetKeyed = 0;
+    }
+    for(int i = 0; i < game->candidateNum && first == -1; i++){
+        Str *str = &strings[game->candidates[i]]; // 確かめる候補
+
+        cursor = str->cursor;
+        if(romaji_input(&cursor, str->code, str->codeLen, ch) == 0){
+            first = game->candidates[i];
+        }
+    }
+    if(first == -1){ // どの候補とも違う時 (候補がない時は、どの文字列の最初の文字とも違う時)
+        game->typingFailureNum += 1;
+        if(game->candidateNum == 0){
+            analytics_key(&game->analytics, time, -1, -1, 0);
+        }else{
+            Str *str = &strings[game->candidates[0]]; // 一番早く落ち始めた候補
+
+            analytics_key(&game->analytics, time, str->cursor.kanaPos < str->codeLen ? str->code[str->cursor.kanaPos] : -1,
+                          romaji_pattern_index(&str->cursor, str->code, str->codeLen), 0);
+        }
+        TRACE("key %c failure", (int)ch);
+        return GAME_KEY_FAILURE;
+    }
+
+    if(game->targetKeyed == 0){
+        readyTime = strings[first].startTime > game->completeTime ? strings[first].startTime : game->completeTime;
+        analytics_reaction(&game->analytics, time - readyTime);
+        game->targetKeyed = 1;
+    }
+    kana = strings[first].cursor.kanaPos < strings[first].codeLen ? strings[first].code[strings[first].cursor.kanaPos] : -1;
+    pattern = romaji_pattern_index(&strings[first].cursor, strings[first].code, strings[first].codeLen);
+
+    // 打ち方の好みは一つのキー入力を一回だけ数えるように一番早く落ち始めた候補でだけ数え、入力例はどの候補も同じ好みで作り直す
+    for(int i = 0; i < game->candidateNum; i++){
+        int index = game->candidates[i]; // 入力を進める候補
+
+        if(check_input_char(strings, index, ch, index == first ? &game->profile : NULL, &game->profile) == 0){
+            game->candidates[num++] = index;
+        }else{
+            release_candidate(game, index);
+        }
+    }
+    game->candidateNum = num;
+    game->typingAcceptNum += 1;
+    difficulty_key(&game->difficulty);
+    analytics_key(&game->analytics, time, kana, pattern, 1);
+    TRACE("key %c accept candidates %d", (int)ch, num);
+
+    for(int i = 0; i < num && focus == -1; i++){
+        if(strings[game->candidates[i]].cursor.kanaPos >= strings[game->candidates[i]].codeLen){
+            focus = game->candidates[i];
+        }
+    }
+    if(focus == -1 && num == 1){
+        focus = game->candidates[0];
+    }
+    if(focus != -1){
+        for(int i = 0; i < num; i++){
+            if(game->candidates[i] != focus){
+                release_candidate(game, game->candidates[i]);
+            }
+        }
+        game->candidateNum = 0;
+        game->strIndex = focus;
+        TRACE("focus %d", focus);
+        if(strings[focus].cursor.kanaPos >= strings[focus].codeLen){
+            complete_string(game, focus, time);
+        }
+    }
+    return GAME_KEY_ACCEPT;
+}
+
+/**
+ * 入力先の候補から外した文字列を、入力位置を先頭に戻して最初に打てる文字の列に並べ直す
+ *
+ * @param game ゲームの状態
+ * @param strIndex 文字列の番号
+ */
+static void release_candidate(Game *game, int strIndex){
+    set_string_example(game->strings, strIndex, &game->profile);
+    target_index_add(&game->targets, strIndex, romaji_next_keys(&game->strings[strIndex].cursor));
+}
+
+/**
+ * 入力し終えた文字列を数えて一覧から外し、次に入力する文字列の番号をセットする
+ *
+ * @param game ゲームの状態
+ * @param strIndex 入力し終えた文字列の番号
+ * @param time 入力し終えたゲームの時間 (ナノ秒)
+ */
+static void complete_string(Game *game, int strIndex, long long time){
+    Str *strings = game->strings; // 文字列の情報を保持する構造体
+
+    game->completeTypingNum += 1; // 入力が終わった文字列数のカウント
+    game->completeTime = time;
+    game->targetKeyed = 0; // 次の入力先の文字列の反応時間を数える
+    analytics_complete(&game->analytics);
+    difficulty_complete(&game->difficulty, strings[strIndex].cursor.inputLen);
+    strings[strIndex].canDraw = FINISH_TYPING; // 描画を終了する
+    // 落ちている文字列の一覧から、入力の終わった文字列を外して、次に入力する文字列の番号をセットする
+    active_list_remove(&game->fallList, strIndex);
+    shuffle_bag_release(&game->wordBag, strIndex); // 袋が空になった時にまた選べるようにする
+    span_index_remove(&game->spawnSpans, strIndex); // 消えたので、次の文字列をこの位置に落とせる
+    // どれにでも入力できる時は、次のキー入力で入力先を決め直す
+    game->strIndex = game->level.freeTarget == 1 ? -1 : active_list_first(&game->fallList); // 残っていない時は-1になる
+}
+
+/**
+ * 文字列の落下を一回 (1 / SIM_RATE 秒) 進める
+ * 間隔が空いていれば新しく文字列を落とし、終了の線に当たった文字列があれば終了のフラグを立てる
+ * 難易度を調整する時は、落とした後の残りのキー入力の数と終了の線までの距離から次の落下速度と間隔を決め直す
+ * エンドレスの時は、時間が経つほど文字列を落とす間隔を短くする
+ * 位置は一回ごとに今の落下速度の分だけ下げるので、落下速度が変わっても文字列の位置は飛ばない
+ *
+ * @param game ゲームの状態
+ */
+void game_step(Game *game){
+    Str *strings = game->strings; // 文字列の情報を保持する構造体
+    int indexNum; // 新たに落とす文字列の番号
+    double stepSec = 1.0 / SIM_RATE; // 落下を一回進める時間 (秒)
+    double fallInterval; // 調整した文字列を落とす間隔 (秒)
+    double distance; // 一番下の文字列の終了の線までの距離
+    int keyNum; // 落ちている文字列の残りのキー入力の数
+
+    if(game_is_over(game)){
+        return;
+    }
+    game->step += 1;
+    game->nowTime = game->step * (NS_PER_SEC / SIM_RATE);
+
+    // 落とす場所もできるだけすでに落としている文字列に被らないようにランダムに決める
+    /* ------ 新たに文字列を落とす処理 ------ */
+    if((game->fallInterval < game->nowTime - game->beforeFallTime || game->fallList.num == 0)
+       && (game->level.endless == 1 || game->completeTypingNum + 1 + game->fallList.num <= game->level.finishTypingNum)
+       && (indexNum = pick_word(game)) != -1){
+        active_list_push(&game->fallList, indexNum);
+        game->beforeFallTime = game->nowTime;
+        if(game->level.freeTarget == 0 && game->strIndex == -1){
+            game->strIndex = active_list_first(&game->fallList);
+        }
+        // 文字列を落とすために必要な初期化をする
+        prepare_string(strings, indexNum, game->corpus, &game->profile);
+        if(game->level.freeTarget == 1){ // 最初に打てる文字の列に並べる
+            target_index_add(&game->targets, indexNum, romaji_next_keys(&strings[indexNum].cursor));
+        }
+        strings[indexNum].y = game->spawnLine;
+        strings[indexNum].prevY = strings[indexNum].y;
+        strings[indexNum].startTime = game->nowTime;
+        span_index_expire(&game->spawnSpans, game->nowTime);
+        strings[indexNum].x = random_x_location(strings, indexNum, &game->spawnSpans, &game->placeRng);
+        span_index_insert(&game->spawnSpans, strings[indexNum].x, strings[indexNum].x + strings[indexNum].originWidth, indexNum,
+                game->nowTime + game_clock_from_sec(SPAWN_CLEAR_HEIGHT / game->fallSpeed));
+        TRACE("spawn %d x %.1f width %.1f", indexNum, strings[indexNum].x, strings[indexNum].originWidth);
+        strings[indexNum].canDraw = DO_TYPING;
+    }
+
+    /* ------ 文字列の位置を更新 ------ */
+    for(indexNum = active_list_first(&game->fallList); indexNum != -1; indexNum = active_list_next(&game->fallList, indexNum)){
+        if(strings[indexNum].y < game->endLine){ // 落ちている文字列が当たったらダメな線に当たっていたら終了のフラグを立てる
+            game->touchEndLine = 1;
+            break;
+        }
+        strings[indexNum].prevY = strings[indexNum].y; // 描画の時に補間するために、前の位置を残しておく
+        // 文字列を今の速度で下に落とす (落ち始めた回は落ち始めの位置のまま)
+        if(strings[indexNum].canDraw != FINISH_TYPING && strings[indexNum].startTime < game->nowTime) {
+            strings[indexNum].y -= game->fallSpeed * stepSec;
+        }
+    }
+
+    /* ------ 難易度の調整 ------ */
+    if(game->level.adaptive == 0 && game->level.endless == 1){
+        // エンドレスの時は、時間が経つほど短い間隔で文字列を落とす
+        fallInterval = game_clock_to_sec(game->level.fallInterval) / (1.0 + game_clock_to_sec(game->nowTime) / ENDLESS_RAMP_SEC);
+        game->fallInterval = game_clock_from_sec(fallInterval > ENDLESS_INTERVAL_MIN ? fallInterval : ENDLESS_INTERVAL_MIN);
+    }else if(game->level.adaptive == 1 && game->touchEndLine == 0){
+        keyNum = remaining_keys(game, &distance);
+        difficulty_update(&game->difficulty, keyNum, distance, stepSec, &game->fallSpeed, &fallInterval);
+        game->fallInterval = game_clock_from_sec(fallInterval);
+        if(game->step % SIM_RATE == 0){
+            TRACE("difficulty speed %.2f interval %.3f", game->fallSpeed, fallInterval);
+        }
+    }
+}
+
+/**
+ * ゲームが終わったかどうかを返す
+ *
+ * @param game ゲームの状態
+ *
+ * @return 0:まだ続く 1:難易度ごとの回数を入力し終えたか (エンドレスの時は除く)、終了の線に当たった
+ */
+int game_is_over(const Game *game){
+    return (game->level.endless == 0 && game->completeTypingNum >= game->level.finishTypingNum) || game->touchEndLine == 1;
+}
+
+/**
+ * 仮名と入力例を表示する文字列の番号を返す
+ * どれにでも入力できる時に入力先が決まっていなければ、一番早く落ち始めた候補を返す
+ *
+ * @param game ゲームの状態
+ *
+ * @return 文字列の番号 入力先も候補もない時は-1
+ */
+int game_focus(const Game *game){
+    if(game->strIndex == -1 && game->candidateNum > 0){
+        return game->candidates[0];
+    }
+    return game->strIndex;
+}
+
+/**
+ * スコアを計算する (計算の式は game_score_of)
+ * 時間は落下を進めた回数から計算するので、記録を再生した時も遊んだ時と同じスコアになる
+ *
+ * @param game ゲームの状態
+ *
+ * @return スコア キー入力がない時と時間が進んでいない時は0
+ */
+int game_score(const Game *game){
+    return game_score_of(game->typingAcceptNum, game->typingFailureNum, game_clock_to_sec(game->nowTime));
+}
+
+/**
+ * 次に落とす文字列を袋から選ぶ
+ * 難易度を調整する時は、袋から候補をいくつか引いて苦手な仮名が一番多い文字列を選び、残りは袋に戻す
+ * イメージの中で壊れていて取り出せない文字列は、袋から出したままにして二度と選ばない
+ *
+ * @param game ゲームの状態
+ *
+ * @return 文字列の番号 袋が空の時は-1
+ */
+static int pick_word(Game *game){
+    CorpusWord word; // 取り出せるかを確かめる文字列
+    int best; // 選んだ文字列の番号
+    int candidate; // 見比べる文字列の番号
+    double bestSlowness, slowness; // 仮名の入力の遅さの平均
+
+    while((best = shuffle_bag_draw(&game->wordBag)) != -1 && corpus_get_word(game->corpus, best, &word) != 0){
+        TRACE("broken %d", best);
+    }
+    if(game->level.adaptive == 0 || best == -1){
+        return best;
+    }
+    bestSlowness = word_slowness(game, best);
+    for(int i = 1; i < PICK_CANDIDATE_NUM; i++){
+        if((candidate = shuffle_bag_draw(&game->wordBag)) == -1){
+            break;
+        }
+        if(corpus_get_word(game->corpus, candidate, &word) != 0){
+            TRACE("broken %d", candidate);
+            continue;
+        }
+        slowness = word_slowness(game, candidate);
+        if(slowness > bestSlowness){
+            shuffle_bag_unget(&game->wordBag, best);
+            best = candidate;
+            bestSlowness = slowness;
+        }else{
+            shuffle_bag_unget(&game->wordBag, candidate);
+        }
+    }
+    return best;
+}
+
+/**
+ * 文字列の仮名の入力が、全体の平均より何倍遅いかの平均を返す
+ *
+ * @param game ゲームの状態
+ * @param index 文字列の番号
+ *
+ * @return 仮名ごとの遅さの平均 仮名がない時は1
+ */
+static double word_slowness(const Game *game, int index){
+    CorpusWord word; // 読み込んだ文字列
+    unsigned char code[KANA_LEN_MAX]; // 仮名ごとの文字の番号
+    const unsigned char *codes = code; // 見る仮名の番号
+    int codeLen; // 仮名の数
+    double sum = 0; // 遅さの合計
+
+    if(game->strings[index].isReady == 1){ // 一度落とした文字列は変換済みの仮名の番号を使う
+        codes = game->strings[index].code;
+        codeLen = game->strings[index].codeLen;
+    }else if(corpus_get_word(game->corpus, index, &word) != 0){
+        return 1.0;
+    }else if(word.code != NULL){
+        codes = word.code;
+        codeLen = word.codeLen;
+    }else{
+        codeLen = romaji_decode_kana(word.kana, code);
+    }
+    if(codeLen <= 0){
+        return 1.0;
+    }
+    for(int i = 0; i < codeLen; i++){
+        sum += analytics_kana_slowness(&game->analytics, codes[i]);
+    }
+    return sum / codeLen;
+}
+
+/**
+ * 落ちている文字列の残りのキー入力の数と、一番下の文字列の終了の線までの距離を調べる
+ * 文字列は同じ速度で落ちるので、一番早く落ち始めた文字列が一番下にある
+ *
+ * @param game ゲームの状態
+ * @param distance 一番下の文字列の終了の線までの距離を保存する変数 (文字列がない時は0)
+ *
+ * @return 落ちている文字列の入力例の残りの文字数の合計
+ */
+static int remaining_keys(const Game *game, double *distance){
+    int lowest = active_list_first(&game->fallList); // 一番下の文字列の番号
+    int keyNum = 0; // 残りの文字数の合計
+
+    *distance = lowest == -1 ? 0 : game->strings[lowest].y - game->endLine;
+    for(int i = lowest; i != -1; i = active_list_next(&game->fallList, i)){
+        keyNum += ROMAJI_EXAMPLE_SIZE - 1 - game->strings[i].example.head;
+    }
+    return keyNum;
+}
+
+/**
+ * 落とす文字列のx座標の位置を、落ち始めたばかりの文字列に重ならないようにランダムに決めて返す
+ * 画面が埋まっていて重ならない位置がない時は、一番広い空きの真ん中にする
+ *
+ * @param strings 文字列とそれに関する情報を保存する構造体
+ * @param indexNum 文字列の番号
+ * @param spawnSpans 落ち始める位置の近くで文字列が使っている横方向の範囲
+ * @param rng 乱数生成器
+ *
+ * @return x座標の位置
+ */
+double random_x_location(Str *strings, int indexNum, const SpanIndex *spawnSpans, Rng *rng){
+    // テキストを描画した時の幅は文字列を選んだ時に調べてある
+    return span_index_place(spawnSpans, strings[indexNum].originWidth, rng);
+}
+
+/**
+ * 選ばれた文字列の入力例を作る関数
+ * 一度作った文字列は作り直さず、もう一度選ばれた時は入力位置を先頭に戻すだけにする
+ *
+ * @param strings 文字列とそれに関する情報を保存する構造体
+ * @param strIndex 文字列の番号
+ * @param corpus ファイルから読み込んだ文字列
+ * @param profile 打ち方の好み (NULL の時はキー入力の数だけで入力例を選ぶ)
+ */
+void prepare_string(Str *strings, int strIndex, const Corpus *corpus, const RomajiProfile *profile){
+    CorpusWord word; // 読み込んだ文字列
+    Str *str = &strings[strIndex]; // 入力例を作る文字列
+
+    if(str->isReady == 1){
+        set_string_example(strings, strIndex, profile);
+        return;
+    }
+    if(corpus_get_word(corpus, strIndex, &word) != 0){
+        word.origin = "";
+        word.kana = "";
+        word.code = NULL;
+        word.codeLen = 0;
+    }
+    str->origin = word.origin;
+    str->kana = word.kana;
+    if(word.code != NULL){ // イメージから読み込んだ時は、変換済みの仮名の番号を使う
+        memcpy(str->code, word.code, word.codeLen);
+        str->codeLen = word.codeLen;
+    }else{
+        str->codeLen = romaji_decode_kana(str->kana, str->code);
+    }
+    layout_kana(str); // 仮名の描画位置を計算
+    set_string_example(strings, strIndex, profile); // 入力例をセット
+    str->isReady = 1;
+}
+
+/**
+ * 入力位置を先頭に戻して全文の入力例をセットする関数
+ * 入力例は、キー入力の数が少なく、遊んでいる人がいつも使う打ち方になるように選ぶ
+ *
+ * @param strings 文字列とそれに関する情報を保存する構造体
+ * @param strIndex 文字列の番号
+ * @param profile 打ち方の好み (NULL の時はキー入力の数だけで選ぶ)
+ **/
+void set_string_example(Str *strings, int strIndex, const RomajiProfile *profile){
+    Str *str = &strings[strIndex]; // 入力例をセットする文字列
+    double width; // 描画範囲の幅を保存するための変数
+    int num; // 作った入力例の文字数
+
+    romaji_cursor_reset(&str->cursor, str->code, str->codeLen);
+    str->input[0] = '\0';
+    str->inputWidth = 0;
+    num = romaji_example_reset(&str->example, &str->cursor, str->code, str->codeLen, profile);
+    str->exampleRight[ROMAJI_EXAMPLE_SIZE - 1] = 0;
+    text_metrics_measure(EXAMPLE_FONT_SIZE, str->example.text + str->example.head, &width, &str->exampleHeight);
+    layout_example(str, num);
+}
+
+/**
+ * 入力例と違う打ち方をした時に、今の仮名から入力例を作り直す関数
+ * 作り直すのは前の入力例と同じ位置で区切れる仮名までで、その先の入力例と描画位置はそのまま使う
+ *
+ * @param strings 文字列とそれに関する情報を保存する構造体
+ * @param strIndex 文字列の番号
+ * @param profile 打ち方の好み (NULL の時はキー入力の数だけで選ぶ)
+ */
+void change_string_example(Str *strings, int strIndex, const RomajiProfile *profile){
+    Str *str = &strings[strIndex]; // 入力例を変更する文字列
+
+    layout_example(str, romaji_example_plan(&str->example, &str->cursor, str->code, str->codeLen, profile));
+    TRACE("example %s%s", str->input, str->example.text + str->example.head);
+}
+
+/**
+ * 落とす文字列と仮名の文字列の描画範囲と、仮名の一文字ごとの描画位置を計算する関数
+ * 仮名は一文字3バイトとして区切る
+ *
+ * @param str 描画位置を計算する文字列
+ */
+void layout_kana(Str *str){
+    char kanaChar[4]; // 仮名の一文字
+    double width, height; // 描画範囲を保存するための変数
+    double x = 0; // 描画位置を保存するための変数
+
+    text_metrics_measure(FALL_FONT_SIZE, str->origin, &str->originWidth, &height);
+    text_metrics_measure(KANA_FONT_SIZE, str->kana, &str->kanaWidth, &str->kanaHeight);
+    str->kanaCharNum = 0;
+    for(int i = 0; str->kana[i] != '\0' && str->kanaCharNum < KANA_LEN_MAX; i += 3){
+        snprintf(kanaChar, sizeof(kanaChar), "%.3s", str->kana + i);
+        text_metrics_measure(KANA_FONT_SIZE, kanaChar, &width, &height);
+        str->kanaX[str->kanaCharNum] = x;
+        str->kanaCharNum++;
+        x += width;
+        if(str->kana[i+1] == '\0' || str->kana[i+2] == '\0')break;
+    }
+}
+
+/**
+ * 作った入力例の一文字ごとの描画位置と、入力例全体の描画範囲を計算する関数
+ * 描画位置は入力例の右端から数えるので、作った入力例の後ろの文字の位置は変わらず、作った文字の分だけ計算すればよい
+ * 一文字ごとの幅は文字の種類が少ないのでキャッシュから取れる
+ *
+ * @param str 描画位置を計算する文字列
+ * @param num 作った入力例の文字数 (残りの入力例の先頭から数える)
+ */
+void layout_example(Str *str, int num){
+    char exampleChar[2] = {0}; // 入力例の一文字
+    double width, height; // 描画範囲を保存するための変数
+    int head = str->example.head; // 残りの入力例の先頭の位置
+
+    for(int i = head + num - 1; i >= head; i--){
+        exampleChar[0] = str->example.text[i];
+        text_metrics_measure(EXAMPLE_FONT_SIZE, exampleChar, &width, &height);
+        str->exampleRight[i] = str->exampleRight[i + 1] + width;
+    }
+    str->exampleWidth = str->inputWidth + str->exampleRight[head];
+    str->exampleLen = str->cursor.inputLen + (ROMAJI_EXAMPLE_SIZE - 1 - head);
+}
+
+/**
+ * 入力された文字の正誤判定を行う。
+ * 判定は全ての文字列で共有する入力判定の表で行い、正しい時は入力された文字列に追加する
+ * 入力例の通りの文字なら入力例を一文字進め、違う打ち方の時は入力例を作り直す
+ * 仮名が確定した時は、その仮名をどう打ったかを打ち方の好みに数える
+ *
+ * @param strings 文字列とそれに関する情報を保存する構造体
+ * @param strIndex 文字列の番号
+ * @param ch 入力されたアルファベット一文字
+ * @param learnProfile 確定した仮名の打ち方を数える打ち方の好み (NULL の時は数えない)
+ * @param planProfile 入力例を作り直す時に使う打ち方の好み (NULL の時はキー入力の数だけで入力例を選ぶ)
+ *
+ * @return 0:成功 -1:失敗 で入力の正誤を返す
+ */
+int check_input_char(Str *strings, int strIndex, unsigned int ch, RomajiProfile *learnProfile,
+                     const RomajiProfile *planProfile) {
+    Str *str = &strings[strIndex]; // 判定する文字列
+    RomajiCursor before = str->cursor; // 入力する前の入力位置
+    char inputChar[2] = {(char)ch, '\0'}; // 入力された一文字
+    double width, height; // 描画範囲を保存するための変数
+
+    if(str->cursor.inputLen + 1 >= (int)sizeof(str->input)){
+        return -1;
+    }
+    if(romaji_input(&str->cursor, str->code, str->codeLen, ch) != 0){
+        return -1;
+    }
+    str->input[str->cursor.inputLen - 1] = (char)ch;
+    str->input[str->cursor.inputLen] = '\0';
+    romaji_profile_learn(learnProfile, &before, &str->cursor, str->code, str->codeLen, str->input);
+    if(romaji_example_advance(&str->example, ch) == 0){
+        // 入力例の通りの時は、入力例の一文字がそのまま入力された文字列に移るので、全体の幅は変わらない
+        str->inputWidth += str->exampleRight[str->example.head - 1] - str->exampleRight[str->example.head];
+    }else{
+        // 入力された文字と入力例が違う時、入力例を作り直す
+        text_metrics_measure(EXAMPLE_FONT_SIZE, inputChar, &width, &height);
+        str->inputWidth += width;
+        change_string_example(strings, strIndex, planProfile);
+    }
+
+    return 0;
+}
+
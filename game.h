@@ -0,0 +1,124 @@
+/*
+ * 一回のゲームの中身 (文字列を落とす、位置を進める、キー入力を判定する)
+ *
+ * 描画と時間の取得は含まないので、画面で遊ぶ時も、記録した入力を再生する時も同じ処理で進む。
+ * 時間は SIM_RATE 回/秒の決まった間隔の回数で進め、キー入力はその間に判定するので、
+ * 同じ乱数の種、同じ難易度、同じ回数の時に入力した同じキーからは、必ず同じ結果になる。
+ */
+
+#ifndef FALLTYPING_GAME_H
+#define FALLTYPING_GAME_H
+
+#include "romaji.h"
+#include "corpus.h"
+#include "active_list.h"
+#include "rng.h"
+#include "shuffle_bag.h"
+#include "span_index.h"
+#include "target_index.h"
+#include "analytics.h"
+#include "difficulty.h"
+#include "game_rules.h"
+
+#define WAIT_TYPING 0
+#define DO_TYPING 1
+#define FINISH_TYPING 2
+#define SIM_RATE 120     // 1秒に文字列の落下を進める回数
+#define FALL_FONT_SIZE 30    // 落ちてくる文字列のフォントサイズ
+#define KANA_FONT_SIZE 40    // 入力中の文字列の仮名のフォントサイズ
+#define EXAMPLE_FONT_SIZE 50 // 入力例のフォントサイズ
+#define SPAWN_MARGIN 10      // 落ち始める文字列の間に空ける幅
+#define SPAWN_CLEAR_HEIGHT (FALL_FONT_SIZE * 2) // 落ち始めた文字列が次の文字列と重ならなくなるまでに落ちる距離
+#define GAME_KEY_ACCEPT 0   // 正しい入力
+#define GAME_KEY_FAILURE -1 // 間違った入力
+#define GAME_KEY_IGNORED 1  // 入力する文字列がなくて読み捨てた入力
+#define ENDLESS_RAMP_SEC 60.0    // エンドレスで、文字列を落とす間隔が難易度ごとの間隔の半分になるまでの時間 (秒)
+#define ENDLESS_INTERVAL_MIN 0.3 // エンドレスで、文字列を落とす間隔の最小 (秒)
+#define PICK_CANDIDATE_NUM 3 // 難易度を調整する時に、苦手な仮名の多い文字列を選ぶために見比べる候補の数
+
+/* ------ 構造体の宣言 ------*/
+// 文字列の管理をする構造体
+// 読み込んだ文字列ごとに一つ作り、落とすたびに prepare_string で入力位置と入力例を初期化して使い回すので、
+// 何回落としてもメモリは増えない
+typedef struct{
+    int canDraw;            // 描画したかどうかを保持する変数
+    int isReady;            // 入力例を作ったかどうかを保持する変数
+    double x;               // 描画時のx座標を保持する変数
+    double y;               // 描画時のy座標を保持する変数
+    double prevY;           // 一つ前に落下を進めた時のy座標を保持する変数
+    RomajiCursor cursor;    // 何文字まで入力されたのかを保存する変数
+                            // kanaPos:入力が確定した仮名の数
+                            // inputLen:全体の入力文字数
+    int codeLen;            // 仮名の数を保存する変数
+    unsigned char code[KANA_LEN_MAX]; // 仮名ごとの文字の番号を保存する配列
+    const char *origin;     // 落とす文字列 (読み込んだファイルの内容を指す)
+    const char *kana;       // 落とす文字列の仮名 (読み込んだファイルの内容を指す)
+    RomajiExample example;  // ローマ字の残りの入力例 (仮名ごとの入力例の位置と一緒に保存する)
+    char input[ROMAJI_INPUT_MAX + 1]; // 入力された文字列を保存する配列
+    double originWidth;     // 落とす文字列の描画範囲の幅を保存する変数
+    int kanaCharNum;        // 仮名の文字列の文字数を保存する変数
+    double kanaWidth;       // 仮名の文字列の描画範囲の幅を保存する変数
+    double kanaHeight;      // 仮名の文字列の描画範囲の高さを保存する変数
+    double kanaX[KANA_LEN_MAX]; // 仮名の一文字ごとの、文字列の先頭からの描画位置を保存する配列
+    int exampleLen;         // 入力された文字列と残りの入力例を合わせた文字数を保存する変数
+    double inputWidth;      // 入力された文字列の描画範囲の幅を保存する変数
+    double exampleWidth;    // 入力された文字列と残りの入力例を合わせた描画範囲の幅を保存する変数
+    double exampleHeight;   // 入力例の描画範囲の高さを保存する変数
+    double exampleRight[ROMAJI_EXAMPLE_SIZE]; // 残りの入力例の一文字ごとの、その文字の左端から入力例の右端までの幅を保存する配列
+    long long startTime;    // 文字列が落ち始めた時間を保存する変数 (ナノ秒)
+}Str;
+
+// 一回のゲームの状態
+typedef struct{
+    GameLevel level;        // 難易度ごとに決まる値
+    const Corpus *corpus;   // ファイルから読み込んだ文字列
+    Str *strings;           // 文字列の情報を保持する構造体
+    int strNum;             // 落とす文字列の数
+    int strIndex;           // 入力中の文字列の番号 (-1はなし)
+    int *candidates;        // どれにでも入力できる時に、入力先が一つに決まるまで入力が合っている文字列の番号 (落ち始めた順)
+    int candidateNum;       // 入力先の候補の数
+    double width;           // 画面の幅
+    double spawnLine;       // 文字列が落ち始めるy座標
+    double endLine;         // 文字列が当たると終了の線の位置
+    ActiveList fallList;    // 落下中の文字列の番号を落ち始めた順に保存する一覧
+    ShuffleBag wordBag;     // 次に落とす文字列を選ぶための袋
+    SpanIndex spawnSpans;   // 落ち始める位置の近くで文字列が使っている横方向の範囲
+    TargetIndex targets;    // 最初の一文字から入力先の文字列を探すための索引
+    Rng rng;                // 文字列の選択に使う乱数生成器
+    Rng placeRng;           // 落とす位置に使う乱数生成器
+    long long step;         // 落下を進めた回数
+    long long nowTime;      // 落下を進めたゲームの時間 (ナノ秒)
+    long long beforeFallTime; // １つ前の文字列を落下させ始めた時間 (ナノ秒)
+    double fallSpeed;       // 今の落下速度
+    long long fallInterval; // 今の文字列を落下させ始める時間の間隔 (ナノ秒)
+    Difficulty difficulty;  // 入力の速さに合わせた難易度の調整
+    int completeTypingNum;  // タイピングが完了した文字列の数
+    int typingAcceptNum;    // 正しく入力された回数
+    int typingFailureNum;   // 入力を間違った回数
+    int touchEndLine;       // 当たった場合終了となる線に当たったかどうか 0 : 当たっていない 1 : 当たった
+    long long completeTime; // 最後に文字列を入力し終えたゲームの時間 (ナノ秒)
+    int targetKeyed;        // 入力中の文字列にキー入力があったかどうか (反応時間を一つの文字列で一回だけ数える)
+    Analytics analytics;    // キー入力ごとの速さと正確さの集計
+    RomajiProfile profile;  // 遊んでいる人の打ち方の好み (入力例の選び方に使う)
+}Game;
+
+/* ------ プロトタイプ宣言 ------ */
+int game_init(Game *game, const Corpus *corpus, const GameLevel *level, unsigned long long seed,
+              double width, double spawnLine, double endLine); // ゲームを始める前の状態を作る
+void game_free(Game *game); // ゲームのメモリを解放する
+int game_key(Game *game, unsigned int ch, long long time); // キー入力を一つ判定する
+void game_step(Game *game); // 文字列の落下を一回進める
+int game_is_over(const Game *game); // ゲームが終わったかどうかを返す
+int game_score(const Game *game); // スコアを計算する
+int game_focus(const Game *game); // 仮名と入力例を表示する文字列の番号を返す
+double random_x_location(Str *strings, int indexNum, const SpanIndex *spawnSpans, Rng *rng); // ランダムにx座標を決めて、その値を返す関数
+void prepare_string(Str *strings, int strIndex, const Corpus *corpus,
+                    const RomajiProfile *profile); // 選ばれた文字列の入力例を必要な時だけ作る関数
+void set_string_example(Str *strings, int strIndex, const RomajiProfile *profile); // 入力位置を戻して全文の入力例をセットする関数
+void change_string_example(Str *strings, int strIndex, const RomajiProfile *profile); // 入力例と違う打ち方をした時に入力例を作り直す関数
+void layout_kana(Str *str); // 仮名の文字列の描画位置を計算する関数
+void layout_example(Str *str, int num); // 作った入力例の描画位置を計算する関数
+int check_input_char(Str *strings, int strIndex, unsigned int ch, RomajiProfile *learnProfile,
+                     const RomajiProfile *planProfile); // 入力された文字の正誤判定をし、場合によって入力例を書き換える
+
+#endif
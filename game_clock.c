@@ -0,0 +1,188 @@
+/*
+ * ゲームの時間を管理する時計
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#include "game_clock.h"
+
+/* ------ プロトタイプ宣言 ------ */
+static void rebase(GameClock *gameClock, long long real); // 指定した実際の時間を基準にし直す
+
+/**
+ * 実際の時間をナノ秒で返す
+ * システムの時計を合わせ直しても戻ったり飛んだりしない CLOCK_MONOTONIC を使う
+ *
+ * @return 実際の時間
+ */
+long long game_clock_real_ns(void){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+/**
+ * 時計をゲームの時間0から、実際の時間と同じ速さで動かし始める
+ *
+ * @param gameClock 時計
+ */
+void game_clock_init(GameClock *gameClock){
+    gameClock->baseReal = game_clock_real_ns();
+    gameClock->baseGame = 0;
+    gameClock->scale = 1.0;
+    gameClock->isPaused = 0;
+}
+
+/**
+ * ゲームの時間をナノ秒で返す
+ * 止まっている間は止めた時の時間を返す
+ *
+ * @param gameClock 時計
+ *
+ * @return ゲームの時間
+ */
+long long game_clock_now(const GameClock *gameClock){
+    return game_clock_at(gameClock, game_clock_real_ns());
+}
+
+/**
+ * 指定した実際の時間のゲームの時間をナノ秒で返す
+ * キー入力を、押された時間のゲームの時間で判定するのに使う
+ * 止まっている間は止めた時の時間を返し、基準にした時より前の時間は基準にした時の時間にする
+ *
+ * @param gameClock 時計
+ * @param real 実際の時間 (ナノ秒)
+ *
+ * @return ゲームの時間
+ */
+long long game_clock_at(const GameClock *gameClock, long long real){
+    long long elapsed; // 基準にしてから経った実際の時間
+
+    if(gameClock->isPaused == 1 || real <= gameClock->baseReal){
+        return gameClock->baseGame;
+    }
+    elapsed = real - gameClock->baseReal;
+    if(gameClock->scale == 1.0){ // 速さを変えていない時は整数のまま計算する
+        return gameClock->baseGame + elapsed;
+    }
+    return gameClock->baseGame + (long long)(elapsed * gameClock->scale);
+}
+
+/**
+ * 時計を止める
+ *
+ * @param gameClock 時計
+ */
+void game_clock_pause(GameClock *gameClock){
+    game_clock_pause_at(gameClock, game_clock_real_ns());
+}
+
+/**
+ * 指定した実際の時間に時計を止めたことにする
+ * 一時停止のキーが押された時間で止めるのに使う 基準にした時より前の時間は基準にした時にする
+ *
+ * @param gameClock 時計
+ * @param real 止めた実際の時間 (ナノ秒)
+ */
+void game_clock_pause_at(GameClock *gameClock, long long real){
+    if(gameClock->isPaused == 1){
+        return;
+    }
+    rebase(gameClock, real > gameClock->baseReal ? real : gameClock->baseReal);
+    gameClock->isPaused = 1;
+}
+
+/**
+ * 止めた時計を動かす 止めていた間の時間はゲームの時間に含めない
+ *
+ * @param gameClock 時計
+ */
+void game_clock_resume(GameClock *gameClock){
+    game_clock_resume_at(gameClock, game_clock_real_ns());
+}
+
+/**
+ * 指定した実際の時間に止めた時計を動かしたことにする 止めていた間の時間はゲームの時間に含めない
+ * 再開のキーが押された時間から動かすのに使う 止めた時より前の時間は止めた時にする
+ *
+ * @param gameClock 時計
+ * @param real 動かした実際の時間 (ナノ秒)
+ */
+void game_clock_resume_at(GameClock *gameClock, long long real){
+    if(gameClock->isPaused == 0){
+        return;
+    }
+    gameClock->baseReal = real > gameClock->baseReal ? real : gameClock->baseReal;
+    gameClock->isPaused = 0;
+}
+
+/**
+ * 時間の進む速さを変える これまでに進んだゲームの時間は変わらない
+ *
+ * @param gameClock 時計
+ * @param scale 実際の時間に対するゲームの時間の進む速さ (0より大きい値)
+ */
+void game_clock_set_scale(GameClock *gameClock, double scale){
+    if(scale <= 0){
+        return;
+    }
+    if(gameClock->isPaused == 0){
+        rebase(gameClock, game_clock_real_ns());
+    }
+    gameClock->scale = scale;
+}
+
+/**
+ * ナノ秒を秒に変換する
+ *
+ * @param ns ナノ秒
+ *
+ * @return 秒
+ */
+double game_clock_to_sec(long long ns){
+    return (double)ns / NS_PER_SEC;
+}
+
+/**
+ * 秒をナノ秒に変換する
+ *
+ * @param sec 秒
+ *
+ * @return ナノ秒
+ */
+long long game_clock_from_sec(double sec){
+    return (long long)(sec * NS_PER_SEC);
+}
+
+/**
+ * 指定した実際の時間まで眠る すでに過ぎている時は眠らない
+ *
+ * @param real 起きる実際の時間 (ナノ秒)
+ */
+void game_clock_sleep_until(long long real){
+    long long remaining = real - game_clock_real_ns(); // 起きるまでの時間
+    struct timespec ts;
+
+    if(remaining <= 0){
+        return;
+    }
+    ts.tv_sec = (time_t)(remaining / NS_PER_SEC);
+    ts.tv_nsec = (long)(remaining % NS_PER_SEC);
+    nanosleep(&ts, NULL);
+}
+
+/**
+ * 指定した実際の時間とその時のゲームの時間を基準にし直す
+ *
+ * @param gameClock 時計
+ * @param real 基準にする実際の時間 (ナノ秒)
+ */
+static void rebase(GameClock *gameClock, long long real){
+    if(gameClock->scale == 1.0){
+        gameClock->baseGame += real - gameClock->baseReal;
+    }else{
+        gameClock->baseGame += (long long)((real - gameClock->baseReal) * gameClock->scale);
+    }
+    gameClock->baseReal = real;
+}
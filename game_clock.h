@@ -0,0 +1,37 @@
+/*
+ * ゲームの時間を管理する時計
+ * CLOCK_MONOTONIC を元にした時間をナノ秒の整数で持つので、長く遊んだり一回のフレームが
+ * 長くなったりしても時間がずれず、システムの時計が合わせ直されても時間が飛ばない。
+ * 文字列を落とす間隔、落下、スコアの計算はすべてこの時計の時間を使う。
+ */
+
+#ifndef FALLTYPING_GAME_CLOCK_H
+#define FALLTYPING_GAME_CLOCK_H
+
+#define NS_PER_SEC 1000000000LL // 1秒のナノ秒
+
+/* ------ 構造体の宣言 ------*/
+// ゲームの時計
+// 止めた時や進む速さを変えた時に、その時の実際の時間とゲームの時間を基準にし直す
+typedef struct{
+    long long baseReal; // 基準にした実際の時間 (ナノ秒)
+    long long baseGame; // 基準にした時のゲームの時間 (ナノ秒)
+    double scale;       // 実際の時間に対するゲームの時間の進む速さ
+    int isPaused;       // 止まっているかどうか 0 : 動いている 1 : 止まっている
+}GameClock;
+
+/* ------ プロトタイプ宣言 ------ */
+long long game_clock_real_ns(void); // 実際の時間をナノ秒で返す
+void game_clock_init(GameClock *gameClock); // 時計をゲームの時間0から動かし始める
+long long game_clock_now(const GameClock *gameClock); // ゲームの時間をナノ秒で返す
+long long game_clock_at(const GameClock *gameClock, long long real); // 指定した実際の時間のゲームの時間を返す
+void game_clock_pause(GameClock *gameClock); // 時計を止める
+void game_clock_pause_at(GameClock *gameClock, long long real); // 指定した実際の時間に時計を止めたことにする
+void game_clock_resume(GameClock *gameClock); // 止めた時計を動かす
+void game_clock_resume_at(GameClock *gameClock, long long real); // 指定した実際の時間に止めた時計を動かしたことにする
+void game_clock_set_scale(GameClock *gameClock, double scale); // 時間の進む速さを変える
+double game_clock_to_sec(long long ns); // ナノ秒を秒に変換する
+long long game_clock_from_sec(double sec); // 秒をナノ秒に変換する
+void game_clock_sleep_until(long long real); // 指定した実際の時間まで眠る
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ * ゲームの決まり (難易度ごとの値とスコアの計算)
+ */
+
+#include "game_clock.h"
+#include "game_rules.h"
+
+/**
+ * 難易度ごとの落下速度、文字列を落とす間隔、終了に必要な文字列の数をセットする
+ * どれにでも入力できるか、調整するか、エンドレスかは難易度と別に決めるので、そのままにする
+ *
+ * @param level 難易度 (1 : Easy 2 : Normal 3 : Difficult)
+ * @param gameLevel 値をセットする構造体
+ *
+ * @return 0:成功 -1:難易度が範囲外
+ */
+int game_level_preset(int level, GameLevel *gameLevel){
+    static const double fallSpeeds[GAME_LEVEL_NUM] = {25.0, 30.0, 35.0}; // 難易度ごとの落下速度
+    static const double fallIntervals[GAME_LEVEL_NUM] = {2.0, 1.5, 0.8}; // 難易度ごとの文字列を落とす間隔 (秒)
+    static const int finishTypingNums[GAME_LEVEL_NUM] = {10, 15, 15}; // 難易度ごとの終了に必要な文字列の数
+
+    if(level < 1 || level > GAME_LEVEL_NUM){
+        return -1;
+    }
+    gameLevel->level = level;
+    gameLevel->fallSpeed = fallSpeeds[level - 1];
+    gameLevel->fallInterval = game_clock_from_sec(fallIntervals[level - 1]);
+    gameLevel->finishTypingNum = finishTypingNums[level - 1];
+    return 0;
+}
+
+/**
+ * スコアを計算する
+ * 1秒あたりの正しいキー入力の数に、正しく入力した割合を掛けて100倍する
+ *
+ * @param acceptNum 正しいキー入力の数
+ * @param failureNum 間違ったキー入力の数
+ * @param gameSec ゲームにかかった時間 (秒)
+ *
+ * @return スコア キー入力がない時と時間が進んでいない時は0
+ */
+int game_score_of(int acceptNum, int failureNum, double gameSec){
+    int keyNum = acceptNum + failureNum; // キー入力の数
+
+    if(keyNum == 0 || gameSec <= 0){
+        return 0;
+    }
+    return (int)(acceptNum / gameSec * ((double)acceptNum / keyNum) * 100);
+}
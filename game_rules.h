@@ -0,0 +1,29 @@
+/*
+ * ゲームの決まり (難易度ごとの値とスコアの計算)
+ *
+ * 画面で遊ぶゲーム、falltyping-server、falltyping-bench が同じ決まりで判定するように、ここだけに置く。
+ * ゲームの中身 (game.c) には依存しないので、サーバは描画や文字列の一覧を持たずにこれだけを使える。
+ */
+
+#ifndef FALLTYPING_GAME_RULES_H
+#define FALLTYPING_GAME_RULES_H
+
+#define GAME_LEVEL_NUM 3 // 難易度の数
+
+/* ------ 構造体の宣言 ------*/
+// 難易度ごとに決まる値
+typedef struct{
+    int level;              // 難易度 (1 : Easy 2 : Normal 3 : Difficult)
+    double fallSpeed;       // 落下速度
+    long long fallInterval; // 文字列を落下させ始める時間の間隔 (ナノ秒)
+    int finishTypingNum;    // ゲーム終了に必要なタイピング完了文字列数
+    int freeTarget;         // 落ちている文字列のどれにでも入力できるかどうか 0 : 一番早く落ち始めた文字列だけ 1 : どれにでも
+    int adaptive;           // 入力の速さに合わせて難易度を調整するかどうか 0 : 難易度ごとの値のまま 1 : 調整する
+    int endless;            // 終了の線に当たるまで続けるかどうか 0 : finishTypingNum で終わる 1 : 続ける
+}GameLevel;
+
+/* ------ プロトタイプ宣言 ------ */
+int game_level_preset(int level, GameLevel *gameLevel); // 難易度ごとの値をセットする
+int game_score_of(int acceptNum, int failureNum, double gameSec); // キー入力の数とかかった時間からスコアを計算する
+
+#endif
@@ -0,0 +1,193 @@
+/*
+ * ゲームを進めるスレッド
+ * 起きるたびに KeyRing を空になるまで読み出し、次の落下の実際の時間まで game_clock_sleep_until で眠る。
+ * 一時停止中もゲームの時間は進まないが、再開のキー入力を読み出すために同じ間隔で起きる。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "game_clock.h"
+#include "trace.h"
+#include "game_thread.h"
+
+/* ------ プロトタイプ宣言 ------ */
+static void *run(void *arg); // 落下を進めてキー入力を判定し続けるスレッド
+static void judge_key(GameThread *gameThread, GameClock *gameClock, const KeyPress *key); // キー入力を一つ判定する
+static void publish(GameThread *gameThread, const GameClock *gameClock, long long accumulator); // スナップショットを公開する
+
+/**
+ * ゲームの時計を動かし始めて、スレッドを動かす
+ * スレッドが動いている間はゲームと記録を触らず、game_thread_join の後に結果を読む
+ *
+ * @param gameThread スレッド
+ * @param game 進めるゲーム
+ * @param keys キー入力を受け取るスレッドから渡されるキー入力
+ * @param record キー入力を記録する記録 (NULLの時は記録しない)
+ * @param replay 再生する記録 (NULLの時は再生しない)
+ * @param timeScale ゲームの時間の進む速さ
+ *
+ * @return 0 : 成功 -1 : スレッドを作れなかった
+ */
+int game_thread_start(GameThread *gameThread, Game *game, KeyRing *keys, Replay *record, Replay *replay, double timeScale){
+    gameThread->game = game;
+    gameThread->keys = keys;
+    gameThread->record = record;
+    gameThread->replay = replay;
+    gameThread->timeScale = timeScale;
+    atomic_init(&gameThread->isStopping, 0);
+    snapshot_buffer_init(&gameThread->snapshots);
+    if(pthread_create(&gameThread->thread, NULL, run, gameThread) != 0){
+        printf("ゲームを進めるスレッドの作成に失敗しました\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 公開された一番新しいスナップショットを返す
+ * 描画するスレッドだけが使い、返したものは次にこの関数を呼ぶまで書き換えられない
+ *
+ * @param gameThread スレッド
+ *
+ * @return 一番新しいスナップショット
+ */
+const FrameSnapshot *game_thread_snapshot(GameThread *gameThread){
+    return snapshot_buffer_latest(&gameThread->snapshots);
+}
+
+/**
+ * スレッドを止めて、終わるまで待つ
+ * ゲームが終わってスレッドが自分で止まっている時は、終わったのを確かめるだけ
+ *
+ * @param gameThread スレッド
+ */
+void game_thread_join(GameThread *gameThread){
+    atomic_store(&gameThread->isStopping, 1);
+    pthread_join(gameThread->thread, NULL);
+}
+
+/**
+ * 落下を進めてキー入力を判定し続けるスレッド
+ * 渡されたキー入力を全て判定してから、前に進めた時からのゲームの時間の分だけ落下を進めてスナップショットを公開し、
+ * 次の落下の時間まで眠る ゲームが終わるか、止めるように指示されたら終わる
+ *
+ * @param arg スレッド (GameThread*)
+ *
+ * @return NULL
+ */
+static void *run(void *arg){
+    GameThread *gameThread = arg; // スレッド
+    Game *game = gameThread->game; // 進めるゲーム
+    GameClock gameClock; // ゲームの時計
+    long long simStep = NS_PER_SEC / SIM_RATE; // 文字列の落下を進める間隔 (ナノ秒)
+    long long lastTickTime; // 前に取得したゲームの時間 (ナノ秒)
+    long long accumulator = 0; // まだ落下を進めていない時間 (ナノ秒)
+    long long tmpTime; // 一時的に現在の時間を保存する変数 (ナノ秒)
+    long long wakeTime; // 次に起きるまでの実際の時間 (ナノ秒)
+    KeyPress key; // 読み出したキー入力
+    unsigned int replayCh; // 記録から取り出した入力された文字
+    long long keyTime; // 記録から取り出したキー入力のゲームの時間 (ナノ秒)
+
+    // ゲームの時計を動かし始める 時計の時間0がゲームの開始時間になる
+    game_clock_init(&gameClock);
+    game_clock_set_scale(&gameClock, gameThread->timeScale);
+    lastTickTime = game_clock_now(&gameClock);
+
+    while(atomic_load(&gameThread->isStopping) == 0){
+        /* ------ 入力の処理 ------ */
+        // 前に起きてから渡されたキー入力を、渡された順に全て判定する
+        // 入力し終えた時は、続けて渡されたキー入力を次の文字列に対して判定する
+        while(game_is_over(game) == 0 && key_ring_pop(gameThread->keys, &key) == 0){
+            judge_key(gameThread, &gameClock, &key);
+        }
+
+        /* ------ 時間の取得 ------ */
+        // 押された時間で一時停止した時は、前に取得した時間より少し前に戻ることがあるので、その時は進めない
+        tmpTime = game_clock_now(&gameClock);
+        if(tmpTime > lastTickTime){
+            accumulator += tmpTime - lastTickTime;
+            lastTickTime = tmpTime;
+        }
+        if(accumulator > simStep * MAX_SIM_STEPS){ // 処理が大きく遅れた時に、追いつこうとして止まらないようにする
+            accumulator = simStep * MAX_SIM_STEPS;
+        }
+
+        /* ------ 決まった間隔で文字列の落下を進める ------ */
+        // 新たに文字列を落とす処理、文字列の位置の更新、終了の線に当たったかの判定は game_step で行う
+        while(accumulator >= simStep && game_is_over(game) == 0){
+            // 記録を再生する時は、記録した回数の時に判定したキー入力を、落下を進める前に判定する
+            while(gameThread->replay != NULL && replay_next_key(gameThread->replay, game->step, &replayCh, &keyTime) == 0){
+                game_key(game, replayCh, keyTime);
+            }
+            if(game_is_over(game) == 1){
+                break;
+            }
+            accumulator -= simStep;
+            game_step(game);
+        }
+        publish(gameThread, &gameClock, accumulator);
+        if(game_is_over(game) == 1){
+            break;
+        }
+
+        /* ------ 次の落下まで眠る ------ */
+        // 一時停止中や時間を遅くしている時も、キー入力を待たせすぎないように実際の時間で1回の間隔より長くは眠らない
+        wakeTime = NS_PER_SEC / SIM_RATE;
+        if(gameClock.isPaused == 0 && (simStep - accumulator) / gameClock.scale < wakeTime){
+            wakeTime = (long long)((simStep - accumulator) / gameClock.scale);
+        }
+        game_clock_sleep_until(game_clock_real_ns() + wakeTime);
+    }
+    return NULL;
+}
+
+/**
+ * キー入力を一つ判定する
+ * Escキーは押された時間で一時停止と再開を切り替え、一時停止中と記録を再生している時は読み捨てる
+ * キー入力のゲームの時間は押された時間から求めるが、落下を進めたゲームの時間より前にはしない
+ * (押した直後に落ち始めた文字列の反応時間が負にならないようにする)
+ * 判定した時の落下を進めた回数とゲームの時間と一緒に記録する
+ *
+ * @param gameThread スレッド
+ * @param gameClock ゲームの時計
+ * @param key キー入力
+ */
+static void judge_key(GameThread *gameThread, GameClock *gameClock, const KeyPress *key){
+    Game *game = gameThread->game; // 進めるゲーム
+    long long keyTime; // キー入力のゲームの時間 (ナノ秒)
+
+    if(key->ch == ESC_KEY){
+        gameClock->isPaused == 1 ? game_clock_resume_at(gameClock, key->time) : game_clock_pause_at(gameClock, key->time);
+        return;
+    }
+    if(gameClock->isPaused == 1 || gameThread->replay != NULL){
+        return;
+    }
+    keyTime = game_clock_at(gameClock, key->time);
+    if(keyTime < game->nowTime){
+        keyTime = game->nowTime;
+    }
+    if(gameThread->record != NULL && replay_add_key(gameThread->record, game->step, keyTime, key->ch) != 0){
+        printf("記録を保存するメモリの確保に失敗しました\n");
+        exit(0);
+    }
+    game_key(game, key->ch, keyTime);
+}
+
+/**
+ * ゲームの状態を書き写して、スナップショットを公開する
+ *
+ * @param gameThread スレッド
+ * @param gameClock ゲームの時計
+ * @param accumulator まだ落下を進めていない時間 (ナノ秒)
+ */
+static void publish(GameThread *gameThread, const GameClock *gameClock, long long accumulator){
+    FrameSnapshot *snapshot = snapshot_buffer_begin(&gameThread->snapshots); // 書き込む場所
+
+    snapshot_capture(snapshot, gameThread->game);
+    snapshot->publishTime = game_clock_real_ns();
+    snapshot->accumulator = accumulator;
+    snapshot->timeScale = gameClock->scale;
+    snapshot->isPaused = gameClock->isPaused;
+    snapshot_buffer_publish(&gameThread->snapshots);
+}
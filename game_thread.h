@@ -0,0 +1,49 @@
+/*
+ * ゲームを進めるスレッド
+ *
+ * 文字列を落とす処理、落下、終了の線に当たったかの判定、キー入力の判定 (game_step と game_key) は全てこのスレッドで行い、
+ * 描画するスレッドは公開されたスナップショットを読むことしかしない。
+ * このスレッドは SIM_RATE 回/秒の決まった間隔で起き、キー入力を受け取るスレッドが KeyRing に書き込んだキー入力を
+ * 全て判定してから落下を進め、次の落下の時間まで眠る。描画に時間がかかっても判定の遅れは落下を進める間隔を超えず、
+ * 判定にはキーが押された時間を使うので、反応時間やキー入力の間隔は判定が遅れた分だけずれることがない。
+ *
+ * ゲームの時計、記録、一時停止もこのスレッドが持つので、キー入力を判定した時の回数と時間は一つのスレッドの中で決まり、
+ * 記録した内容は一つのスレッドで遊んだ時と同じように再生できる。
+ *
+ * コンパイル
+ *   -pthread を付けて、frame_snapshot.c key_ring.c と一緒にコンパイルする
+ */
+
+#ifndef FALLTYPING_GAME_THREAD_H
+#define FALLTYPING_GAME_THREAD_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "game.h"
+#include "replay.h"
+#include "frame_snapshot.h"
+#include "key_ring.h"
+
+#define ESC_KEY 27 // 一時停止と再開を切り替えるキー
+#define MAX_SIM_STEPS 8 // 一度に文字列の落下を進める最大の回数
+
+/* ------ 構造体の宣言 ------*/
+// ゲームを進めるスレッド
+typedef struct{
+    Game *game;             // 進めるゲーム (スレッドが動いている間は、このスレッドだけが触る)
+    Replay *record;         // キー入力を記録する記録 (NULLの時は記録しない)
+    Replay *replay;         // 再生する記録 (NULLの時は再生しない)
+    double timeScale;       // ゲームの時間の進む速さ
+    KeyRing *keys;          // キー入力を受け取るスレッドから渡されるキー入力
+    SnapshotBuffer snapshots; // 描画するスレッドに渡すスナップショット
+    pthread_t thread;       // スレッド
+    atomic_int isStopping;  // 止めるように指示されたかどうか
+}GameThread;
+
+/* ------ プロトタイプ宣言 ------ */
+int game_thread_start(GameThread *gameThread, Game *game, KeyRing *keys, Replay *record, Replay *replay,
+                      double timeScale); // ゲームの時計を動かし始めて、スレッドを動かす
+const FrameSnapshot *game_thread_snapshot(GameThread *gameThread); // 公開された一番新しいスナップショットを返す
+void game_thread_join(GameThread *gameThread); // スレッドを止めて、終わるまで待つ
+
+#endif
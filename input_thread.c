@@ -0,0 +1,65 @@
+/*
+ * キー入力を受け取るスレッド
+ * イベントは render_wait_event_timeout で待つので、止めるように指示されたら INPUT_WAIT_SEC 以内に終わる。
+ */
+
+#include <stdio.h>
+#include "render.h"
+#include "trace.h"
+#include "input_thread.h"
+
+/* ------ プロトタイプ宣言 ------ */
+static void *run(void *arg); // キー入力を待って、リングバッファに書き込み続けるスレッド
+
+/**
+ * スレッドを動かす
+ * 動いている間は、他のスレッドでイベントを受け取らない
+ *
+ * @param inputThread スレッド
+ * @param ring キー入力を書き込むリングバッファ
+ *
+ * @return 0 : 成功 -1 : スレッドを作れなかった
+ */
+int input_thread_start(InputThread *inputThread, KeyRing *ring){
+    inputThread->ring = ring;
+    atomic_init(&inputThread->isStopping, 0);
+    if(pthread_create(&inputThread->thread, NULL, run, inputThread) != 0){
+        printf("キー入力を受け取るスレッドの作成に失敗しました\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * スレッドを止めて、終わるまで待つ
+ *
+ * @param inputThread スレッド
+ */
+void input_thread_join(InputThread *inputThread){
+    atomic_store(&inputThread->isStopping, 1);
+    pthread_join(inputThread->thread, NULL);
+}
+
+/**
+ * キー入力を待って、リングバッファに書き込み続けるスレッド
+ * キーが押された時間はレンダラがイベントに付けた時間を使う
+ *
+ * @param arg スレッド (InputThread*)
+ *
+ * @return NULL
+ */
+static void *run(void *arg){
+    InputThread *inputThread = arg; // スレッド
+    RenderEvent *eventCtx; // 受け取ったイベント
+
+    while(atomic_load(&inputThread->isStopping) == 0){
+        eventCtx = render_wait_event_timeout(INPUT_WAIT_SEC);
+        if(eventCtx == NULL || eventCtx->type != RENDER_KEY_DOWN){
+            continue;
+        }
+        if(key_ring_push(inputThread->ring, eventCtx->ch, eventCtx->time) != 0){
+            TRACE("key_dropped %u", eventCtx->ch);
+        }
+    }
+    return NULL;
+}
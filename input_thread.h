@@ -0,0 +1,33 @@
+/*
+ * キー入力を受け取るスレッド
+ *
+ * ゲーム中はこのスレッドだけがイベントを受け取り、キー入力が来るまで待ち続ける。
+ * 受け取ったキー入力はキーが押された実際の時間と一緒に KeyRing に書き込み、ゲームを進めるスレッドが毎回全て読み出す。
+ * 描画するスレッドがフレームの間に眠っていても、描画に時間がかかっていても、キー入力は届いた時に受け取られる。
+ *
+ * コンパイル
+ *   -pthread を付けて、key_ring.c と一緒にコンパイルする
+ */
+
+#ifndef FALLTYPING_INPUT_THREAD_H
+#define FALLTYPING_INPUT_THREAD_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "key_ring.h"
+
+#define INPUT_WAIT_SEC 0.05 // 一度にイベントを待つ秒数 (止めるように指示されたかをこの間隔で確かめる)
+
+/* ------ 構造体の宣言 ------*/
+// キー入力を受け取るスレッド
+typedef struct{
+    KeyRing *ring;          // キー入力を書き込むリングバッファ
+    pthread_t thread;       // スレッド
+    atomic_int isStopping;  // 止めるように指示されたかどうか
+}InputThread;
+
+/* ------ プロトタイプ宣言 ------ */
+int input_thread_start(InputThread *inputThread, KeyRing *ring); // スレッドを動かす
+void input_thread_join(InputThread *inputThread); // スレッドを止めて、終わるまで待つ
+
+#endif
@@ -0,0 +1,62 @@
+/*
+ * キー入力を渡すリングバッファ
+ * 位置は増やし続け、配列の添字には KEY_RING_SIZE で割った余りを使う。
+ * 書き込んだキー入力は release で位置を進めてから見えるようにし、読み出す側は acquire で位置を読む。
+ */
+
+#include <stddef.h>
+#include "key_ring.h"
+
+/**
+ * 空のリングバッファを作る
+ *
+ * @param ring リングバッファ
+ */
+void key_ring_init(KeyRing *ring){
+    atomic_init(&ring->writePos, 0);
+    atomic_init(&ring->readPos, 0);
+    atomic_init(&ring->droppedNum, 0);
+}
+
+/**
+ * キー入力を書き込む 書き込むスレッドだけが使う
+ *
+ * @param ring リングバッファ
+ * @param ch 入力された文字
+ * @param time キーが押された実際の時間 (ナノ秒)
+ *
+ * @return 0 : 書き込んだ -1 : いっぱいで捨てた
+ */
+int key_ring_push(KeyRing *ring, unsigned int ch, long long time){
+    size_t writePos = atomic_load_explicit(&ring->writePos, memory_order_relaxed); // 書き込む位置
+    size_t readPos = atomic_load_explicit(&ring->readPos, memory_order_acquire); // 読み出す側が読み終えた位置
+
+    if(writePos - readPos >= KEY_RING_SIZE){
+        atomic_fetch_add_explicit(&ring->droppedNum, 1, memory_order_relaxed);
+        return -1;
+    }
+    ring->keys[writePos & (KEY_RING_SIZE - 1)].ch = ch;
+    ring->keys[writePos & (KEY_RING_SIZE - 1)].time = time;
+    atomic_store_explicit(&ring->writePos, writePos + 1, memory_order_release);
+    return 0;
+}
+
+/**
+ * 一番古いキー入力を読み出す 読み出すスレッドだけが使う
+ *
+ * @param ring リングバッファ
+ * @param key 読み出したキー入力を保存する変数
+ *
+ * @return 0 : 読み出した -1 : 空だった
+ */
+int key_ring_pop(KeyRing *ring, KeyPress *key){
+    size_t readPos = atomic_load_explicit(&ring->readPos, memory_order_relaxed); // 読み出す位置
+    size_t writePos = atomic_load_explicit(&ring->writePos, memory_order_acquire); // 書き込む側が書き終えた位置
+
+    if(readPos == writePos){
+        return -1;
+    }
+    *key = ring->keys[readPos & (KEY_RING_SIZE - 1)];
+    atomic_store_explicit(&ring->readPos, readPos + 1, memory_order_release);
+    return 0;
+}
@@ -0,0 +1,37 @@
+/*
+ * キー入力を受け取るスレッドからゲームを進めるスレッドへ、キー入力を渡すリングバッファ
+ *
+ * 書き込むスレッドと読み出すスレッドがそれぞれ一つだけの時に使う (SPSC)。
+ * 書き込む位置は書き込むスレッドだけが、読み出す位置は読み出すスレッドだけが進めるので、ロックを使わない。
+ * キー入力にはキーが押された実際の時間を付けるので、読み出すのが遅れても押された時間で判定できる。
+ * いっぱいの時は書き込まずに捨て、捨てた数を数えておく。
+ */
+
+#ifndef FALLTYPING_KEY_RING_H
+#define FALLTYPING_KEY_RING_H
+
+#include <stdatomic.h>
+
+#define KEY_RING_SIZE 1024 // リングバッファに保存できるキー入力の数 (2の累乗)
+
+/* ------ 構造体の宣言 ------*/
+// 一つのキー入力
+typedef struct{
+    unsigned int ch; // 入力された文字
+    long long time;  // キーが押された実際の時間 (ナノ秒)
+}KeyPress;
+
+// キー入力を渡すリングバッファ
+typedef struct{
+    KeyPress keys[KEY_RING_SIZE]; // キー入力
+    atomic_size_t writePos;       // 次に書き込む位置 (書き込むスレッドだけが進める)
+    atomic_size_t readPos;        // 次に読み出す位置 (読み出すスレッドだけが進める)
+    atomic_ullong droppedNum;     // いっぱいで捨てたキー入力の数
+}KeyRing;
+
+/* ------ プロトタイプ宣言 ------ */
+void key_ring_init(KeyRing *ring); // 空のリングバッファを作る
+int key_ring_push(KeyRing *ring, unsigned int ch, long long time); // キー入力を書き込む
+int key_ring_pop(KeyRing *ring, KeyPress *key); // 一番古いキー入力を読み出す
+
+#endif
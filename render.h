@@ -0,0 +1,58 @@
+/*
+ * 描画とイベントの受け取りを行う処理の共通の窓口
+ *
+ * ゲームは HandyGraphics を直接呼ばずにこの関数を使う。
+ * render_hg.c は HandyGraphics で描画し、render_headless.c は描画の回数を記録して
+ * スクリプトに書かれたキー入力を返すので、HandyGraphics がない環境でもゲームを動かせる。
+ *
+ * ゲーム中は描画するスレッドが描画とイベントの受け取りを行い、ゲームを進めるスレッドは文字列の描画範囲を調べる。
+ * どちらの実装も中で鍵を使うので、一回ずつの呼び出しは別のスレッドから呼んでよい。
+ * イベントを受け取るのは一つのスレッドだけにする (ゲーム中はキー入力を受け取るスレッド)。
+ */
+
+#ifndef FALLTYPING_RENDER_H
+#define FALLTYPING_RENDER_H
+
+#define RENDER_KEY_DOWN 1   // キー入力のイベント
+#define RENDER_MOUSE_DOWN 2 // マウスのクリックのイベント
+
+/* ------ 構造体の宣言 ------*/
+// 描画に使う色
+typedef enum{
+    RENDER_BLACK,
+    RENDER_WHITE,
+    RENDER_RED,
+    RENDER_ORANGE
+}RenderColor;
+
+// 受け取ったイベント
+typedef struct{
+    int type;        // イベントの種類 (RENDER_KEY_DOWN か RENDER_MOUSE_DOWN)
+    unsigned int ch; // 入力された文字
+    double x;        // クリックされたx座標
+    double y;        // クリックされたy座標
+    long long time;  // イベントが起きた実際の時間 (CLOCK_MONOTONIC のナノ秒)
+}RenderEvent;
+
+/* ------ プロトタイプ宣言 ------ */
+void render_open(double width, double height); // ウィンドウを開く
+void render_close(void); // ウィンドウを閉じる
+void render_clear(void); // ウィンドウの全てのレイヤを消す
+int render_add_layer(void); // レイヤを追加する
+int render_add_double_layer(void); // ダブルレイヤを追加する
+int render_switch_layer(int doubleLayerId); // ダブルレイヤの表示を切り替えて、描画するレイヤを返す
+void render_layer_clear(int layerId); // レイヤの描画を消す
+void render_set_font(int layerId, double size); // フォントの大きさを設定する
+void render_set_color(int layerId, RenderColor color); // 線と文字の色を設定する
+void render_set_fill_color(int layerId, RenderColor color); // 塗りつぶしの色を設定する
+void render_text(int layerId, double x, double y, const char *format, ...); // 文字列を描画する
+void render_text_size(int layerId, double *width, double *height, const char *format, ...); // 文字列の描画範囲を返す
+void render_line(int layerId, double x1, double y1, double x2, double y2); // 線を描画する
+void render_box(int layerId, double x, double y, double width, double height); // 四角形を描画する
+void render_box_fill(int layerId, double x, double y, double width, double height, int stroke); // 塗りつぶした四角形を描画する
+void render_set_event_mask(int mask); // 受け取るイベントの種類を設定する
+RenderEvent *render_wait_event(void); // イベントが来るまで待って返す
+RenderEvent *render_poll_event(void); // イベントがあれば返し、なければNULLを返す
+RenderEvent *render_wait_event_timeout(double timeout); // イベントが来るか、指定した秒数が経つまで待つ
+
+#endif
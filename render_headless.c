@@ -0,0 +1,507 @@
+/*
+ * ウィンドウを開かずに描画とイベントの受け取りを行う
+ *
+ * 描画は回数だけを記録し、イベントは環境変数 FALLTYPING_SCRIPT で指定したスクリプトから返す。
+ * render_close の時に、フレーム時間、フレームごとの描画の回数、
+ * キー入力が届く予定の時間から受け取るまでの遅れ、使ったCPU時間を標準エラー出力に書き出す。
+ * レイヤと描画の回数は鍵で守るので、描画するスレッドと描画範囲を調べるスレッドが別でもよい。
+ * イベントは一つのスレッドだけが受け取る。
+ *
+ * スクリプトは一行に一つの命令を書く。
+ *   wait ミリ秒        次のイベントまでの時間 (前のイベントを返してからの時間)
+ *   interval ミリ秒    type の文字の間の時間
+ *   mouse x y          マウスのクリック
+ *   key 文字           キー入力 (space はスペースキー)
+ *   type 文字列        文字列を一文字ずつキー入力する
+ *   # から始まる行は読み飛ばす
+ * 待っている時にスクリプトのイベントがなくなった時は、結果を書き出して終了する。
+ *
+ * コンパイル
+ *   cc -pthread -o falltyping-headless main.c romaji.c corpus.c corpus_image.c game_clock.c text_metrics.c trace.c active_list.c rng.c shuffle_bag.c span_index.c target_index.c game.c game_rules.c replay.c analytics.c difficulty.c frame_snapshot.c key_ring.c game_thread.c input_thread.c render_headless.c
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <pthread.h>
+#include "render.h"
+
+#define LAYER_MAX 64      // 作れるレイヤの数
+#define LINE_LEN 1024     // スクリプトの一行の長さ
+#define NS_PER_MS 1000000LL // 1ミリ秒のナノ秒
+#define NS_PER_SEC 1000000000LL // 1秒のナノ秒
+#define WAIT_FOREVER -1LL  // イベントが来るまで待つ時の待つ時間
+
+/* ------ 構造体の宣言 ------*/
+// スクリプトのイベント
+typedef struct{
+    RenderEvent event; // 返すイベント
+    long long delay;   // 前のイベントを返してからの時間 (ナノ秒)
+}ScriptEvent;
+
+// ダブルレイヤ
+typedef struct{
+    int layers[2]; // 交互に描画するレイヤ
+    int now;       // 今描画しているレイヤの番号
+}HeadlessDoubleLayer;
+
+/* ------ プロトタイプ宣言 ------ */
+static long long now_ns(void); // 今の時間をナノ秒で返す
+static long long cpu_ns(void); // 使ったCPU時間をナノ秒で返す
+static void load_script(void); // スクリプトを読み込む
+static void add_script_event(int type, unsigned int ch, double x, double y, long long delay); // スクリプトのイベントを追加する
+static RenderEvent *next_event(long long timeout); // 次のイベントを返す
+static void count_draw(void); // 描画の回数を数える
+static void print_stats(void); // 記録した結果を書き出す
+
+/* ------ グローバル変数の宣言 ------*/
+static ScriptEvent *script = NULL; // スクリプトのイベントの配列
+static int scriptNum = 0; // スクリプトのイベントの数
+static int scriptCapacity = 0; // 確保したイベントの数
+static int scriptIndex = 0; // 次に返すイベントの番号
+static long long lastEventTime = 0; // 最後にイベントを返した時間
+static int eventMask = RENDER_KEY_DOWN | RENDER_MOUSE_DOWN; // 受け取るイベントの種類
+static RenderEvent event; // 最後に返したイベント
+static double fontSize[LAYER_MAX]; // レイヤごとのフォントの大きさ
+static int layerNum = 0; // 作ったレイヤの数
+static HeadlessDoubleLayer doubleLayers[8]; // 作ったダブルレイヤ
+static int doubleLayerNum = 0; // 作ったダブルレイヤの数
+
+// 記録する結果
+static long long frameNum = 0; // フレームの数
+static long long frameTimeSum = 0; // フレーム時間の合計 (ナノ秒)
+static long long frameTimeMax = 0; // フレーム時間の最大 (ナノ秒)
+static long long lastFrameTime = 0; // 最後にフレームを切り替えた時間
+static long long drawNum = 0; // 全体の描画の回数
+static long long frameDrawNum = 0; // 今のフレームの描画の回数
+static long long frameDrawMax = 0; // フレームの描画の回数の最大
+static long long textSizeNum = 0; // 描画範囲を調べた回数
+static long long keyNum = 0; // 返したキー入力の数
+static long long latencySum = 0; // キー入力の遅れの合計 (ナノ秒)
+static long long latencyMax = 0; // キー入力の遅れの最大 (ナノ秒)
+static long long openTime = 0; // ウィンドウを開いた時間
+static long long openCpuTime = 0; // ウィンドウを開いた時の使ったCPU時間
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER; // レイヤと描画の回数を複数のスレッドから触るための鍵
+
+/**
+ * ウィンドウを開く代わりに、スクリプトを読み込む
+ */
+void render_open(double width, double height){
+    (void)width;
+    (void)height;
+    load_script();
+    lastEventTime = now_ns();
+    openTime = lastEventTime;
+    openCpuTime = cpu_ns();
+}
+
+/**
+ * 記録した結果を書き出す
+ */
+void render_close(void){
+    print_stats();
+    free(script);
+    script = NULL;
+    scriptNum = 0;
+    scriptCapacity = 0;
+}
+
+/**
+ * ウィンドウの全てのレイヤを消す代わりに、描画の回数を数える
+ */
+void render_clear(void){
+    count_draw();
+}
+
+/**
+ * レイヤを追加する
+ *
+ * @return レイヤのid
+ */
+int render_add_layer(void){
+    int layerId; // 追加したレイヤのid
+
+    pthread_mutex_lock(&lock);
+    if(layerNum >= LAYER_MAX){
+        layerId = LAYER_MAX - 1;
+    }else{
+        fontSize[layerNum] = 12;
+        layerNum++;
+        layerId = layerNum - 1;
+    }
+    pthread_mutex_unlock(&lock);
+    return layerId;
+}
+
+/**
+ * ダブルレイヤを追加する
+ *
+ * @return ダブルレイヤの番号 作れなかった時は-1
+ */
+int render_add_double_layer(void){
+    if(doubleLayerNum >= 8){
+        return -1;
+    }
+    doubleLayers[doubleLayerNum].layers[0] = render_add_layer();
+    doubleLayers[doubleLayerNum].layers[1] = render_add_layer();
+    doubleLayers[doubleLayerNum].now = 0;
+    doubleLayerNum++;
+    return doubleLayerNum - 1;
+}
+
+/**
+ * ダブルレイヤを切り替える
+ * 切り替えをフレームの区切りとして、フレーム時間と描画の回数を記録する
+ */
+int render_switch_layer(int doubleLayerId){
+    HeadlessDoubleLayer *layer = &doubleLayers[doubleLayerId]; // 切り替えるダブルレイヤ
+    long long now = now_ns(); // 今の時間
+    int layerId; // 描画するレイヤのid
+
+    pthread_mutex_lock(&lock);
+    if(lastFrameTime != 0){
+        long long frameTime = now - lastFrameTime; // 前のフレームからの時間
+        frameNum++;
+        frameTimeSum += frameTime;
+        if(frameTime > frameTimeMax)frameTimeMax = frameTime;
+        if(frameDrawNum > frameDrawMax)frameDrawMax = frameDrawNum;
+    }
+    lastFrameTime = now;
+    frameDrawNum = 0;
+    layer->now = 1 - layer->now;
+    layerId = layer->layers[layer->now];
+    pthread_mutex_unlock(&lock);
+    return layerId;
+}
+
+/**
+ * レイヤの描画を消す代わりに、描画の回数を数える
+ */
+void render_layer_clear(int layerId){
+    (void)layerId;
+    count_draw();
+}
+
+/**
+ * 描画範囲を計算するために、レイヤのフォントの大きさを覚えておく
+ */
+void render_set_font(int layerId, double size){
+    pthread_mutex_lock(&lock);
+    if(0 <= layerId && layerId < LAYER_MAX){
+        fontSize[layerId] = size;
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * 色は描画しないので何もしない
+ */
+void render_set_color(int layerId, RenderColor color){
+    (void)layerId;
+    (void)color;
+}
+
+/**
+ * 色は描画しないので何もしない
+ */
+void render_set_fill_color(int layerId, RenderColor color){
+    (void)layerId;
+    (void)color;
+}
+
+/**
+ * 文字列を描画する代わりに、描画の回数を数える
+ */
+void render_text(int layerId, double x, double y, const char *format, ...){
+    (void)layerId;
+    (void)x;
+    (void)y;
+    (void)format;
+    count_draw();
+}
+
+/**
+ * 文字列の描画範囲を返す
+ * ASCIIの文字はフォントの大きさの0.6倍、それ以外の文字はフォントの大きさと同じ幅とする
+ */
+void render_text_size(int layerId, double *width, double *height, const char *format, ...){
+    char text[LINE_LEN]; // 描画範囲を調べる文字列
+    double size = 12; // フォントの大きさ
+    va_list args;
+
+    pthread_mutex_lock(&lock);
+    if(0 <= layerId && layerId < LAYER_MAX){
+        size = fontSize[layerId];
+    }
+    textSizeNum++;
+    pthread_mutex_unlock(&lock);
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    *width = 0;
+    for(const unsigned char *p = (const unsigned char*)text; *p != '\0'; p++){
+        if(*p < 0x80){
+            *width += size * 0.6;
+        }else if((*p & 0xC0) != 0x80){ // 複数バイトの文字の先頭
+            *width += size;
+        }
+    }
+    *height = size;
+}
+
+/**
+ * 線を描画する代わりに、描画の回数を数える
+ */
+void render_line(int layerId, double x1, double y1, double x2, double y2){
+    (void)layerId;
+    (void)x1;
+    (void)y1;
+    (void)x2;
+    (void)y2;
+    count_draw();
+}
+
+/**
+ * 四角形を描画する代わりに、描画の回数を数える
+ */
+void render_box(int layerId, double x, double y, double width, double height){
+    (void)layerId;
+    (void)x;
+    (void)y;
+    (void)width;
+    (void)height;
+    count_draw();
+}
+
+/**
+ * 塗りつぶした四角形を描画する代わりに、描画の回数を数える
+ */
+void render_box_fill(int layerId, double x, double y, double width, double height, int stroke){
+    (void)layerId;
+    (void)x;
+    (void)y;
+    (void)width;
+    (void)height;
+    (void)stroke;
+    count_draw();
+}
+
+/**
+ * 受け取るイベントの種類を設定する
+ */
+void render_set_event_mask(int mask){
+    eventMask = mask;
+}
+
+/**
+ * スクリプトの次のイベントの時間まで待って返す
+ * スクリプトのイベントがなくなった時は、結果を書き出して終了する
+ */
+RenderEvent *render_wait_event(void){
+    RenderEvent *result = next_event(WAIT_FOREVER); // 返すイベント
+
+    if(result == NULL){
+        render_close();
+        exit(0);
+    }
+    return result;
+}
+
+/**
+ * スクリプトの次のイベントの時間になっていれば返す
+ */
+RenderEvent *render_poll_event(void){
+    return next_event(0);
+}
+
+/**
+ * スクリプトの次のイベントの時間か、指定した秒数が経つまで待つ
+ *
+ * @param timeout 待つ秒数
+ *
+ * @return イベント 時間が経った時やイベントがなくなった時はNULL
+ */
+RenderEvent *render_wait_event_timeout(double timeout){
+    long long timeoutNs = timeout > 0 ? (long long)(timeout * NS_PER_SEC) : 0; // 待つナノ秒
+    long long deadline = now_ns() + timeoutNs; // 待つのをやめる時間
+    RenderEvent *result = next_event(timeoutNs); // 返すイベント
+    long long now; // 今の時間
+
+    // スクリプトのイベントがなくなった時も、指定された時間は待つ
+    if(result == NULL && (now = now_ns()) < deadline){
+        struct timespec ts = {(time_t)((deadline - now) / NS_PER_SEC), (long)((deadline - now) % NS_PER_SEC)};
+        nanosleep(&ts, NULL);
+    }
+    return result;
+}
+
+/**
+ * 今の時間をナノ秒で返す
+ *
+ * @return 今の時間
+ */
+static long long now_ns(void){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+/**
+ * このプロセスが使ったCPU時間をナノ秒で返す
+ *
+ * @return 使ったCPU時間
+ */
+static long long cpu_ns(void){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (long long)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+/**
+ * 環境変数 FALLTYPING_SCRIPT で指定したスクリプトを読み込む
+ */
+static void load_script(void){
+    const char *path = getenv("FALLTYPING_SCRIPT"); // スクリプトのパス
+    char line[LINE_LEN]; // 読み込んだ行
+    char text[LINE_LEN]; // 命令の引数
+    long long delay = 0; // 次のイベントまでの時間
+    long long interval = 0; // type の文字の間の時間
+    double x, y; // クリックする座標
+    long ms; // 読み込んだミリ秒
+    FILE *fp; // スクリプトのファイルのポインタ
+
+    if(path == NULL){
+        return;
+    }
+    if((fp = fopen(path, "r")) == NULL){
+        fprintf(stderr, "ファイルのオープンに失敗しました\n%sがあるかを確認してください\n", path);
+        return;
+    }
+    while(fgets(line, sizeof(line), fp) != NULL){
+        line[strcspn(line, "\r\n")] = '\0';
+        if(line[0] == '#' || line[0] == '\0'){
+            continue;
+        }
+        if(sscanf(line, "wait %ld", &ms) == 1){
+            delay += ms * NS_PER_MS;
+        }else if(sscanf(line, "interval %ld", &ms) == 1){
+            interval = ms * NS_PER_MS;
+        }else if(sscanf(line, "mouse %lf %lf", &x, &y) == 2){
+            add_script_event(RENDER_MOUSE_DOWN, 0, x, y, delay);
+            delay = 0;
+        }else if(strcmp(line, "key space") == 0){
+            add_script_event(RENDER_KEY_DOWN, ' ', 0, 0, delay);
+            delay = 0;
+        }else if(sscanf(line, "key %1s", text) == 1){
+            add_script_event(RENDER_KEY_DOWN, (unsigned char)text[0], 0, 0, delay);
+            delay = 0;
+        }else if(strncmp(line, "type ", 5) == 0){
+            for(const char *p = line + 5; *p != '\0'; p++){
+                add_script_event(RENDER_KEY_DOWN, (unsigned char)*p, 0, 0, delay);
+                delay = interval;
+            }
+            delay = 0;
+        }else{
+            fprintf(stderr, "スクリプトの命令が正しくありません: %s\n", line);
+        }
+    }
+    fclose(fp);
+}
+
+/**
+ * スクリプトのイベントを追加する
+ */
+static void add_script_event(int type, unsigned int ch, double x, double y, long long delay){
+    if(scriptNum >= scriptCapacity){
+        int capacity = scriptCapacity == 0 ? 256 : scriptCapacity * 2; // 新しく確保する数
+        ScriptEvent *newScript = (ScriptEvent*) realloc(script, capacity * sizeof(ScriptEvent));
+        if(newScript == NULL){
+            return;
+        }
+        script = newScript;
+        scriptCapacity = capacity;
+    }
+    script[scriptNum].event.type = type;
+    script[scriptNum].event.ch = ch;
+    script[scriptNum].event.x = x;
+    script[scriptNum].event.y = y;
+    script[scriptNum].delay = delay;
+    scriptNum++;
+}
+
+/**
+ * スクリプトの次のイベントを返す
+ * 受け取らない種類のイベントは読み飛ばす
+ *
+ * @param timeout イベントの時間まで待つナノ秒 WAIT_FOREVER の時はイベントの時間まで待つ
+ *
+ * @return イベント 時間内に届かないか、イベントがなくなった時はNULL
+ */
+static RenderEvent *next_event(long long timeout){
+    long long deadline = timeout == WAIT_FOREVER ? 0 : now_ns() + timeout; // 待つのをやめる時間
+
+    while(scriptIndex < scriptNum){
+        ScriptEvent *next = &script[scriptIndex]; // 次のイベント
+        long long due = lastEventTime + next->delay; // イベントが届く予定の時間
+        long long now = now_ns(); // 今の時間
+
+        if(now < due){
+            long long wake = due; // 起きる時間
+
+            if(timeout != WAIT_FOREVER && deadline < due){
+                wake = deadline;
+            }
+            if(now < wake){
+                struct timespec ts = {(time_t)((wake - now) / NS_PER_SEC), (long)((wake - now) % NS_PER_SEC)};
+                nanosleep(&ts, NULL);
+                now = now_ns();
+            }
+            if(now < due){
+                return NULL;
+            }
+        }
+        scriptIndex++;
+        lastEventTime = now;
+        if((next->event.type & eventMask) == 0){
+            continue;
+        }
+        if(next->event.type == RENDER_KEY_DOWN){
+            keyNum++;
+            latencySum += now - due;
+            if(now - due > latencyMax)latencyMax = now - due;
+        }
+        event = next->event;
+        event.time = due; // スクリプトのキーは、届く予定の時間に押されたことにする
+        return &event;
+    }
+    return NULL;
+}
+
+/**
+ * 描画の回数を数える
+ */
+static void count_draw(void){
+    pthread_mutex_lock(&lock);
+    drawNum++;
+    frameDrawNum++;
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * 記録した結果を標準エラー出力に書き出す
+ */
+static void print_stats(void){
+    fprintf(stderr, "{\"frames\": %lld, \"frame_ms_avg\": %.3f, \"frame_ms_max\": %.3f, "
+                    "\"draw_calls\": %lld, \"draw_calls_per_frame_avg\": %.2f, \"draw_calls_per_frame_max\": %lld, "
+                    "\"text_size_calls\": %lld, \"keys\": %lld, \"input_latency_us_avg\": %.1f, \"input_latency_us_max\": %.1f, "
+                    "\"wall_ms\": %.1f, \"cpu_ms\": %.1f}\n",
+            frameNum, frameNum > 0 ? frameTimeSum / (double)frameNum / NS_PER_MS : 0.0, frameTimeMax / (double)NS_PER_MS,
+            drawNum, frameNum > 0 ? drawNum / (double)frameNum : 0.0, frameDrawMax,
+            textSizeNum, keyNum, keyNum > 0 ? latencySum / (double)keyNum / 1000.0 : 0.0, latencyMax / 1000.0,
+            (now_ns() - openTime) / (double)NS_PER_MS, (cpu_ns() - openCpuTime) / (double)NS_PER_MS);
+}
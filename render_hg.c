@@ -0,0 +1,345 @@
+/*
+ * HandyGraphics で描画とイベントの受け取りを行う
+ * HandyGraphics は複数のスレッドから同時に呼べないので、呼ぶ時は一つの鍵を持って一回ずつ呼ぶ。
+ * ゲーム中は描画するスレッドが描画し、ゲームを進めるスレッドが描画範囲を調べるが、お互いに待つのは一回の呼び出しの間だけになる。
+ *
+ * コンパイル
+ *   hgcc -pthread main.c romaji.c corpus.c corpus_image.c game_clock.c text_metrics.c trace.c active_list.c rng.c shuffle_bag.c span_index.c target_index.c game.c game_rules.c replay.c analytics.c difficulty.c frame_snapshot.c key_ring.c game_thread.c input_thread.c render_hg.c
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <time.h>
+#include <pthread.h>
+#include <handy.h>
+#include "render.h"
+
+#define DOUBLE_LAYER_MAX 8 // 作れるダブルレイヤの数
+#define TEXT_LEN 1024      // 一度に描画する文字列の長さ
+#define WAIT_SLICE 0.001   // イベントを待つ時に一度に眠る秒数
+
+/* ------ プロトタイプ宣言 ------ */
+static hgcolor hg_color(RenderColor color); // 色を HandyGraphics の色に変換する
+static double now_sec(void); // 今の時間を秒で返す
+static long long now_ns(void); // 今の時間をナノ秒で返す
+
+/* ------ グローバル変数の宣言 ------*/
+static doubleLayer doubleLayers[DOUBLE_LAYER_MAX]; // 作ったダブルレイヤ
+static int doubleLayerNum = 0; // 作ったダブルレイヤの数
+static RenderEvent event; // 最後に受け取ったイベント
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER; // HandyGraphics を一度に一つのスレッドだけが呼ぶための鍵
+
+/**
+ * ウィンドウを開く
+ *
+ * @param width ウィンドウの幅
+ * @param height ウィンドウの高さ
+ */
+void render_open(double width, double height){
+    pthread_mutex_lock(&lock);
+    HgOpen(width, height);
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * ウィンドウを閉じる
+ */
+void render_close(void){
+    pthread_mutex_lock(&lock);
+    HgClose();
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * ウィンドウの全てのレイヤを消す
+ */
+void render_clear(void){
+    pthread_mutex_lock(&lock);
+    HgClear();
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * レイヤを追加する
+ *
+ * @return レイヤのid
+ */
+int render_add_layer(void){
+    int layerId; // 追加したレイヤのid
+
+    pthread_mutex_lock(&lock);
+    layerId = HgWAddLayer(0);
+    pthread_mutex_unlock(&lock);
+    return layerId;
+}
+
+/**
+ * ダブルレイヤを追加する
+ *
+ * @return ダブルレイヤの番号 作れなかった時は-1
+ */
+int render_add_double_layer(void){
+    if(doubleLayerNum >= DOUBLE_LAYER_MAX){
+        return -1;
+    }
+    pthread_mutex_lock(&lock);
+    doubleLayers[doubleLayerNum] = HgWAddDoubleLayer(0);
+    pthread_mutex_unlock(&lock);
+    doubleLayerNum++;
+    return doubleLayerNum - 1;
+}
+
+/**
+ * ダブルレイヤの表示を切り替えて、描画するレイヤを返す
+ *
+ * @param doubleLayerId ダブルレイヤの番号
+ *
+ * @return 描画するレイヤのid
+ */
+int render_switch_layer(int doubleLayerId){
+    int layerId; // 描画するレイヤのid
+
+    pthread_mutex_lock(&lock);
+    layerId = HgLSwitch(&doubleLayers[doubleLayerId]);
+    pthread_mutex_unlock(&lock);
+    return layerId;
+}
+
+/**
+ * レイヤの描画を消す
+ *
+ * @param layerId レイヤのid
+ */
+void render_layer_clear(int layerId){
+    pthread_mutex_lock(&lock);
+    HgLClear(layerId);
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * フォントの大きさを設定する
+ *
+ * @param layerId レイヤのid
+ * @param size フォントの大きさ
+ */
+void render_set_font(int layerId, double size){
+    pthread_mutex_lock(&lock);
+    HgWSetFont(layerId, HG_M, size);
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * 線と文字の色を設定する
+ *
+ * @param layerId レイヤのid
+ * @param color 色
+ */
+void render_set_color(int layerId, RenderColor color){
+    pthread_mutex_lock(&lock);
+    HgWSetColor(layerId, hg_color(color));
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * 塗りつぶしの色を設定する
+ *
+ * @param layerId レイヤのid
+ * @param color 色
+ */
+void render_set_fill_color(int layerId, RenderColor color){
+    pthread_mutex_lock(&lock);
+    HgWSetFillColor(layerId, hg_color(color));
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * 文字列を描画する
+ *
+ * @param layerId レイヤのid
+ * @param x 描画するx座標
+ * @param y 描画するy座標
+ * @param format 描画する文字列の書式
+ */
+void render_text(int layerId, double x, double y, const char *format, ...){
+    char text[TEXT_LEN]; // 描画する文字列
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    pthread_mutex_lock(&lock);
+    HgWText(layerId, x, y, "%s", text);
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * 文字列の描画範囲を返す
+ *
+ * @param layerId レイヤのid
+ * @param width 描画範囲の幅を保存する変数
+ * @param height 描画範囲の高さを保存する変数
+ * @param format 文字列の書式
+ */
+void render_text_size(int layerId, double *width, double *height, const char *format, ...){
+    char text[TEXT_LEN]; // 描画範囲を調べる文字列
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    pthread_mutex_lock(&lock);
+    HgWTextSize(layerId, width, height, "%s", text);
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * 線を描画する
+ */
+void render_line(int layerId, double x1, double y1, double x2, double y2){
+    pthread_mutex_lock(&lock);
+    HgWLine(layerId, x1, y1, x2, y2);
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * 四角形を描画する
+ */
+void render_box(int layerId, double x, double y, double width, double height){
+    pthread_mutex_lock(&lock);
+    HgWBox(layerId, x, y, width, height);
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * 塗りつぶした四角形を描画する
+ */
+void render_box_fill(int layerId, double x, double y, double width, double height, int stroke){
+    pthread_mutex_lock(&lock);
+    HgWBoxFill(layerId, x, y, width, height, stroke);
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * 受け取るイベントの種類を設定する
+ *
+ * @param mask RENDER_KEY_DOWN と RENDER_MOUSE_DOWN の組み合わせ
+ */
+void render_set_event_mask(int mask){
+    int hgMask = 0; // HandyGraphics のイベントマスク
+
+    if(mask & RENDER_KEY_DOWN)hgMask |= HG_KEY_DOWN;
+    if(mask & RENDER_MOUSE_DOWN)hgMask |= HG_MOUSE_DOWN;
+    pthread_mutex_lock(&lock);
+    HgSetEventMask(hgMask);
+    pthread_mutex_unlock(&lock);
+}
+
+/**
+ * イベントが来るまで待って返す
+ * 待っている間は鍵を持たないので、他のスレッドが描画していない時だけ使う
+ *
+ * @return 受け取ったイベント
+ */
+RenderEvent *render_wait_event(void){
+    hgevent *eventCtx = HgEvent(); // HgEventの返り値
+
+    event.type = eventCtx->type == HG_KEY_DOWN ? RENDER_KEY_DOWN : RENDER_MOUSE_DOWN;
+    event.ch = (unsigned int)eventCtx->ch;
+    event.x = eventCtx->x;
+    event.y = eventCtx->y;
+    event.time = now_ns();
+    return &event;
+}
+
+/**
+ * イベントがあれば返し、なければNULLを返す
+ * HandyGraphics はイベントの時間を返さないので、受け取った時間をイベントの時間にする
+ *
+ * @return 受け取ったイベント
+ */
+RenderEvent *render_poll_event(void){
+    hgevent *eventCtx; // HgEventNonBlockingの返り値
+
+    pthread_mutex_lock(&lock);
+    eventCtx = HgEventNonBlocking();
+    if(eventCtx == NULL){
+        pthread_mutex_unlock(&lock);
+        return NULL;
+    }
+    event.type = eventCtx->type == HG_KEY_DOWN ? RENDER_KEY_DOWN : RENDER_MOUSE_DOWN;
+    event.ch = (unsigned int)eventCtx->ch;
+    event.x = eventCtx->x;
+    event.y = eventCtx->y;
+    pthread_mutex_unlock(&lock);
+    event.time = now_ns();
+    return &event;
+}
+
+/**
+ * イベントが来るか、指定した秒数が経つまで待つ
+ * HandyGraphics には時間を指定して待つ関数がないので、短い時間ずつ眠りながらイベントを確認する
+ * 眠っている間は鍵を持たないので、待っている間も他のスレッドは描画範囲を調べられる
+ *
+ * @param timeout 待つ秒数
+ *
+ * @return 受け取ったイベント 時間が経った時はNULL
+ */
+RenderEvent *render_wait_event_timeout(double timeout){
+    double deadline = now_sec() + timeout; // 待つのをやめる時間
+    RenderEvent *result; // 受け取ったイベント
+    double remaining; // 残りの秒数
+
+    while((result = render_poll_event()) == NULL){
+        remaining = deadline - now_sec();
+        if(remaining <= 0){
+            return NULL;
+        }
+        HgSleep(remaining < WAIT_SLICE ? remaining : WAIT_SLICE);
+    }
+    return result;
+}
+
+/**
+ * 色を HandyGraphics の色に変換する
+ *
+ * @param color 色
+ *
+ * @return HandyGraphics の色
+ */
+static hgcolor hg_color(RenderColor color){
+    switch(color){
+        case RENDER_WHITE:
+            return HG_WHITE;
+        case RENDER_RED:
+            return HG_RED;
+        case RENDER_ORANGE:
+            return HG_ORANGE;
+        case RENDER_BLACK:
+        default:
+            return HG_BLACK;
+    }
+}
+
+/**
+ * 今の時間を秒で返す
+ *
+ * @return 今の時間
+ */
+static double now_sec(void){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 0.000000001;
+}
+
+/**
+ * 今の時間をナノ秒で返す
+ *
+ * @return 今の時間
+ */
+static long long now_ns(void){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
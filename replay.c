@@ -0,0 +1,365 @@
+/*
+ * 遊んだ内容の記録と再生
+ * 形式は replay.h の先頭を参照。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "replay.h"
+
+#define REPLAY_HEADER_SIZE 76 // ヘッダの大きさ
+#define REPLAY_VARINT_MAX 10  // 可変長の数の最大のバイト数
+#define REPLAY_KEY_MAX (REPLAY_VARINT_MAX * 2 + 1) // 一つのキー入力の最大のバイト数
+
+/* ------ プロトタイプ宣言 ------ */
+static void put_u32(unsigned char *p, uint32_t value); // 32ビットの数をリトルエンディアンで書く
+static void put_u64(unsigned char *p, uint64_t value); // 64ビットの数をリトルエンディアンで書く
+static uint32_t get_u32(const unsigned char *p); // リトルエンディアンの32ビットの数を読む
+static uint64_t get_u64(const unsigned char *p); // リトルエンディアンの64ビットの数を読む
+static size_t put_varint(unsigned char *p, uint64_t value); // 7ビットずつの可変長で数を書く
+static int get_varint(const unsigned char *data, size_t size, size_t *pos, uint64_t *value); // 7ビットずつの可変長の数を読む
+
+/**
+ * 空の記録を作る
+ *
+ * @param replay 記録
+ * @param seed 乱数の種
+ * @param level 難易度ごとに決まる値
+ * @param wordNum 文字列の数
+ * @param corpusSum 文字列の仮名と入力判定の表のチェックサム (corpus_checksum)
+ */
+void replay_init(Replay *replay, unsigned long long seed, const GameLevel *level, int wordNum,
+                 unsigned int corpusSum){
+    replay->seed = seed;
+    replay->level = *level;
+    replay->wordNum = wordNum;
+    replay->corpusSum = corpusSum;
+    replay->keys = NULL;
+    replay->keyNum = 0;
+    replay->capacity = 0;
+    replay->next = 0;
+}
+
+/**
+ * 記録のメモリを解放する
+ *
+ * @param replay 記録
+ */
+void replay_free(Replay *replay){
+    free(replay->keys);
+    replay->keys = NULL;
+    replay->keyNum = 0;
+    replay->capacity = 0;
+    replay->next = 0;
+}
+
+/**
+ * キー入力を記録する
+ * 配列が足りなくなった時は倍の大きさに広げるので、追加はならして一定の時間で終わる
+ *
+ * @param replay 記録
+ * @param step 判定した時に文字列の落下を進めていた回数 (前のキー入力より小さくしない)
+ * @param time キー入力のゲームの時間 (ナノ秒) (前のキー入力より小さくしない)
+ * @param ch 入力された文字
+ *
+ * @return 0:成功 -1:メモリの確保に失敗
+ */
+int replay_add_key(Replay *replay, long long step, long long time, unsigned int ch){
+    if(replay->keyNum >= replay->capacity){
+        int capacity = replay->capacity > 0 ? replay->capacity * 2 : 256; // 広げた後の大きさ
+        ReplayKey *keys = (ReplayKey*) realloc(replay->keys, capacity * sizeof(ReplayKey)); // 広げた配列
+        if(keys == NULL){
+            return -1;
+        }
+        replay->keys = keys;
+        replay->capacity = capacity;
+    }
+    replay->keys[replay->keyNum].step = step;
+    replay->keys[replay->keyNum].time = time;
+    replay->keys[replay->keyNum].ch = (unsigned char)ch;
+    replay->keyNum++;
+    return 0;
+}
+
+/**
+ * 落下を進めた回数までに判定するキー入力があれば、一つ返して次に進める
+ *
+ * @param replay 記録
+ * @param step 今の落下を進めた回数
+ * @param ch 入力された文字を保存する変数
+ * @param time キー入力のゲームの時間を保存する変数
+ *
+ * @return 0:キー入力がある -1:ない
+ */
+int replay_next_key(Replay *replay, long long step, unsigned int *ch, long long *time){
+    if(replay->next >= replay->keyNum || replay->keys[replay->next].step > step){
+        return -1;
+    }
+    *ch = replay->keys[replay->next].ch;
+    *time = replay->keys[replay->next].time;
+    replay->next++;
+    return 0;
+}
+
+/**
+ * 最初のキー入力から再生し直す
+ *
+ * @param replay 記録
+ */
+void replay_rewind(Replay *replay){
+    replay->next = 0;
+}
+
+/**
+ * 描画せずに、ゲームが終わるまでできるだけ速く再生する
+ * 遊んだ時と同じように、落下を進める前にその回数までに判定したキー入力を判定する
+ *
+ * @param replay 記録
+ * @param game game_init で作った、まだ進めていないゲームの状態
+ */
+void replay_run(Replay *replay, Game *game){
+    unsigned int ch; // 入力された文字
+    long long time; // キー入力のゲームの時間
+
+    replay_rewind(replay);
+    while(game_is_over(game) == 0){
+        while(replay_next_key(replay, game->step, &ch, &time) == 0){
+            game_key(game, ch, time);
+        }
+        game_step(game);
+    }
+}
+
+/**
+ * 記録をファイルに書き出す
+ *
+ * @param replay 記録
+ * @param path 書き出すファイルのパス
+ *
+ * @return 0:成功 -1:失敗
+ */
+int replay_write(const Replay *replay, const char *path){
+    unsigned char header[REPLAY_HEADER_SIZE] = {0}; // ヘッダ
+    unsigned char *data; // キー入力の列
+    size_t size = 0; // キー入力の列の大きさ
+    long long before = 0; // 前のキー入力の回数
+    long long beforeTime = 0; // 前のキー入力のゲームの時間
+    uint64_t speedBits; // 落下速度のビット列
+    FILE *fp; // 書き出すファイルのポインタ
+    int result = 0; // 結果
+
+    data = (unsigned char*) malloc((size_t)replay->keyNum * REPLAY_KEY_MAX + 1);
+    if(data == NULL){
+        printf("記録を書き出すメモリの確保に失敗しました\n");
+        return -1;
+    }
+    for(int i = 0; i < replay->keyNum; i++){
+        size += put_varint(data + size, (uint64_t)(replay->keys[i].step - before));
+        size += put_varint(data + size, (uint64_t)(replay->keys[i].time - beforeTime));
+        data[size++] = replay->keys[i].ch;
+        before = replay->keys[i].step;
+        beforeTime = replay->keys[i].time;
+    }
+
+    memcpy(header, REPLAY_MAGIC, 8);
+    memcpy(&speedBits, &replay->level.fallSpeed, sizeof(speedBits));
+    put_u32(header + 8, REPLAY_VERSION);
+    put_u32(header + 12, SIM_RATE);
+    put_u32(header + 16, (uint32_t)replay->wordNum);
+    put_u64(header + 20, replay->seed);
+    put_u32(header + 28, (uint32_t)replay->level.level);
+    put_u64(header + 32, speedBits);
+    put_u64(header + 40, (uint64_t)replay->level.fallInterval);
+    put_u32(header + 48, (uint32_t)replay->level.finishTypingNum);
+    put_u32(header + 52, (uint32_t)replay->level.freeTarget);
+    put_u32(header + 56, (uint32_t)replay->level.adaptive);
+    put_u32(header + 60, (uint32_t)replay->level.endless);
+    put_u32(header + 64, (uint32_t)replay->keyNum);
+    put_u32(header + 68, (uint32_t)size);
+    put_u32(header + 72, (uint32_t)replay->corpusSum);
+
+    if((fp = fopen(path, "wb")) == NULL){
+        printf("ファイルのオープンに失敗しました\n%sに書き込めるかを確認してください\n", path);
+        free(data);
+        return -1;
+    }
+    if(fwrite(header, 1, sizeof(header), fp) != sizeof(header) || fwrite(data, 1, size, fp) != size){
+        printf("%sへの書き込みに失敗しました\n", path);
+        result = -1;
+    }
+    if(fclose(fp) != 0){
+        result = -1;
+    }
+    free(data);
+    return result;
+}
+
+/**
+ * 記録をファイルから読み込む
+ *
+ * @param replay 記録
+ * @param path 読み込むファイルのパス
+ *
+ * @return 0:成功 -1:失敗
+ */
+int replay_load(Replay *replay, const char *path){
+    unsigned char header[REPLAY_HEADER_SIZE]; // ヘッダ
+    unsigned char *data = NULL; // キー入力の列
+    size_t size; // キー入力の列の大きさ
+    size_t pos = 0; // 読んでいる位置
+    long long step = 0; // キー入力の回数
+    long long time = 0; // キー入力のゲームの時間
+    uint64_t delta, timeDelta; // 前のキー入力からの回数と時間の差
+    uint64_t speedBits; // 落下速度のビット列
+    GameLevel level; // 難易度ごとに決まる値
+    int keyNum; // キー入力の数
+    FILE *fp; // 読み込むファイルのポインタ
+
+    if((fp = fopen(path, "rb")) == NULL){
+        printf("ファイルのオープンに失敗しました\n%sがあるかを確認してください\n", path);
+        return -1;
+    }
+    if(fread(header, 1, sizeof(header), fp) != sizeof(header) || memcmp(header, REPLAY_MAGIC, 8) != 0
+       || get_u32(header + 8) != REPLAY_VERSION){
+        printf("%sが壊れているか、形式が違います\n", path);
+        fclose(fp);
+        return -1;
+    }
+    if(get_u32(header + 12) != SIM_RATE){
+        printf("%sは文字列の落下を進める回数が違うゲームで記録されています\n", path);
+        fclose(fp);
+        return -1;
+    }
+    keyNum = (int)get_u32(header + 64);
+    size = get_u32(header + 68);
+    if(keyNum < 0 || size > (size_t)keyNum * REPLAY_KEY_MAX || (data = (unsigned char*) malloc(size + 1)) == NULL
+       || fread(data, 1, size, fp) != size){
+        printf("%sの読み込みに失敗しました\n", path);
+        free(data);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+
+    speedBits = get_u64(header + 32);
+    level.level = (int)get_u32(header + 28);
+    memcpy(&level.fallSpeed, &speedBits, sizeof(level.fallSpeed));
+    level.fallInterval = (long long)get_u64(header + 40);
+    level.finishTypingNum = (int)get_u32(header + 48);
+    level.freeTarget = (int)get_u32(header + 52);
+    level.adaptive = (int)get_u32(header + 56);
+    level.endless = (int)get_u32(header + 60);
+    replay_init(replay, get_u64(header + 20), &level, (int)get_u32(header + 16), get_u32(header + 72));
+
+    for(int i = 0; i < keyNum; i++){
+        if(get_varint(data, size, &pos, &delta) != 0 || get_varint(data, size, &pos, &timeDelta) != 0 || pos >= size){
+            printf("%sが壊れているか、形式が違います\n", path);
+            free(data);
+            replay_free(replay);
+            return -1;
+        }
+        step += (long long)delta;
+        time += (long long)timeDelta;
+        if(replay_add_key(replay, step, time, data[pos++]) != 0){
+            printf("記録を読み込むメモリの確保に失敗しました\n");
+            free(data);
+            replay_free(replay);
+            return -1;
+        }
+    }
+    free(data);
+    return 0;
+}
+
+/**
+ * 32ビットの数をリトルエンディアンで書く
+ *
+ * @param p 書く位置
+ * @param value 数
+ */
+static void put_u32(unsigned char *p, uint32_t value){
+    for(int i = 0; i < 4; i++)p[i] = (unsigned char)(value >> (i * 8));
+}
+
+/**
+ * 64ビットの数をリトルエンディアンで書く
+ *
+ * @param p 書く位置
+ * @param value 数
+ */
+static void put_u64(unsigned char *p, uint64_t value){
+    for(int i = 0; i < 8; i++)p[i] = (unsigned char)(value >> (i * 8));
+}
+
+/**
+ * リトルエンディアンの32ビットの数を読む
+ *
+ * @param p 読む位置
+ *
+ * @return 数
+ */
+static uint32_t get_u32(const unsigned char *p){
+    uint32_t value = 0; // 読んだ数
+
+    for(int i = 3; i >= 0; i--)value = (value << 8) | p[i];
+    return value;
+}
+
+/**
+ * リトルエンディアンの64ビットの数を読む
+ *
+ * @param p 読む位置
+ *
+ * @return 数
+ */
+static uint64_t get_u64(const unsigned char *p){
+    uint64_t value = 0; // 読んだ数
+
+    for(int i = 7; i >= 0; i--)value = (value << 8) | p[i];
+    return value;
+}
+
+/**
+ * 7ビットずつの可変長で数を書く 下位の7ビットから書き、続きがあるバイトは最上位のビットを立てる
+ *
+ * @param p 書く位置 (REPLAY_VARINT_MAX バイト以上)
+ * @param value 数
+ *
+ * @return 書いたバイト数
+ */
+static size_t put_varint(unsigned char *p, uint64_t value){
+    size_t size = 0; // 書いたバイト数
+
+    while(value >= 0x80){
+        p[size++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    p[size++] = (unsigned char)value;
+    return size;
+}
+
+/**
+ * 7ビットずつの可変長の数を読む
+ *
+ * @param data 読む領域
+ * @param size 領域の大きさ
+ * @param pos 読む位置 読んだ後の位置に進める
+ * @param value 数を保存する変数
+ *
+ * @return 0:成功 -1:領域の終わりを越えたか、長すぎる
+ */
+static int get_varint(const unsigned char *data, size_t size, size_t *pos, uint64_t *value){
+    int shift = 0; // 読んだビット数
+
+    *value = 0;
+    do{
+        if(*pos >= size || shift >= 7 * REPLAY_VARINT_MAX){
+            return -1;
+        }
+        *value |= (uint64_t)(data[*pos] & 0x7f) << shift;
+        shift += 7;
+    }while(data[(*pos)++] & 0x80);
+    return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * 遊んだ内容の記録と再生
+ *
+ * 記録には乱数の種、難易度ごとに決まる値、キー入力の列を保存する。
+ * キー入力には、判定した時に文字列の落下を何回進めていたかを時間として付けるので、
+ * 再生する時は同じ回数の時に同じキーを判定すれば、遊んだ時と全く同じ結果になる。
+ * 集計に使うキー入力のゲームの時間も一緒に保存するので、キー入力の間隔や反応時間も同じになる。
+ *
+ * ファイルはヘッダとキー入力の列の順に並び、数値は全てリトルエンディアンで書く。
+ *   ヘッダ       REPLAY_MAGIC, 版, SIM_RATE, 文字列の数, 乱数の種, 難易度, 落下速度 (double のビット列),
+ *                文字列を落とす間隔, 終了に必要な数, どれにでも入力できるか, 難易度を調整するか, エンドレスか,
+ *                キー入力の数, キー入力の列のバイト数, 文字列の仮名と入力判定の表のチェックサム (corpus_checksum)
+ *   キー入力     前のキー入力からの回数の差、前のキー入力からの時間の差 (ナノ秒) (どちらも7ビットずつの可変長) と文字 (1バイト)
+ * 回数の差はほとんど1バイト、時間の差は4バイトなので、一つのキー入力はほとんど6バイトで済む。
+ * 文字列の数が同じでも仮名や拗音のパターンが違えば落ちる文字列や打ち方が変わるので、チェックサムが違う記録は再生しない。
+ */
+
+#ifndef FALLTYPING_REPLAY_H
+#define FALLTYPING_REPLAY_H
+
+#include "game.h"
+
+#define REPLAY_MAGIC "FTREPLAY" // ファイルの先頭の8バイト
+#define REPLAY_VERSION 5         // ファイルの形式の版
+
+/* ------ 構造体の宣言 ------*/
+// 記録した一つのキー入力
+typedef struct{
+    long long step;  // 判定した時に文字列の落下を進めていた回数
+    long long time;  // キー入力のゲームの時間 (ナノ秒)
+    unsigned char ch; // 入力された文字
+}ReplayKey;
+
+// 遊んだ内容の記録
+typedef struct{
+    unsigned long long seed; // 乱数の種
+    GameLevel level;         // 難易度ごとに決まる値
+    int wordNum;             // 記録した時の文字列の数
+    unsigned int corpusSum;  // 記録した時の文字列の仮名と入力判定の表のチェックサム
+    ReplayKey *keys;         // キー入力の列
+    int keyNum;              // キー入力の数
+    int capacity;            // 確保したキー入力の数
+    int next;                // 再生する時に次に判定するキー入力の番号
+}Replay;
+
+/* ------ プロトタイプ宣言 ------ */
+void replay_init(Replay *replay, unsigned long long seed, const GameLevel *level, int wordNum,
+                 unsigned int corpusSum); // 空の記録を作る
+void replay_free(Replay *replay); // 記録のメモリを解放する
+int replay_add_key(Replay *replay, long long step, long long time, unsigned int ch); // キー入力を記録する
+int replay_next_key(Replay *replay, long long step, unsigned int *ch, long long *time); // 落下を進めた回数までに判定するキー入力を一つ返す
+void replay_rewind(Replay *replay); // 最初のキー入力から再生し直す
+void replay_run(Replay *replay, Game *game); // 描画せずに、ゲームが終わるまでできるだけ速く再生する
+int replay_write(const Replay *replay, const char *path); // 記録をファイルに書き出す
+int replay_load(Replay *replay, const char *path); // 記録をファイルから読み込む
+
+#endif
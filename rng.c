@@ -0,0 +1,73 @@
+/*
+ * 種を指定できる乱数生成器 (PCG32)
+ * M.E. O'Neill の PCG-XSH-RR をそのまま実装している。
+ */
+
+#include "rng.h"
+
+/**
+ * 種と系列の番号で初期化する
+ *
+ * @param rng 乱数生成器
+ * @param seed 種
+ * @param sequence 系列の番号 (同じ種でも違う列を出したい時に変える)
+ */
+void rng_seed(Rng *rng, uint64_t seed, uint64_t sequence){
+    rng->state = 0;
+    rng->inc = (sequence << 1) | 1u;
+    rng_next(rng);
+    rng->state += seed;
+    rng_next(rng);
+}
+
+/**
+ * 32ビットの乱数を返す
+ *
+ * @param rng 乱数生成器
+ *
+ * @return 乱数
+ */
+uint32_t rng_next(Rng *rng){
+    uint64_t old = rng->state; // 進める前の状態
+    uint32_t xorShifted; // 状態を混ぜた値
+    uint32_t rot; // 回転する量
+
+    rng->state = old * 6364136223846793005ULL + rng->inc;
+    xorShifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+    rot = (uint32_t)(old >> 59);
+    return (xorShifted >> rot) | (xorShifted << ((-rot) & 31));
+}
+
+/**
+ * 0以上bound未満の偏りのない乱数を返す
+ * 余りで偏る範囲だけを捨てるので、捨てる確率は最大でも1/2で、ほとんどの場合は一回で決まる
+ *
+ * @param rng 乱数生成器
+ * @param bound 範囲の上限 (0の時は0を返す)
+ *
+ * @return 乱数
+ */
+uint32_t rng_range(Rng *rng, uint32_t bound){
+    uint32_t threshold; // これより小さい値は捨てる
+    uint32_t r; // 乱数
+
+    if(bound == 0){
+        return 0;
+    }
+    threshold = (-bound) % bound;
+    do{
+        r = rng_next(rng);
+    }while(r < threshold);
+    return r % bound;
+}
+
+/**
+ * 0以上1未満の乱数を返す
+ *
+ * @param rng 乱数生成器
+ *
+ * @return 乱数
+ */
+double rng_double(Rng *rng){
+    return rng_next(rng) * (1.0 / 4294967296.0);
+}
@@ -0,0 +1,24 @@
+/*
+ * 種を指定できる乱数生成器 (PCG32)
+ * 同じ種と系列の番号からは、どの環境でも同じ乱数の列が出るので、遊んだ内容を再現できる。
+ */
+
+#ifndef FALLTYPING_RNG_H
+#define FALLTYPING_RNG_H
+
+#include <stdint.h>
+
+/* ------ 構造体の宣言 ------*/
+// 乱数生成器の状態
+typedef struct{
+    uint64_t state; // 内部の状態
+    uint64_t inc;   // 系列ごとの増分 (奇数)
+}Rng;
+
+/* ------ プロトタイプ宣言 ------ */
+void rng_seed(Rng *rng, uint64_t seed, uint64_t sequence); // 種と系列の番号で初期化する
+uint32_t rng_next(Rng *rng); // 32ビットの乱数を返す
+uint32_t rng_range(Rng *rng, uint32_t bound); // 0以上bound未満の偏りのない乱数を返す
+double rng_double(Rng *rng); // 0以上1未満の乱数を返す
+
+#endif
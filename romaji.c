@@ -0,0 +1,1136 @@
+/*
+ * 仮名からローマ字への入力を判定するオートマトン
+ *
+ * [今の仮名][次の仮名] の組ごとに入力できるローマ字のパターンを集めてトライ木にし、
+ * 同じパターンの組は一つの木を共有する。
+ * 文字列ごとに持つのは木の上の現在の状態と、確定した仮名の数だけになる。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "romaji.h"
+
+#define PATTERN_MAX 16      // [今の仮名][次の仮名] の組で集めるパターンの最大の数
+#define SIGNATURE_LEN 192   // パターンの組を比較するための文字列の長さ
+#define SET_HASH_SIZE 2048  // パターンの組を探すハッシュ表の大きさ
+#define NAME_HASH_SIZE 2048 // 入力パターンの種類を探すハッシュ表の大きさ (ROMAJI_PROFILE_SIZE より十分大きくする)
+#define PATTERN_UNVISITED 0xFFFF // 入力パターンの種類の番号を付ける時に、まだたどっていない状態
+#define PATTERN_UNCOUNTED ROMAJI_PROFILE_SIZE // 入力し終わらないか、種類が多すぎて数えない状態
+#define KANA_BLOCK_FIRST 0x3000  // 直接引く表の最初のコードポイント (CJKの記号とひらがな、カタカナ)
+#define KANA_BLOCK_SIZE 0x100    // 直接引く表の大きさ
+#define KATAKANA_OFFSET 0x60     // カタカナからひらがなへのコードポイントの差
+
+/* ------ 構造体の宣言 ------*/
+// 一つの入力パターン
+typedef struct{
+    char str[ROMAJI_PATTERN_LEN]; // ローマ字の入力パターン
+    int accept;                   // 入力し終わった時に確定する仮名の数
+}RomajiPattern;
+
+// 一つの状態から入力し終えられる入力パターン (入力例の候補)
+typedef struct{
+    char str[ROMAJI_PATTERN_LEN]; // 状態から先の入力パターン
+    unsigned char len;            // str の文字数
+    unsigned char accept;         // 入力し終わった時に確定する仮名の数
+    unsigned char isRest;         // 状態の入力例 (表を作った時に後に追加したパターン) と同じかどうか
+    unsigned short pattern;       // 最初の状態からの入力パターンの種類の番号 (ROMAJI_PROFILE_SIZE 以上は数えない)
+}RomajiChoice;
+
+// 入力パターンの種類に番号を付けるためのハッシュ表の一つの場所
+typedef struct{
+    char str[ROMAJI_PATTERN_LEN]; // 最初の状態からの入力パターン (空の文字列は使っていない場所)
+    unsigned short pattern;       // 入力パターンの種類の番号
+}PatternName;
+
+// すでに作ったパターンの組
+typedef struct{
+    char signature[SIGNATURE_LEN]; // パターンの組を表す文字列
+    unsigned short root;           // 木の最初の状態
+}PatternSet;
+
+/* ------ プロトタイプ宣言 ------ */
+static void init_kana_index(void); // コードポイントから文字の番号を引く表を作る
+static int decode_utf8(const char *str, int *codePoint); // UTF-8の一文字をコードポイントに変換する
+static int root_node(const unsigned char *code, int len, int pos); // 指定した位置の仮名の最初の状態を返す
+static int add_pattern(RomajiPattern *patterns, int num, int accept, const char *format, ...); // パターンを追加する
+static int set_char_pattern(RomajiPattern *patterns, int num, int japaneseCharIndex); // 一文字の入力パターンを追加する
+static int collect_patterns(RomajiPattern *patterns, int nowCharIndex, int nextCharIndex,
+                            int youon[KANA_NUM][SMALL_KANA_NUM]); // 組の入力パターンを集める
+static int new_node(void); // 新しい状態を追加する
+static int build_tree(const RomajiPattern *patterns, int num); // パターンからトライ木を作る
+static int build_choices(void); // 状態ごとの入力し終えられる入力パターンの一覧を作る
+static int name_patterns(int node, char *str, int depth, PatternName *names,
+                         int *patternNum); // 入力し終わる状態に入力パターンの種類の番号を付ける
+static int collect_choices(int node, char *str, int depth, RomajiChoice *found, int num); // 状態から先の入力パターンを集める
+static int choose_pattern(const RomajiExample *example, int node, int pos, int len,
+                          const RomajiProfile *profile, const RomajiChoice **best); // 重みの一番小さい入力パターンを選ぶ
+static void profile_count(RomajiProfile *profile, int root, const char *input, int inputLen); // 確定した一つの入力パターンを数える
+
+/* ------ グローバル変数の宣言 ------*/
+RomajiTable romajiTable = {NULL, 0, NULL};
+static RomajiNode *ownNodes = NULL; // romaji_init で確保した状態の配列
+static unsigned short *ownRoot = NULL; // romaji_init で確保した最初の状態の表
+static int nodeCapacity = 0; // 確保した状態の数
+static signed char kanaIndex[KANA_BLOCK_SIZE]; // コードポイントごとの文字の番号 (-1は対応なし)
+static int kanaIndexReady = 0; // kanaIndex を作ったかどうか
+static RomajiChoice *choices = NULL; // 状態ごとの入力し終えられる入力パターンを、状態の順に並べた配列
+static int *choiceFirst = NULL; // 状態ごとの choices の最初の位置 (状態の数 + 1 個)
+static unsigned short *nodePattern = NULL; // 入力し終わる状態ごとの入力パターンの種類の番号
+
+// 母音を保管する配列
+static const char vowel[][2] = {"a","i","u","e","o"};
+
+// 子音を保管する配列
+static const char consonant[][3][4] = {{""},{"k"},{"s","sh"},{"t","ch"},{"n"},
+                                       {"h","f"},{"m"},{"y"},{"r"},{"g"},
+                                       {"z","j"},{"d"},{"b"},{"p"},{"v"},{"w"},{"wy"},
+                                       {"x","l"},{"xy","ly"},{"lt","xt"},{"lw","xw"},
+                                       {"n","nn"}};
+
+// 拗音に対応するための文字列を保管する配列
+static const char youonStr[][3][4] = {{""},{"y"},{"w"},{"h"},{"y","h"},
+                                      {"w","q"},{"f"},{"f","y"},{"v"},{"wh"},
+                                      {"wh","w"}};
+
+// ひらがなと伸ばし棒のデータを保管する配列
+static const char japaneseStr[] = "あいうえおかきくけこさしすせそたちつてとなにぬねのはひふへほまみむめもやいゆえよらりるれろ"
+                                  "がぎぐげござじずぜぞだぢづでどばびぶべぼぱぴぷぺぽあいゔえおわいうえをあゐうゑおぁぃぅぇぉゃぃゅぇょぁぃっぇぉゎぃぅぇぉんー";
+
+/**
+ * 拗音のパターンから入力判定の表を作る
+ * [今の仮名][次の仮名] の全ての組についてパターンを集め、同じ組の木は共有する
+ *
+ * @param youon 拗音がくるパターンを保存する二次元配列
+ *
+ * @return 0:成功 -1:失敗
+ */
+int romaji_init(int youon[KANA_NUM][SMALL_KANA_NUM]){
+    static PatternSet sets[SET_HASH_SIZE]; // 作ったパターンの組のハッシュ表
+    RomajiPattern patterns[PATTERN_MAX]; // 集めたパターン
+    char signature[SIGNATURE_LEN]; // 集めたパターンの組を表す文字列
+    unsigned int hash; // ハッシュ値を保存する変数
+    int num; // 集めたパターンの数
+    int len; // signature の長さ
+
+    romaji_free();
+    init_kana_index();
+    memset(sets, 0, sizeof(sets));
+    ownRoot = (unsigned short*) malloc(ROMAJI_ROOT_NUM * sizeof(unsigned short));
+    romajiTable.root = ownRoot;
+    if(ownRoot == NULL || new_node() != 0){ // 0番の状態は遷移なしを表すので使わない
+        romaji_free();
+        return -1;
+    }
+
+    for(int i = 0; i < JPN_CHAR_NUM; i++){
+        for(int j = 0; j <= JPN_CHAR_END; j++){
+            num = collect_patterns(patterns, i, j, youon);
+
+            // パターンの組を文字列にして、同じ組がすでにあるかを探す
+            len = 0;
+            signature[0] = '\0';
+            for(int k = 0; k < num; k++){
+                len += snprintf(signature + len, SIGNATURE_LEN - len, "%s:%d,", patterns[k].str, patterns[k].accept);
+            }
+            hash = 2166136261u;
+            for(int k = 0; k < len; k++){
+                hash = (hash ^ (unsigned char)signature[k]) * 16777619u;
+            }
+            hash %= SET_HASH_SIZE;
+            while(sets[hash].root != 0 && strcmp(sets[hash].signature, signature) != 0){
+                hash = (hash + 1) % SET_HASH_SIZE;
+            }
+            if(sets[hash].root == 0){ // 初めての組の時、木を作る
+                int root = build_tree(patterns, num);
+                if(root < 0){
+                    romaji_free();
+                    return -1;
+                }
+                sprintf(sets[hash].signature, "%s", signature);
+                sets[hash].root = (unsigned short)root;
+            }
+            ownRoot[i * (JPN_CHAR_END + 1) + j] = sets[hash].root;
+        }
+    }
+
+    if(build_choices() != 0){
+        romaji_free();
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 作成済みの入力判定の表を使う
+ * 表の領域は呼び出し側が持ち、romaji_free では解放しない
+ *
+ * @param nodes 状態の配列
+ * @param nodeNum 状態の数
+ * @param root [今の仮名][次の仮名] ごとの最初の状態の表
+ *
+ * @return 0:成功 -1:入力例を選ぶための一覧のメモリの確保に失敗
+ */
+int romaji_attach(const RomajiNode *nodes, int nodeNum, const unsigned short *root){
+    romaji_free();
+    romajiTable.nodes = nodes;
+    romajiTable.nodeNum = nodeNum;
+    romajiTable.root = root;
+    if(build_choices() != 0){
+        romaji_free();
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 入力判定の表を解放する
+ */
+void romaji_free(void){
+    free(ownNodes);
+    free(ownRoot);
+    free(choices);
+    free(choiceFirst);
+    free(nodePattern);
+    ownNodes = NULL;
+    ownRoot = NULL;
+    choices = NULL;
+    choiceFirst = NULL;
+    nodePattern = NULL;
+    romajiTable.nodes = NULL;
+    romajiTable.root = NULL;
+    romajiTable.nodeNum = 0;
+    nodeCapacity = 0;
+}
+
+/**
+ * 入力判定の表のチェックサムを、渡されたハッシュ値の続きから計算する (FNV-1a)
+ * 同じ拗音のパターンから作った表は、romaji_init で作っても romaji_attach で使っても同じ値になる
+ *
+ * @param hash ここまでのハッシュ値
+ *
+ * @return 表の状態と最初の状態の表を足したハッシュ値
+ */
+unsigned int romaji_table_checksum(unsigned int hash){
+    const RomajiNode *node; // 見ている状態
+
+    for(int i = 1; i < romajiTable.nodeNum; i++){
+        node = &romajiTable.nodes[i];
+        for(int j = 0; j < ROMAJI_CHAR_NUM; j++){
+            hash = (hash ^ (node->next[j] & 0xff)) * 16777619u;
+            hash = (hash ^ (node->next[j] >> 8)) * 16777619u;
+        }
+        hash = (hash ^ node->accept) * 16777619u;
+        hash = (hash ^ node->hasNext) * 16777619u;
+        hash = (hash ^ node->restAccept) * 16777619u;
+        for(int j = 0; j < ROMAJI_PATTERN_LEN && node->rest[j] != '\0'; j++){
+            hash = (hash ^ (unsigned char)node->rest[j]) * 16777619u;
+        }
+        hash = (hash ^ 0xffu) * 16777619u; // 状態の区切り
+    }
+    for(int i = 0; i < ROMAJI_ROOT_NUM; i++){
+        hash = (hash ^ (romajiTable.root[i] & 0xff)) * 16777619u;
+        hash = (hash ^ (romajiTable.root[i] >> 8)) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * 指定された日本語の文字の番号を返す
+ * ひらがな、カタカナ、伸ばし棒のコードポイントから表を直接引く
+ *
+ * @param str 日本語の文字が保存されている配列
+ * @param charIndex 日本語の文字を指定する番号
+ *
+ * @return 日本語の文字の番号を返す 対応していない文字は-1
+ */
+int get_japanese_index(const char *str, int charIndex){
+    int codePoint; // 文字のコードポイント
+
+    if(kanaIndexReady == 0){
+        init_kana_index();
+    }
+    if(decode_utf8(&str[charIndex], &codePoint) != 3){ // 対応している文字は全て3バイト
+        return -1;
+    }
+    if(KANA_BLOCK_FIRST <= codePoint && codePoint < KANA_BLOCK_FIRST + KANA_BLOCK_SIZE){
+        return kanaIndex[codePoint - KANA_BLOCK_FIRST];
+    }
+    switch(codePoint){
+        case 0x2015: // 水平線
+        case 0xFF0D: // 全角ハイフンマイナス
+        case 0xFF70: // 半角の伸ばし棒
+            return JPN_CHAR_BAR;
+        default:
+            return -1;
+    }
+}
+
+/**
+ * 仮名の文字列を文字の番号の列に変換する
+ * 対応していない文字があった時は、その手前までを変換する
+ *
+ * @param kana 仮名の文字列
+ * @param code 文字の番号を保存する配列
+ *
+ * @return 変換した仮名の数
+ */
+int romaji_decode_kana(const char *kana, unsigned char *code){
+    int len = (int)strlen(kana); // 文字列の長さを保存する変数
+    int num = 0; // 変換した仮名の数
+    int index; // 文字の番号を保存する変数
+
+    // 文字のバイト数が3なので、3ずつプラスしてループする
+    for(int i = 0; i + 3 <= len && num < KANA_LEN_MAX; i+=3){
+        index = get_japanese_index(kana, i);
+        if(index < 0)break;
+        code[num] = (unsigned char)index;
+        num++;
+    }
+    return num;
+}
+
+/**
+ * 入力位置を文字列の先頭に戻す
+ *
+ * @param cursor 入力位置
+ * @param code 文字の番号の列
+ * @param len 仮名の数
+ */
+void romaji_cursor_reset(RomajiCursor *cursor, const unsigned char *code, int len){
+    cursor->kanaPos = 0;
+    cursor->inputLen = 0;
+    cursor->kanaInput = 0;
+    cursor->node = len > 0 ? (unsigned short)root_node(code, len, 0) : 0;
+}
+
+/**
+ * 入力された文字の正誤判定を行い、入力位置を進める
+ * 「n」のように確定できるがまだ先がある状態で、先に進めない文字が入力された時は
+ * その仮名を確定して次の仮名の最初から判定する
+ *
+ * @param cursor 入力位置
+ * @param code 文字の番号の列
+ * @param len 仮名の数
+ * @param ch 入力されたアルファベット一文字
+ *
+ * @return 0:成功 -1:失敗 で入力の正誤を返す
+ */
+int romaji_input(RomajiCursor *cursor, const unsigned char *code, int len, unsigned int ch){
+    int charIndex = romaji_char_index(ch); // 遷移の番号
+    int kanaPos = cursor->kanaPos; // 確定した仮名の数
+    const RomajiNode *node; // 現在の状態
+    int next; // 遷移先の状態
+
+    if(charIndex < 0 || cursor->node == 0){
+        return -1;
+    }
+    node = &romajiTable.nodes[cursor->node];
+    next = node->next[charIndex];
+    if(next == 0){
+        if(node->accept == 0 || kanaPos + node->accept >= len){
+            return -1;
+        }
+        kanaPos += node->accept;
+        next = romajiTable.nodes[root_node(code, len, kanaPos)].next[charIndex];
+        if(next == 0){
+            return -1;
+        }
+        cursor->kanaInput = cursor->inputLen; // 入力された文字から次の仮名の入力が始まる
+    }
+
+    cursor->inputLen++;
+    node = &romajiTable.nodes[next];
+    if(node->accept > 0 && node->hasNext == 0){ // これ以上先がない時は確定する
+        kanaPos += node->accept;
+        next = kanaPos < len ? root_node(code, len, kanaPos) : 0;
+        cursor->kanaInput = cursor->inputLen;
+    }
+    cursor->kanaPos = (unsigned char)kanaPos;
+    cursor->node = (unsigned short)next;
+
+    return 0;
+}
+
+/**
+ * 文字列を一番長い打ち方で打ち終えた時のローマ字の数を返す
+ * 最後の仮名から順に、仮名ごとのその仮名から最後までの一番長い入力の長さを求める
+ * 入力判定の表は romaji_init か romaji_attach で用意しておく必要がある
+ *
+ * @param code 文字の番号の列
+ * @param len 仮名の数
+ *
+ * @return ローマ字の数 打ち終えられない時は-1
+ */
+int romaji_input_max(const unsigned char *code, int len){
+    int longest[KANA_LEN_MAX + 1]; // 仮名ごとの、その仮名から最後までの一番長い入力の長さ (-1は打ち終えられない)
+
+    if(len <= 0 || len > KANA_LEN_MAX){
+        return -1;
+    }
+    longest[len] = 0;
+    for(int pos = len - 1; pos >= 0; pos--){
+        int node = root_node(code, len, pos); // 仮名の最初の状態
+
+        longest[pos] = -1;
+        for(int i = choiceFirst[node]; i < choiceFirst[node + 1]; i++){
+            if(pos + choices[i].accept <= len && longest[pos + choices[i].accept] >= 0 &&
+               choices[i].len + longest[pos + choices[i].accept] > longest[pos]){
+                longest[pos] = choices[i].len + longest[pos + choices[i].accept];
+            }
+        }
+    }
+    return longest[0];
+}
+
+/**
+ * 入力位置から先の入力例を全て作る
+ * 最後の仮名から順に、仮名ごとのその仮名から最後までの一番小さい重みを求めてから、入力位置から選んでいく
+ *
+ * @param example 残りの入力例
+ * @param cursor 入力位置
+ * @param code 文字の番号の列
+ * @param len 仮名の数
+ * @param profile 打ち方の好み (NULL の時はキー入力の数だけで選ぶ)
+ *
+ * @return 作った入力例の文字数
+ */
+int romaji_example_reset(RomajiExample *example, const RomajiCursor *cursor, const unsigned char *code, int len,
+                         const RomajiProfile *profile){
+    const RomajiChoice *choice; // 選んだ入力パターン
+
+    memset(example->kanaHead, ROMAJI_EXAMPLE_NONE, sizeof(example->kanaHead));
+    example->text[ROMAJI_EXAMPLE_SIZE - 1] = '\0';
+    example->head = ROMAJI_EXAMPLE_SIZE - 1;
+    example->cost[len] = 0;
+    for(int pos = len - 1; pos > cursor->kanaPos; pos--){
+        example->cost[pos] = (short)choose_pattern(example, root_node(code, len, pos), pos, len, profile, &choice);
+    }
+    return romaji_example_plan(example, cursor, code, len, profile);
+}
+
+/**
+ * 打たれた文字が入力例の次の文字と同じ時は、入力例を一文字進める
+ *
+ * @param example 残りの入力例
+ * @param ch 打たれた文字 (romaji_input で正しいと判定された文字)
+ *
+ * @return 0:進めた -1:入力例と違う (romaji_example_plan で作り直す)
+ */
+int romaji_example_advance(RomajiExample *example, unsigned int ch){
+    if(example->head >= ROMAJI_EXAMPLE_SIZE - 1 || (unsigned char)example->text[example->head] != ch){
+        return -1;
+    }
+    example->head++;
+    return 0;
+}
+
+/**
+ * 入力位置の仮名から、前の入力例と同じ位置で区切れる仮名までの入力例を作り直して、残りの入力例の前に付け足す
+ * 仮名ごとに、入力パターンの重みと確定した後の仮名から最後までの重みの和が一番小さい入力パターンを選ぶ
+ * 区切れる仮名から先の入力例はそのまま使う。配列に収まらない時は、先の入力例を捨てて収まる所までにする
+ *
+ * @param example 残りの入力例 (cost は romaji_example_reset で入力位置より後の仮名の分を求めてある)
+ * @param cursor 入力位置
+ * @param code 文字の番号の列
+ * @param len 仮名の数
+ * @param profile 打ち方の好み (NULL の時はキー入力の数だけで選ぶ)
+ *
+ * @return 作り直した入力例の文字数 (text[head] から数える)
+ */
+int romaji_example_plan(RomajiExample *example, const RomajiCursor *cursor, const unsigned char *code, int len,
+                        const RomajiProfile *profile){
+    unsigned short nodes[KANA_LEN_MAX + 1]; // 作り直す入力例の状態 (先頭は入力位置の状態)
+    unsigned char starts[KANA_LEN_MAX + 1]; // それぞれの入力例が始まる仮名の位置
+    const RomajiChoice *chosen[KANA_LEN_MAX + 1]; // 選んだ入力例
+    int num = 0; // 作り直す入力例の数
+    int total = 0; // 作り直す入力例の文字数
+    int end = ROMAJI_EXAMPLE_SIZE - 1; // 作り直す入力例の後ろの端
+    int pos = cursor->kanaPos; // 作り直す入力例の次の仮名の位置
+    int restLen; // 一つの入力例の文字数
+
+    for(int node = cursor->node; node != 0 && pos < len && num <= KANA_LEN_MAX; ){
+        choose_pattern(example, node, pos, len, profile, &chosen[num]);
+        if(chosen[num] == NULL)break;
+        nodes[num] = (unsigned short)node;
+        starts[num] = (unsigned char)pos;
+        total += chosen[num]->len;
+        pos += chosen[num]->accept;
+        num++;
+        if(pos >= len || example->kanaHead[pos] != ROMAJI_EXAMPLE_NONE)break; // 前の入力例と同じ位置で区切れる
+        node = root_node(code, len, pos);
+    }
+    if(pos < len){
+        end = example->kanaHead[pos];
+    }
+    if(total > end){ // 収まらない時は先の入力例を捨てて、収まる所までにする
+        int dropFrom = pos; // 捨てる入力例の最初の仮名の位置
+
+        end = ROMAJI_EXAMPLE_SIZE - 1;
+        while(total > end){
+            num--;
+            total -= chosen[num]->len;
+            dropFrom = starts[num];
+        }
+        for(int i = dropFrom; i < len; i++){
+            example->kanaHead[i] = ROMAJI_EXAMPLE_NONE;
+        }
+    }
+
+    // 後ろから書いていく
+    pos = end;
+    for(int i = num - 1; i >= 0; i--){
+        restLen = chosen[i]->len;
+        pos -= restLen;
+        memcpy(example->text + pos, chosen[i]->str, restLen);
+        // 入力位置の状態は仮名の途中のことがあるので、仮名の最初の状態の時だけ区切りとして覚える
+        example->kanaHead[starts[i]] = (i > 0 || nodes[i] == root_node(code, len, starts[i])) ? (unsigned char)pos : ROMAJI_EXAMPLE_NONE;
+        for(int k = starts[i] + 1; k < starts[i] + chosen[i]->accept && k < len; k++){
+            example->kanaHead[k] = ROMAJI_EXAMPLE_NONE;
+        }
+    }
+    example->head = (unsigned char)pos;
+    return end - pos;
+}
+
+/**
+ * 入力位置を進めた時に確定した仮名の入力パターンを、打ち方の好みに数える
+ * 「n」のように次の文字で確定した時は、次の文字の前までをその仮名の入力パターンとする
+ *
+ * @param profile 打ち方の好み (NULL の時は何もしない)
+ * @param before 文字を入力する前の入力位置
+ * @param after 文字を入力した後の入力位置
+ * @param code 文字の番号の列
+ * @param len 仮名の数
+ * @param input 入力された文字列 (after->inputLen 文字)
+ */
+void romaji_profile_learn(RomajiProfile *profile, const RomajiCursor *before, const RomajiCursor *after,
+                          const unsigned char *code, int len, const char *input){
+    const RomajiNode *node; // 文字を入力する前の状態
+    int end = after->inputLen; // 確定した入力パターンの後ろの端
+    int start = before->kanaInput; // 確定した入力パターンの最初の位置
+    int pos = before->kanaPos; // 確定した入力パターンの最初の仮名の位置
+
+    if(profile == NULL || after->kanaPos == before->kanaPos || before->node == 0){
+        return;
+    }
+    node = &romajiTable.nodes[before->node];
+    if(node->next[romaji_char_index((unsigned char)input[end - 1])] == 0){ // 前の仮名を確定してから次の仮名に進んだ時
+        profile_count(profile, root_node(code, len, pos), input + start, end - 1 - start);
+        pos += node->accept;
+        if(after->kanaPos == pos){
+            return;
+        }
+        start = end - 1; // 入力された文字だけで次の仮名も確定した
+    }
+    profile_count(profile, root_node(code, len, pos), input + start, end - start);
+}
+
+/**
+ * 今の状態から遷移できる入力文字の集合を返す
+ * 入力位置を先頭に戻したカーソルなら、最初に打てる文字の集合になる
+ *
+ * @param cursor 入力位置
+ *
+ * @return 遷移の番号ごとのビットの集合 (ビット i が立っていれば遷移の番号 i の文字を打てる)
+ */
+unsigned int romaji_next_keys(const RomajiCursor *cursor){
+    const RomajiNode *node; // 今の状態
+    unsigned int keys = 0; // 打てる文字の集合
+
+    if(cursor->node == 0){
+        return 0;
+    }
+    node = &romajiTable.nodes[cursor->node];
+    for(int i = 0; i < ROMAJI_CHAR_NUM; i++){
+        if(node->next[i] != 0){
+            keys |= 1u << i;
+        }
+    }
+    return keys;
+}
+
+/**
+ * 今入力している仮名の入力パターンの番号を返す
+ * 番号は [今の仮名][次の仮名] の組の最初の状態なので、入力パターンが同じ組は同じ番号になる
+ *
+ * @param cursor 入力位置
+ * @param code 文字の番号の列
+ * @param len 仮名の数
+ *
+ * @return 入力パターンの番号 (0からromajiTable.nodeNum-1まで) 入力し終わっている時は-1
+ */
+int romaji_pattern_index(const RomajiCursor *cursor, const unsigned char *code, int len){
+    if(cursor->node == 0 || cursor->kanaPos >= len){
+        return -1;
+    }
+    return root_node(code, len, cursor->kanaPos);
+}
+
+/**
+ * 入力パターンの番号の入力例を返す
+ *
+ * @param pattern 入力パターンの番号
+ *
+ * @return 入力例 (「shi」や「kya」など)
+ */
+const char *romaji_pattern_str(int pattern){
+    return romajiTable.nodes[pattern].rest;
+}
+
+/**
+ * 仮名の番号の文字を返す
+ *
+ * @param index 仮名の番号
+ * @param name 文字を保存する配列 (4バイト以上)
+ */
+void romaji_kana_name(int index, char *name){
+    if(index < 0 || index >= JPN_CHAR_NUM){
+        name[0] = '\0';
+        return;
+    }
+    memcpy(name, japaneseStr + index * 3, 3);
+    name[3] = '\0';
+}
+
+/**
+ * 入力文字を遷移の番号に変換する
+ *
+ * @param ch 入力された文字
+ *
+ * @return 遷移の番号 対応していない文字は-1
+ */
+int romaji_char_index(unsigned int ch){
+    if('a' <= ch && ch <= 'z'){
+        return (int)(ch - 'a');
+    }else if(ch == '-'){
+        return ROMAJI_CHAR_NUM - 1;
+    }
+    return -1;
+}
+
+/**
+ * コードポイントから文字の番号を引く表を作る
+ * ひらがなは japaneseStr で最初に出てくる番号を使い、カタカナは対応するひらがなと同じ番号にする
+ */
+static void init_kana_index(void){
+    int codePoint; // 文字のコードポイント
+
+    memset(kanaIndex, -1, sizeof(kanaIndex));
+    for(int i = 0; japaneseStr[i] != '\0'; i+=3){
+        if(decode_utf8(&japaneseStr[i], &codePoint) == 0 ||
+           codePoint < KANA_BLOCK_FIRST || codePoint >= KANA_BLOCK_FIRST + KANA_BLOCK_SIZE){
+            continue; // 表に入らない文字は飛ばす
+        }
+        if(kanaIndex[codePoint - KANA_BLOCK_FIRST] < 0){ // 同じ文字が複数ある時は最初の番号を使う
+            kanaIndex[codePoint - KANA_BLOCK_FIRST] = (signed char)(i / 3);
+        }
+    }
+    // カタカナ (ァ~ヴ) をひらがなと同じ番号にする
+    for(codePoint = 0x30A1; codePoint <= 0x30F4; codePoint++){
+        kanaIndex[codePoint - KANA_BLOCK_FIRST] = kanaIndex[codePoint - KATAKANA_OFFSET - KANA_BLOCK_FIRST];
+    }
+    kanaIndexReady = 1;
+}
+
+/**
+ * UTF-8の一文字をコードポイントに変換する
+ *
+ * @param str 変換する文字
+ * @param codePoint コードポイントを保存する変数
+ *
+ * @return 文字のバイト数 正しくない文字の時は0
+ */
+static int decode_utf8(const char *str, int *codePoint){
+    const unsigned char *s = (const unsigned char*)str;
+
+    if(s[0] < 0x80){
+        *codePoint = s[0];
+        return s[0] == '\0' ? 0 : 1;
+    }else if((s[0] & 0xE0) == 0xC0 && (s[1] & 0xC0) == 0x80){
+        *codePoint = ((s[0] & 0x1F) << 6) | (s[1] & 0x3F);
+        return 2;
+    }else if((s[0] & 0xF0) == 0xE0 && (s[1] & 0xC0) == 0x80 && (s[2] & 0xC0) == 0x80){
+        *codePoint = ((s[0] & 0x0F) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+        return 3;
+    }
+    return 0;
+}
+
+/**
+ * 指定した位置の仮名の、次の仮名に応じた最初の状態を返す
+ *
+ * @param code 文字の番号の列
+ * @param len 仮名の数
+ * @param pos 仮名の位置
+ *
+ * @return 最初の状態の番号
+ */
+static int root_node(const unsigned char *code, int len, int pos){
+    int next = pos + 1 < len ? code[pos + 1] : JPN_CHAR_END; // 次の仮名の番号
+
+    return romajiTable.root[code[pos] * (JPN_CHAR_END + 1) + next];
+}
+
+/**
+ * 書式に従って作った入力パターンを追加する
+ *
+ * @param patterns パターンを保存する配列
+ * @param num 保存されているパターンの数
+ * @param accept 入力し終わった時に確定する仮名の数
+ * @param format パターンの書式
+ *
+ * @return 保存されているパターンの数
+ */
+static int add_pattern(RomajiPattern *patterns, int num, int accept, const char *format, ...){
+    va_list args;
+
+    if(num >= PATTERN_MAX){
+        return num;
+    }
+    va_start(args, format);
+    vsnprintf(patterns[num].str, ROMAJI_PATTERN_LEN, format, args);
+    va_end(args);
+    if(patterns[num].str[0] == '\0'){ // 空のパターンは追加しない
+        return num;
+    }
+    patterns[num].accept = accept;
+    return num + 1;
+}
+
+/**
+ * 指定された日本語の１文字の入力パターンを追加する
+ * 「っ」は「ltu」「xtu」「ltsu」「xtsu」のパターンのみを作成する
+ * 「ん」は「nn」のパターンのみを作成する
+ * 「つ」の「tsu」と、「か」「く」「こ」の「ca」「cu」「co」は、入力例に使われないように先に追加する
+ *
+ * @param patterns パターンを保存する配列
+ * @param num 保存されているパターンの数
+ * @param japaneseCharIndex 日本語の文字のを指定する変数
+ *
+ * @return 保存されているパターンの数
+ */
+static int set_char_pattern(RomajiPattern *patterns, int num, int japaneseCharIndex){
+
+    if(0 <= japaneseCharIndex && japaneseCharIndex < 5){
+        return add_pattern(patterns, num, 1, "%s", vowel[japaneseCharIndex]);
+    }else if((SMALL_KANA_FIRST_NUM <= japaneseCharIndex && japaneseCharIndex < SMALL_KANA_LAST_NUM) ||
+             japaneseCharIndex == JPN_CHAR_SI ||
+             japaneseCharIndex == JPN_CHAR_TI ||
+             japaneseCharIndex == JPN_CHAR_HU ||
+             japaneseCharIndex == JPN_CHAR_ZI) {
+        num = add_pattern(patterns, num, 1, "%s%s", consonant[japaneseCharIndex / 5][0], vowel[japaneseCharIndex % 5]);
+        if(consonant[japaneseCharIndex / 5][1][0] != '\0'){
+            num = add_pattern(patterns, num, 1, "%s%s", consonant[japaneseCharIndex / 5][1], vowel[japaneseCharIndex % 5]);
+        }
+        if(japaneseCharIndex == JPN_CHAR_LTU){
+            num = add_pattern(patterns, num, 1, "%ssu", consonant[japaneseCharIndex / 5][0]);
+            num = add_pattern(patterns, num, 1, "%ssu", consonant[japaneseCharIndex / 5][1]);
+        }
+        return num;
+    }else if(japaneseCharIndex == JPN_CHAR_TU) {
+        num = add_pattern(patterns, num, 1, "%s", "tsu");
+        return add_pattern(patterns, num, 1, "%s%s", consonant[japaneseCharIndex / 5][0], vowel[japaneseCharIndex % 5]);
+    }else if(japaneseCharIndex == JPN_CHAR_KA || japaneseCharIndex == JPN_CHAR_KU || japaneseCharIndex == JPN_CHAR_KO) {
+        num = add_pattern(patterns, num, 1, "c%s", vowel[japaneseCharIndex % 5]);
+        return add_pattern(patterns, num, 1, "%s%s", consonant[japaneseCharIndex / 5][0], vowel[japaneseCharIndex % 5]);
+    }else if(japaneseCharIndex == JPN_CHAR_NN) {
+        return add_pattern(patterns, num, 1, "%s", consonant[japaneseCharIndex / 5][1]);
+    }else if(japaneseCharIndex == JPN_CHAR_BAR) {
+        return add_pattern(patterns, num, 1, "%s", "-");
+    }else{
+        return add_pattern(patterns, num, 1, "%s%s", consonant[japaneseCharIndex / 5][0], vowel[japaneseCharIndex % 5]);
+    }
+}
+
+/**
+ * 今の仮名と次の仮名の組で入力できるパターンを集める
+ * 後に追加したパターンほど優先して入力例に使われる
+ *
+ * nowCharIndex / 5 : 母音の数を割ることで、 子音の番号と合わせる
+ * nextCharIndex % 5: 剰余算をする事で、母音の番号と合わせる
+ *
+ * @param patterns パターンを保存する配列
+ * @param nowCharIndex 今の仮名の番号
+ * @param nextCharIndex 次の仮名の番号 (文字列の終わりは JPN_CHAR_END)
+ * @param youon 拗音がくるパターンを保存する二次元配列
+ *
+ * @return 集めたパターンの数
+ */
+static int collect_patterns(RomajiPattern *patterns, int nowCharIndex, int nextCharIndex,
+                            int youon[KANA_NUM][SMALL_KANA_NUM]){
+    int num = set_char_pattern(patterns, 0, nowCharIndex); // 集めたパターンの数
+    int youonNum = -1; // 拗音のパターンを表す変数
+    const char *v; // 次の仮名の母音
+
+    // youon.txt の列は小書き文字の最初の16文字分 (後ろの重複した文字は get_japanese_index が返さない)
+    if(nowCharIndex < KANA_NUM && nextCharIndex >= SMALL_KANA_FIRST_NUM &&
+       nextCharIndex < SMALL_KANA_FIRST_NUM + SMALL_KANA_NUM) {
+        // 添字の番号を調整して、拗音のパターンの数字を代入
+        youonNum = youon[nowCharIndex][nextCharIndex - SMALL_KANA_FIRST_NUM];
+    }
+
+    if(youonNum > 0 && nextCharIndex != JPN_CHAR_LTU){ // youonNum > 0 : 拗音であることを表す
+        v = vowel[nextCharIndex % 5];
+        if(nowCharIndex == JPN_CHAR_U) {
+            num = add_pattern(patterns, num, 2, "%s%s", youonStr[youonNum][0], v);
+            if(youonNum == 10){
+                num = add_pattern(patterns, num, 2, "%s%s", youonStr[youonNum][1], v);
+            }
+        }else if(nowCharIndex == JPN_CHAR_KU){
+            num = add_pattern(patterns, num, 2, "%s%s%s", consonant[nowCharIndex / 5][0], youonStr[youonNum][0], v);
+            num = add_pattern(patterns, num, 2, "%s%s", youonStr[youonNum][1], v);
+        }else if(nowCharIndex == JPN_CHAR_TI) {
+            num = add_pattern(patterns, num, 2, "%s%s%s", consonant[nowCharIndex / 5][0], youonStr[youonNum][0], v);
+            if (youonNum == 4) {
+                num = add_pattern(patterns, num, 2, "%s%s", consonant[nowCharIndex / 5][1], v);
+            }
+        }else if(nowCharIndex == JPN_CHAR_SI){
+            num = add_pattern(patterns, num, 2, "%s%s%s", consonant[nowCharIndex / 5][0], youonStr[youonNum][0], v);
+            if(youonNum == 4){
+                num = add_pattern(patterns, num, 2, "%s%s%s", consonant[nowCharIndex / 5][0], youonStr[youonNum][1], v);
+            }
+        }else if(nowCharIndex == JPN_CHAR_HU || nowCharIndex == JPN_CHAR_VU){
+            if(youonNum == 6 || youonNum == 8){
+                num = add_pattern(patterns, num, 2, "%s%s", youonStr[youonNum][0], v);
+            }else if(youonNum == 7){
+                num = add_pattern(patterns, num, 2, "%s%s", youonStr[youonNum][0], v);
+                num = add_pattern(patterns, num, 2, "%s%s%s", consonant[nowCharIndex / 5][0], youonStr[youonNum][1], v);
+            }else{
+                num = add_pattern(patterns, num, 2, "%s%s%s", consonant[nowCharIndex / 5][0], youonStr[youonNum][0], v);
+            }
+        }else if(nowCharIndex == JPN_CHAR_ZI){
+            num = add_pattern(patterns, num, 2, "%s%s%s", consonant[nowCharIndex / 5][0], youonStr[youonNum][0], v);
+            num = add_pattern(patterns, num, 2, "%c%s", 'j', v);
+        }else{
+            num = add_pattern(patterns, num, 2, "%s%s%s", consonant[nowCharIndex / 5][0], youonStr[youonNum][0], v);
+        }
+    }else if(nowCharIndex == JPN_CHAR_LTU) {
+        // 次の文字が母音、な行以外の時、次の文字の子音を重ねる入力で「っ」だけを確定する
+        if(5 <= nextCharIndex && nextCharIndex < KANA_NUM && (nextCharIndex < 20 || nextCharIndex >= 25)){
+            RomajiPattern nextPatterns[PATTERN_MAX]; // 次の文字の入力パターン
+            int nextNum = set_char_pattern(nextPatterns, 0, nextCharIndex);
+            for(int i = 0; i < nextNum; i++){
+                char first = nextPatterns[i].str[0]; // 重ねる子音
+                if(strchr("aiueon", first) != NULL)continue;
+                num = add_pattern(patterns, num, 1, "%c", first);
+            }
+        }
+    }else if(nowCharIndex == JPN_CHAR_NN) {
+        // 次の文字があり、母音でないかつ、な行、や行ではなかった時、「n」をセットする
+        if ( 5 <= nextCharIndex && nextCharIndex < JPN_CHAR_NUM &&
+            (nextCharIndex < 20 || nextCharIndex >= 25) &&
+            (nextCharIndex < 35 || nextCharIndex >= 40) && nextCharIndex != JPN_CHAR_NN) {
+            num = add_pattern(patterns, num, 1, "%s", consonant[nowCharIndex / 5][0]);
+        }
+    }
+
+    return num;
+}
+
+/**
+ * 新しい状態を追加する
+ *
+ * @return 追加した状態の番号 失敗した時は-1
+ */
+static int new_node(void){
+    if(romajiTable.nodeNum >= nodeCapacity){
+        int capacity = nodeCapacity == 0 ? 1024 : nodeCapacity * 2;
+        RomajiNode *nodes; // 確保し直した状態の配列
+
+        if(capacity > 65535){ // 遷移先は unsigned short で持つので、これより多い状態は作れない
+            capacity = 65535;
+        }
+        if(romajiTable.nodeNum >= capacity){
+            return -1;
+        }
+        // 失敗しても元の配列は ownNodes に残り、romaji_free で解放される
+        nodes = (RomajiNode*) realloc(ownNodes, capacity * sizeof(RomajiNode));
+        if(nodes == NULL){
+            return -1;
+        }
+        ownNodes = nodes;
+        romajiTable.nodes = nodes;
+        nodeCapacity = capacity;
+    }
+    memset(&ownNodes[romajiTable.nodeNum], 0, sizeof(RomajiNode));
+    romajiTable.nodeNum++;
+    return romajiTable.nodeNum - 1;
+}
+
+/**
+ * 入力パターンからトライ木を作る
+ * 各状態の入力例には、その状態を通る最後のパターンを使う
+ *
+ * @param patterns 入力パターンの配列
+ * @param num パターンの数
+ *
+ * @return 木の最初の状態の番号 失敗した時は-1
+ */
+static int build_tree(const RomajiPattern *patterns, int num){
+    int root = new_node(); // 木の最初の状態
+    int now; // 今の状態
+    int next; // 次の状態
+
+    if(root < 0){
+        return -1;
+    }
+    for(int i = 0; i < num; i++){
+        now = root;
+        for(int j = 0; ; j++){
+            RomajiNode *node = &ownNodes[now];
+            // 入力パターンは ROMAJI_PATTERN_LEN - 1 文字までなので、残りの入力例は rest に収まる
+            snprintf(node->rest, sizeof(node->rest), "%.*s", (int)sizeof(node->rest) - 1, &patterns[i].str[j]);
+            node->restAccept = (unsigned char)patterns[i].accept;
+            if(patterns[i].str[j] == '\0'){
+                node->accept = (unsigned char)patterns[i].accept;
+                break;
+            }
+            int charIndex = romaji_char_index((unsigned char)patterns[i].str[j]);
+            if(charIndex < 0){
+                return -1;
+            }
+            next = node->next[charIndex];
+            if(next == 0){
+                next = new_node();
+                if(next < 0){
+                    return -1;
+                }
+                // new_node で配列が移動することがあるので添字で書き込む
+                ownNodes[now].next[charIndex] = (unsigned short)next;
+                ownNodes[now].hasNext = 1;
+            }
+            now = next;
+        }
+    }
+    return root;
+}
+
+
+/**
+ * 状態ごとの入力し終えられる入力パターンの一覧を作る
+ * 入力し終わる状態には、最初の状態からの入力パターンの文字列ごとに種類の番号を付けるので、
+ * 違う仮名の組の木でも同じ文字列の入力パターン (「shi」など) は同じ番号になる
+ *
+ * @return 0:成功 -1:メモリの確保に失敗
+ */
+static int build_choices(void){
+    static PatternName names[NAME_HASH_SIZE]; // 入力パターンの種類を探すハッシュ表
+    RomajiChoice found[PATTERN_MAX]; // 一つの状態から入力し終えられる入力パターン
+    char str[ROMAJI_PATTERN_LEN]; // 集める時に入力パターンを保存する配列
+    int nodeNum = romajiTable.nodeNum; // 状態の数
+    int patternNum = 0; // 番号を付けた入力パターンの種類の数
+    int capacity = nodeNum * 2; // choices に保存できる入力パターンの数
+    int total = 0; // choices に保存した入力パターンの数
+    int num; // 一つの状態から入力し終えられる入力パターンの数
+
+    memset(names, 0, sizeof(names));
+    nodePattern = (unsigned short*) malloc(nodeNum * sizeof(unsigned short));
+    choiceFirst = (int*) malloc((nodeNum + 1) * sizeof(int));
+    choices = (RomajiChoice*) malloc(capacity * sizeof(RomajiChoice));
+    if(nodePattern == NULL || choiceFirst == NULL || choices == NULL){
+        return -1;
+    }
+
+    // 最初の状態から木をたどって、入力し終わる状態に種類の番号を付ける (同じ木は一回だけたどる)
+    for(int i = 0; i < nodeNum; i++){
+        nodePattern[i] = PATTERN_UNVISITED;
+    }
+    for(int i = 0; i < ROMAJI_ROOT_NUM; i++){
+        int root = romajiTable.root[i]; // 木の最初の状態
+
+        if(root != 0 && root < nodeNum && nodePattern[root] == PATTERN_UNVISITED &&
+           name_patterns(root, str, 0, names, &patternNum) != 0){
+            return -1;
+        }
+    }
+
+    for(int i = 0; i < nodeNum; i++){
+        choiceFirst[i] = total;
+        num = i == 0 ? 0 : collect_choices(i, str, 0, found, 0);
+        if(total + num > capacity){
+            RomajiChoice *grown; // 大きくした配列
+
+            capacity = (total + num) * 2;
+            grown = (RomajiChoice*) realloc(choices, capacity * sizeof(RomajiChoice));
+            if(grown == NULL){
+                return -1;
+            }
+            choices = grown;
+        }
+        for(int k = 0; k < num; k++){
+            found[k].isRest = strcmp(found[k].str, romajiTable.nodes[i].rest) == 0;
+            choices[total++] = found[k];
+        }
+    }
+    choiceFirst[nodeNum] = total;
+    return 0;
+}
+
+/**
+ * 状態から先の入力し終わる状態に、最初の状態からの入力パターンの文字列ごとの種類の番号を付ける
+ * 種類が ROMAJI_PROFILE_SIZE を超えた入力パターンは数えない
+ *
+ * @param node 今の状態
+ * @param str 最初の状態から今の状態までの入力パターンを保存する配列
+ * @param depth 今の状態までの入力パターンの文字数
+ * @param names 入力パターンの種類を探すハッシュ表
+ * @param patternNum 番号を付けた入力パターンの種類の数
+ *
+ * @return 0:成功 -1:表が壊れている
+ */
+static int name_patterns(int node, char *str, int depth, PatternName *names, int *patternNum){
+    const RomajiNode *now = &romajiTable.nodes[node]; // 今の状態
+    unsigned int hash = 2166136261u; // 入力パターンのハッシュ値
+
+    nodePattern[node] = PATTERN_UNCOUNTED;
+    if(now->accept > 0 && depth > 0){
+        str[depth] = '\0';
+        for(int i = 0; i < depth; i++){
+            hash = (hash ^ (unsigned char)str[i]) * 16777619u;
+        }
+        hash %= NAME_HASH_SIZE;
+        while(names[hash].str[0] != '\0' && strcmp(names[hash].str, str) != 0){
+            hash = (hash + 1) % NAME_HASH_SIZE;
+        }
+        if(names[hash].str[0] != '\0'){
+            nodePattern[node] = names[hash].pattern;
+        }else if(*patternNum < ROMAJI_PROFILE_SIZE){ // 数えられる種類の数は NAME_HASH_SIZE より十分少ない
+            memcpy(names[hash].str, str, depth + 1);
+            names[hash].pattern = (unsigned short)*patternNum;
+            nodePattern[node] = names[hash].pattern;
+            (*patternNum)++;
+        }
+    }
+    if(now->hasNext == 0){
+        return 0;
+    }
+    if(depth + 1 >= ROMAJI_PATTERN_LEN){
+        return -1;
+    }
+    for(int i = 0; i < ROMAJI_CHAR_NUM; i++){
+        if(now->next[i] != 0 && now->next[i] < romajiTable.nodeNum){
+            str[depth] = i < ROMAJI_CHAR_NUM - 1 ? (char)('a' + i) : '-';
+            if(name_patterns(now->next[i], str, depth + 1, names, patternNum) != 0){
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * 状態から先に入力し終えられる入力パターンを全て集める
+ * 入力し終えられるがまだ先がある状態 (「ん」の「n」) は、そこで終わるパターンとその先のパターンの両方を集める
+ *
+ * @param node 今の状態
+ * @param str 今の状態までの入力パターンを保存する配列
+ * @param depth 今の状態までの入力パターンの文字数
+ * @param found 集めた入力パターンを保存する配列
+ * @param num 保存されている入力パターンの数
+ *
+ * @return 保存されている入力パターンの数
+ */
+static int collect_choices(int node, char *str, int depth, RomajiChoice *found, int num){
+    const RomajiNode *now = &romajiTable.nodes[node]; // 今の状態
+
+    if(now->accept > 0 && num < PATTERN_MAX){
+        memcpy(found[num].str, str, depth);
+        found[num].str[depth] = '\0';
+        found[num].len = (unsigned char)depth;
+        found[num].accept = now->accept;
+        found[num].isRest = 0;
+        found[num].pattern = nodePattern[node];
+        num++;
+    }
+    if(now->hasNext == 0 || depth + 1 >= ROMAJI_PATTERN_LEN){
+        return num;
+    }
+    for(int i = 0; i < ROMAJI_CHAR_NUM; i++){
+        if(now->next[i] != 0 && now->next[i] < romajiTable.nodeNum){
+            str[depth] = i < ROMAJI_CHAR_NUM - 1 ? (char)('a' + i) : '-';
+            num = collect_choices(now->next[i], str, depth + 1, found, num);
+        }
+    }
+    return num;
+}
+
+/**
+ * 状態から入力し終えられる入力パターンのうち、キー入力の数から打ち方の好みの分を引いた重みと、
+ * 確定した後の仮名から最後までの重みの和が一番小さいものを選ぶ
+ * 打ち方の好みの分は、同じ状態から打てる入力パターンの中でいつも使うものほど ROMAJI_PREFERENCE_COST に近くなる
+ * 重みが同じ時は、表を作った時に後に追加したパターン (状態の入力例) を選ぶ
+ *
+ * @param example 残りの入力例 (確定した後の仮名から最後までの重みを使う)
+ * @param node 今の状態
+ * @param pos 今の仮名の位置
+ * @param len 仮名の数
+ * @param profile 打ち方の好み (NULL の時はキー入力の数だけで選ぶ)
+ * @param best 選んだ入力パターンを保存する変数 (入力し終えられるパターンがない時は NULL)
+ *
+ * @return 選んだ入力パターンから最後までの重み
+ */
+static int choose_pattern(const RomajiExample *example, int node, int pos, int len,
+                          const RomajiProfile *profile, const RomajiChoice **best){
+    const RomajiChoice *found = &choices[choiceFirst[node]]; // 入力し終えられる入力パターン
+    int num = choiceFirst[node + 1] - choiceFirst[node]; // 入力パターンの数
+    int total = ROMAJI_PREFERENCE_PRIOR; // 打たれた回数の合計
+    int bestCost = 0; // 選んだ入力パターンから最後までの重み
+    int cost; // 入力パターンから最後までの重み
+
+    *best = NULL;
+    if(profile != NULL && num > 1){
+        for(int i = 0; i < num; i++){
+            if(found[i].pattern < ROMAJI_PROFILE_SIZE){
+                total += profile->count[found[i].pattern];
+            }
+        }
+    }
+    for(int i = 0; i < num; i++){
+        cost = ROMAJI_KEY_COST * found[i].len;
+        if(total > ROMAJI_PREFERENCE_PRIOR && found[i].pattern < ROMAJI_PROFILE_SIZE){
+            cost -= ROMAJI_PREFERENCE_COST * profile->count[found[i].pattern] / total;
+        }
+        if(pos + found[i].accept < len){
+            cost += example->cost[pos + found[i].accept];
+        }
+        if(*best == NULL || cost < bestCost || (cost == bestCost && found[i].isRest == 1)){
+            *best = &found[i];
+            bestCost = cost;
+        }
+    }
+    return bestCost;
+}
+
+/**
+ * 確定した一つの入力パターンを数える
+ * 仮名に打ち方が一つしかない時は好みが分からないので数えない
+ * 回数が ROMAJI_PROFILE_MAX に達したら全ての回数を半分にするので、打ち方を変えるとそのうち入力例も変わる
+ *
+ * @param profile 打ち方の好み
+ * @param root 確定した仮名の最初の状態
+ * @param input 入力パターンの最初の文字
+ * @param inputLen 入力パターンの文字数
+ */
+static void profile_count(RomajiProfile *profile, int root, const char *input, int inputLen){
+    int node = root; // 入力パターンをたどった状態
+    int pattern; // 入力パターンの種類の番号
+
+    if(choiceFirst[root + 1] - choiceFirst[root] < 2){
+        return;
+    }
+    for(int i = 0; i < inputLen && node != 0; i++){
+        node = romajiTable.nodes[node].next[romaji_char_index((unsigned char)input[i])];
+    }
+    pattern = node != 0 ? nodePattern[node] : PATTERN_UNCOUNTED;
+    if(pattern >= ROMAJI_PROFILE_SIZE){
+        return;
+    }
+    profile->count[pattern]++;
+    if(profile->count[pattern] >= ROMAJI_PROFILE_MAX){
+        for(int i = 0; i < ROMAJI_PROFILE_SIZE; i++){
+            profile->count[i] /= 2;
+        }
+    }
+}
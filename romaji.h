@@ -0,0 +1,113 @@
+/*
+ * 仮名からローマ字への入力を判定するオートマトン
+ * 全ての文字列で一つの表を共有し、各文字列は RomajiCursor だけを持つ。
+ * 一回のキー入力は表の遷移一回（「ん」の確定時のみ二回）で判定する。
+ */
+
+#ifndef FALLTYPING_ROMAJI_H
+#define FALLTYPING_ROMAJI_H
+
+#define KANA_NUM 85
+#define SMALL_KANA_NUM 16
+#define SMALL_KANA_FIRST_NUM 85
+#define SMALL_KANA_LAST_NUM 105
+#define JPN_CHAR_U 2
+#define JPN_CHAR_KA 5
+#define JPN_CHAR_KU 7
+#define JPN_CHAR_KO 9
+#define JPN_CHAR_SI 11
+#define JPN_CHAR_TI 16
+#define JPN_CHAR_TU 17
+#define JPN_CHAR_HU 27
+#define JPN_CHAR_ZI 51
+#define JPN_CHAR_VU 72
+#define JPN_CHAR_LTU 97
+#define JPN_CHAR_NN 105
+#define JPN_CHAR_BAR 106
+#define JPN_CHAR_NUM 107           // 仮名と伸ばし棒の種類の数
+#define JPN_CHAR_END JPN_CHAR_NUM  // 文字列の終端を表す番号
+#define ROMAJI_CHAR_NUM 27         // 入力に使う文字の種類の数 (a~z と -)
+#define ROMAJI_PATTERN_LEN 8       // 一つの入力パターンの最大の長さ
+#define KANA_LEN_MAX 86            // 一つの文字列の仮名の最大の数
+#define ROMAJI_ROOT_NUM (JPN_CHAR_NUM * (JPN_CHAR_END + 1)) // 最初の状態の表の大きさ
+#define ROMAJI_EXAMPLE_SIZE 128    // 入力例を保存する配列の大きさ
+#define ROMAJI_INPUT_MAX (ROMAJI_EXAMPLE_SIZE - 1) // 一つの文字列に打てるローマ字の最大の数
+#define ROMAJI_EXAMPLE_NONE 0xFF   // その仮名から始まる入力例がないことを表す位置
+#define ROMAJI_KEY_COST 16         // 入力例を選ぶ時の、キー入力一回の重み
+#define ROMAJI_PREFERENCE_COST 48  // いつも使う打ち方の入力パターンの重みから引く最大の値 (キー入力三回分)
+#define ROMAJI_PREFERENCE_PRIOR 2  // 打ち方の好みの割合を出す時に、打たれた回数の合計に足す数
+#define ROMAJI_PROFILE_SIZE 512    // 打ち方の好みを数える入力パターンの種類の最大の数
+#define ROMAJI_PROFILE_MAX 64      // 打たれた回数がこれに達したら全ての回数を半分にして、最近の打ち方に寄せる
+
+/* ------ 構造体の宣言 ------*/
+// オートマトンの一つの状態
+typedef struct{
+    unsigned short next[ROMAJI_CHAR_NUM]; // 入力文字ごとの遷移先の状態 (0は遷移なし)
+    unsigned char accept;                 // この状態で入力が確定する仮名の数 (0は確定しない)
+    unsigned char hasNext;                // この状態から先の遷移があるかどうか
+    unsigned char restAccept;             // rest を入力した時に確定する仮名の数
+    char rest[ROMAJI_PATTERN_LEN];        // この状態から入力が確定するまでの入力例
+}RomajiNode;
+
+// 全ての文字列で共有する入力判定の表
+typedef struct{
+    const RomajiNode *nodes;     // 状態の配列 (0番は使わない)
+    int nodeNum;                 // 状態の数
+    const unsigned short *root;  // [今の仮名][次の仮名] ごとの最初の状態
+}RomajiTable;
+
+// 文字列ごとに持つ入力位置
+typedef struct{
+    unsigned short node;    // オートマトン上の現在の状態 (0は入力終了)
+    unsigned char kanaPos;  // 入力が確定した仮名の数
+    unsigned char inputLen; // 入力されたローマ字の数
+    unsigned char kanaInput; // 今の仮名の入力を始めた時の、入力されたローマ字の数
+}RomajiCursor;
+
+// 遊んでいる人の打ち方の好み
+// 一つの仮名に複数の打ち方がある時に、打たれた入力パターン (「shi」と「si」など) ごとの回数を数える。
+// 入力パターンの種類の番号は入力判定の表を作った時に決めるので、0で初期化すればどの表でも使える。
+typedef struct{
+    unsigned char count[ROMAJI_PROFILE_SIZE]; // 入力パターンの種類ごとの打たれた回数
+}RomajiProfile;
+
+// 文字列ごとに持つ残りの入力例
+// 入力例は、入力パターンのキー入力の数から打ち方の好みの分を引いた重みの合計が一番小さくなるように、
+// 最後の仮名から順に仮名ごとの最後までの重みを求めて (動的計画法) 選ぶ。
+// 入力例は配列の末尾にそろえて保存し、仮名ごとにその仮名から始まる入力例の位置を覚えておく。
+// 入力例と違う打ち方をした時は、今の仮名から、前の入力例と同じ位置で区切れる仮名までを作り直して前に付け足すので、
+// その先の入力例は書き換えず、作り直す量は残りの仮名の数によらない。
+typedef struct{
+    char text[ROMAJI_EXAMPLE_SIZE];           // 残りの入力例 (配列の末尾にそろえて保存する)
+    unsigned char head;                       // 残りの入力例の先頭の位置
+    unsigned char kanaHead[KANA_LEN_MAX + 1]; // 仮名ごとの、その仮名から始まる入力例の位置 (ROMAJI_EXAMPLE_NONE はない)
+    short cost[KANA_LEN_MAX + 1];             // 仮名ごとの、その仮名から最後までを一番小さい重みで打った時の重み
+}RomajiExample;
+
+/* ------ プロトタイプ宣言 ------ */
+int romaji_init(int youon[KANA_NUM][SMALL_KANA_NUM]); // 拗音のパターンから入力判定の表を作る
+int romaji_attach(const RomajiNode *nodes, int nodeNum, const unsigned short *root); // 作成済みの表を使う
+void romaji_free(void); // 入力判定の表を解放する
+unsigned int romaji_table_checksum(unsigned int hash); // 入力判定の表のチェックサムを計算する
+int get_japanese_index(const char *str, int charIndex); // 日本語の文字の番号を返す
+int romaji_decode_kana(const char *kana, unsigned char *code); // 仮名の文字列を文字の番号の列に変換する
+void romaji_cursor_reset(RomajiCursor *cursor, const unsigned char *code, int len); // 入力位置を先頭に戻す
+int romaji_input(RomajiCursor *cursor, const unsigned char *code, int len, unsigned int ch); // 一文字の正誤判定をする
+unsigned int romaji_next_keys(const RomajiCursor *cursor); // 今の状態から遷移できる入力文字の集合を返す
+int romaji_char_index(unsigned int ch); // 入力文字を遷移の番号に変換する
+int romaji_pattern_index(const RomajiCursor *cursor, const unsigned char *code, int len); // 今入力している仮名の入力パターンの番号を返す
+const char *romaji_pattern_str(int pattern); // 入力パターンの番号の入力例を返す
+void romaji_kana_name(int index, char *name); // 仮名の番号の文字を返す
+int romaji_input_max(const unsigned char *code, int len); // 一番長い打ち方をした時のローマ字の数を返す
+int romaji_example_reset(RomajiExample *example, const RomajiCursor *cursor, const unsigned char *code, int len,
+                         const RomajiProfile *profile); // 残りの入力例を全て作る
+int romaji_example_advance(RomajiExample *example, unsigned int ch); // 入力例の通りに打たれた文字を進める
+int romaji_example_plan(RomajiExample *example, const RomajiCursor *cursor, const unsigned char *code, int len,
+                        const RomajiProfile *profile); // 入力例と違う打ち方をした時に、今の仮名から作り直す
+void romaji_profile_learn(RomajiProfile *profile, const RomajiCursor *before, const RomajiCursor *after,
+                          const unsigned char *code, int len, const char *input); // 確定した仮名の打ち方を好みに数える
+
+/* ------ グローバル変数の宣言 ------*/
+extern RomajiTable romajiTable;
+
+#endif
@@ -0,0 +1,1157 @@
+/*
+ * falltyping-server
+ * 描画せずに、たくさんの人のゲームを一つのLinuxのマシンで同時に進めるサーバ
+ * クライアントはTCP (127.0.0.1) かUNIXソケットで接続し、やりとりは「server.h」の決まりに従う。
+ * 落とす文字列の選択、落下の時間、キー入力の判定 (romaji_input) は全てサーバが行う。
+ *
+ * 作り
+ *   ワーカーのスレッドがそれぞれ epoll で待ち受け、接続を受け付けたワーカーがその接続のセッションを最後まで持つので、
+ *   セッションを触るのにロックを使わない。文字列と入力判定の表は起動時に一度だけ読み込み、全てのセッションで共有する。
+ *   セッションはワーカーごとにまとめて確保した領域から貸し出し、落ちている文字列ごとに持つのは
+ *   共有の文字列の番号と入力位置 (RomajiCursor) だけなので、一つのセッションは十数KBに収まる (ほとんどは送っていない返事を保存する領域)。
+ *
+ * 時間
+ *   ゲームと同じく文字列の落下は1秒に SIM_RATE 回の決まった間隔で進むものとして、落ち始める回数と終了の線に当たる回数を計算で求める。
+ *   セッションごとに毎回落下を進めることはせず、キー入力が届いた時と、次に文字列が落ち始める時または終了の線に当たる時に、
+ *   その時間までの回数をまとめて進める。キー入力はサーバが受け取った時間で判定する。
+ *
+ * 一秒ごとに、動いているセッションの数、キー入力の数、ワーカーが使ったCPU時間を一行のJSONで標準出力に書き出し、
+ * 終わる時に全体をまとめた結果を書き出す。sessions_per_core は、その時の負荷のままCPUのコア一つを使い切ると
+ * ゲーム中のセッションをいくつ動かせるかの見積もり (ゲーム中のセッションの数 / 使ったコアの数)。
+ *
+ * 使い方
+ *   falltyping-server [-w ワーカーの数] [-p ポート番号 | -u UNIXソケットのパス] [-t 動かす秒数] [string.txt string_kana.txt youon.txt]
+ * ワーカーの数を省略した時はCPUのコアの数だけ動かす。秒数を省略した時は Ctrl+C で止めるまで動く。
+ * 文字列のファイルを省略した時は、ゲームと同じく ./../corpus.bin を探し、なければ ./../ のテキストファイルを読み込む。
+ *
+ * コンパイル (Linuxのみ)
+ *   cc -O2 -pthread -o falltyping-server server.c romaji.c corpus.c corpus_image.c rng.c game_clock.c game_rules.c
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "romaji.h"
+#include "corpus.h"
+#include "corpus_image.h"
+#include "rng.h"
+#include "game.h"
+#include "game_clock.h"
+#include "server.h"
+
+#define SERVER_WORKER_MAX 64       // ワーカーの最大の数
+#define SERVER_EVENT_MAX 256       // 一度に受け取る epoll のイベントの数
+#define SERVER_ACCEPT_MAX 64       // 一度に受け付ける接続の数 (他のワーカーにも接続を回すため)
+#define SERVER_WORD_MAX 32         // 一つのセッションで同時に落ちている文字列の最大の数
+#define SERVER_ORIGIN_MAX 192      // 落とす文字列の最大のバイト数 (長い文字列は落とさない)
+#define SERVER_WORD_LINE_MAX (32 + ROMAJI_EXAMPLE_SIZE + SERVER_ORIGIN_MAX) // word の返事の最大の長さ
+#define SERVER_OUT_HIGH 2048       // 送っていない返事がこれを超えたら、送れるようになるまで命令を読まない
+#define SERVER_OUT_SIZE (SERVER_OUT_HIGH + SERVER_WORD_MAX * SERVER_WORD_LINE_MAX + 256) // 一つのセッションの送っていない返事を保存する大きさ
+#define SERVER_POOL_CHUNK 256      // セッションをまとめて確保する数
+#define SERVER_PICK_RETRY 8        // 落ちている文字列と同じ文字列を選んだ時に選び直す回数
+#define SERVER_STEP_NS (NS_PER_SEC / SIM_RATE) // 文字列の落下を一回進める時間 (ナノ秒)
+#define SERVER_REPORT_SEC 1.0      // 計測した値を書き出す間隔 (秒)
+#define SERVER_SPAWN_LINE 740.0    // 文字列が落ち始めるy座標 (main.c の画面と同じ)
+#define SERVER_END_LINE 250.0      // 文字列が当たると終了の線の位置 (main.c の画面と同じ)
+#define SERVER_BACKLOG 4096        // 受け付けを待つ接続の数
+
+/* ------ 構造体の宣言 ------*/
+// 全てのセッションで共有する、一つの文字列
+typedef struct{
+    const char *origin;        // 落とす文字列
+    const unsigned char *code; // 仮名ごとの文字の番号
+    int codeLen;               // 仮名の数
+    const char *example;       // 打ち方の好みを使わない時の最初の入力例
+}ServerWord;
+
+// 難易度ごとに決まる値を、落下を進める回数に直したもの
+typedef struct{
+    GameLevel level;   // 難易度ごとに決まる値 (main.c と同じ値)
+    int fallSteps;     // 落ち始めてから終了の線に当たるまでの回数
+    int intervalSteps; // 文字列を落下させ始める間隔の回数
+}ServerLevel;
+
+// 一つのセッションで落ちている文字列
+typedef struct{
+    int wordIndex;       // 共有の文字列の番号
+    int id;              // セッションの中で落ちた順に付けた番号
+    int spawnStep;       // 落ち始めた回数
+    RomajiCursor cursor; // 入力位置
+}SessionWord;
+
+struct ServerWorker;
+
+// 一つの接続のゲームの状態
+typedef struct Session{
+    struct ServerWorker *worker; // セッションを持つワーカー
+    struct Session *nextFree;    // 使っていないセッションの次のセッション
+    int fd;                      // 接続 (-1は閉じた)
+    int listIndex;               // ワーカーの使っているセッションの一覧の中の位置
+    int isBroken;                // 返事を保存しきれなかったかどうか (閉じる、SERVER_OUT_SIZE の決め方から起こらない)
+    int isQuitting;              // quit を受け取ったかどうか (保存した返事を送ってから閉じる)
+    int isReadPaused;            // 返事が多いので、命令を読むのを止めているかどうか
+    int waitEvents;              // epoll で待っているイベント
+    int isPlaying;               // ゲーム中かどうか
+    const ServerLevel *level;    // 難易度ごとに決まる値
+    Rng rng;                     // 落とす文字列を選ぶ乱数
+    long long startTime;         // ゲームを始めた実際の時間 (ナノ秒)
+    long long nextEventTime;     // 次に文字列が落ち始めるか、終了の線に当たる実際の時間 (ナノ秒)
+    int step;                    // 進めた落下の回数 (-1はまだ進めていない)
+    int lastSpawnStep;           // 最後に文字列が落ち始めた回数
+    SessionWord words[SERVER_WORD_MAX]; // 落ちている文字列 (落ち始めた順のリングバッファ)
+    int wordHead;                // 一番早く落ち始めた文字列の位置 (入力先)
+    int wordNum;                 // 落ちている文字列の数
+    int nextId;                  // 次に落ちる文字列に付ける番号
+    int completeNum;             // 入力し終えた文字列の数
+    int acceptNum;               // 正しいキー入力の数
+    int failureNum;              // 間違ったキー入力の数
+    char in[SERVER_LINE_SIZE];   // 改行までそろっていない命令
+    int inLen;                   // in の文字数
+    char out[SERVER_OUT_SIZE];   // 送っていない返事
+    int outLen;                  // out の文字数
+}Session;
+
+// 一つのワーカーのスレッド
+typedef struct ServerWorker{
+    int epollFd;              // 接続を待ち受ける epoll
+    int listenFd;             // 接続を受け付けるソケット (全てのワーカーで共有する)
+    pthread_t thread;         // スレッド
+    Session **sessions;       // 使っているセッションの一覧
+    int sessionNum;           // 使っているセッションの数
+    int sessionCap;           // sessions の大きさ
+    Session *freeList;        // 使っていないセッション
+    Session *closedList;      // 閉じて、今のイベントを処理し終えたら使っていないセッションに戻すセッション
+    Session **chunks;         // まとめて確保したセッションの領域
+    int chunkNum;             // chunks の数
+    atomic_int openNum;       // 使っているセッションの数 (書き出すスレッドが読む)
+    atomic_int playingNum;    // ゲーム中のセッションの数 (書き出すスレッドが読む)
+    atomic_ullong keyNum;     // 判定したキー入力の数
+    atomic_ullong roundNum;   // 終わったゲームの数
+    long long cpuTime;        // スレッドが終わるまでに使ったCPU時間 (ナノ秒、終わる時に書き込む)
+}ServerWorker;
+
+// 計測した値を書き出すための前回の値
+typedef struct{
+    long long time;              // 前回の実際の時間 (ナノ秒)
+    long long cpuTime;           // 前回までにワーカーが使ったCPU時間の合計 (ナノ秒)
+    unsigned long long keyNum;   // 前回までに判定したキー入力の数
+    double playingSec;           // ゲーム中のセッションの数を時間で積み上げた値 (セッション・秒)
+    int sessionMax;              // 使っているセッションの数の最大
+}ServerReport;
+
+/* ------ プロトタイプ宣言 ------ */
+static int load_youon(const char *path); // 拗音のパターンを読み込んで、入力判定の表を作る
+static int prepare_words(const Corpus *corpus); // 全てのセッションで共有する文字列を作る
+static void prepare_levels(void); // 難易度ごとの値を落下を進める回数に直す
+static int open_listener(int port, const char *unixPath); // 接続を受け付けるソケットを作る
+static void raise_fd_limit(void); // 開けるファイルの数を上限まで増やす
+static void handle_stop(int sig); // Ctrl+C などで止めるように指示された時に呼ばれる
+static void *worker_run(void *arg); // 接続を受け付けて、セッションを進め続けるスレッド
+static void worker_accept(ServerWorker *worker); // 受け付けを待つ接続を受け付ける
+static Session *session_open(ServerWorker *worker, int fd); // セッションを貸し出して、接続を待ち受ける
+static void session_close(Session *session); // 接続を閉じる
+static void worker_release(ServerWorker *worker); // 閉じたセッションを使っていないセッションに戻す
+static void worker_free(ServerWorker *worker); // ワーカーのメモリを解放する
+static int session_read(Session *session, long long now); // 届いた命令を読んで処理する
+static int session_command(Session *session, char *line, long long now); // 一つの命令を処理する
+static void session_start(Session *session, int level, unsigned long long seed, long long now); // ゲームを始める
+static int session_key(Session *session, const char *chars, long long now); // 打った文字を一文字ずつ判定する
+static void session_advance(Session *session, long long now); // 指定した時間まで落下を進める
+static int session_spawn_step(const Session *session); // 次に文字列が落ち始める回数を返す
+static int session_hit_step(const Session *session); // 次に文字列が終了の線に当たる回数を返す
+static void session_spawn(Session *session); // 文字列を一つ落とし始める
+static void session_over(Session *session, int isClear); // ゲームを終える
+static void session_schedule(Session *session); // 次に落下を進める必要がある時間を決める
+static void session_send(Session *session, const char *format, ...); // 返事を送る順に保存する
+static int session_flush(Session *session); // 保存した返事を送れるだけ送る
+static void server_report(ServerWorker *workers, int workerNum, ServerReport *report, double sec, int isTotal); // 計測した値を書き出す
+
+/* ------ グローバル変数の宣言 ------*/
+// 拗音がくるパターンを保存する二次元配列
+int youon[KANA_NUM][SMALL_KANA_NUM];
+// 全てのセッションで共有する文字列 (起動した後は読むだけ)
+ServerWord *serverWords;
+int serverWordNum;
+// 難易度ごとに決まる値 (起動した後は読むだけ)
+ServerLevel serverLevels[SERVER_LEVEL_NUM];
+// 止めるように指示されたかどうか
+atomic_int serverStopping;
+// 受け付けるソケットを epoll で待つ時に付ける目印 (セッションと区別する)
+static char listenMark;
+
+/* ---------------------- */
+/* ------ メイン処理 ------ */
+/* ---------------------- */
+int main(int argc, char *argv[]) {
+    const char *stringPath = "./../string.txt"; // 落とす文字列のあるファイルのパス
+    const char *stringKanaPath = "./../string_kana.txt"; // 落とす文字列の仮名のあるファイルのパス
+    const char *youonPath = "./../youon.txt"; // 拗音がくるパターンのあるファイルのパス
+    const char *unixPath = NULL; // UNIXソケットのパス (NULLの時はTCP)
+    int port = SERVER_PORT; // TCPのポート番号
+    int workerNum = (int)sysconf(_SC_NPROCESSORS_ONLN); // ワーカーの数
+    double runSec = 0; // 動かす秒数 (0の時は止めるように指示されるまで)
+    int option; // 読んだオプション
+    Corpus corpus; // 読み込んだ文字列
+    int listenFd; // 接続を受け付けるソケット
+    ServerWorker workers[SERVER_WORKER_MAX]; // ワーカー
+    ServerReport report = {0}; // 前回書き出した値
+    struct epoll_event event; // epoll に登録するイベント
+    long long startTime; // 動かし始めた実際の時間
+    long long nextReportTime; // 次に計測した値を書き出す実際の時間
+    long long now; // 今の実際の時間
+
+    while((option = getopt(argc, argv, "w:p:u:t:")) != -1){
+        switch(option){
+            case 'w': workerNum = atoi(optarg); break;
+            case 'p': port = atoi(optarg); break;
+            case 'u': unixPath = optarg; break;
+            case 't': runSec = atof(optarg); break;
+            default:
+                printf("使い方: %s [-w ワーカーの数] [-p ポート番号 | -u UNIXソケットのパス] [-t 動かす秒数] [string.txt string_kana.txt youon.txt]\n", argv[0]);
+                return 1;
+        }
+    }
+    if(argc - optind == 3){
+        stringPath = argv[optind];
+        stringKanaPath = argv[optind + 1];
+        youonPath = argv[optind + 2];
+    }else if(argc != optind){
+        printf("使い方: %s [-w ワーカーの数] [-p ポート番号 | -u UNIXソケットのパス] [-t 動かす秒数] [string.txt string_kana.txt youon.txt]\n", argv[0]);
+        return 1;
+    }
+    if(workerNum < 1)workerNum = 1;
+    if(workerNum > SERVER_WORKER_MAX)workerNum = SERVER_WORKER_MAX;
+
+    // 文字列のファイルを指定しなかった時は、ゲームと同じくコンパイル済みのイメージを先に探す
+    if(argc != optind || corpus_image_load(&corpus, "./../corpus.bin") != 0){
+        if(load_youon(youonPath) != 0){
+            return 1;
+        }
+        if(corpus_load(&corpus, stringPath, stringKanaPath) != 0){
+            romaji_free();
+            return 1;
+        }
+    }
+    if(prepare_words(&corpus) != 0){
+        corpus_free(&corpus);
+        romaji_free();
+        return 1;
+    }
+    prepare_levels();
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, handle_stop);
+    signal(SIGTERM, handle_stop);
+    raise_fd_limit();
+    if((listenFd = open_listener(port, unixPath)) < 0){
+        corpus_free(&corpus);
+        romaji_free();
+        return 1;
+    }
+
+    for(int i = 0; i < workerNum; i++){
+        memset(&workers[i], 0, sizeof(ServerWorker));
+        workers[i].listenFd = listenFd;
+        if((workers[i].epollFd = epoll_create1(0)) < 0){
+            printf("epoll の作成に失敗しました\n");
+            return 1;
+        }
+        // 接続が来た時に一つのワーカーだけを起こす
+        event.events = EPOLLIN | EPOLLEXCLUSIVE;
+        event.data.ptr = &listenMark;
+        if(epoll_ctl(workers[i].epollFd, EPOLL_CTL_ADD, listenFd, &event) != 0){
+            printf("接続を受け付けるソケットの登録に失敗しました\n");
+            return 1;
+        }
+        if(pthread_create(&workers[i].thread, NULL, worker_run, &workers[i]) != 0){
+            printf("ワーカーのスレッドの作成に失敗しました\n");
+            return 1;
+        }
+    }
+    fprintf(stderr, "%d個のワーカーで、%sで待ち受けています (文字列: %d個)\n",
+            workerNum, unixPath != NULL ? unixPath : "127.0.0.1", serverWordNum);
+
+    startTime = game_clock_real_ns();
+    report.time = startTime;
+    nextReportTime = startTime + game_clock_from_sec(SERVER_REPORT_SEC);
+    while(atomic_load(&serverStopping) == 0){
+        now = game_clock_real_ns();
+        if(runSec > 0 && now - startTime >= game_clock_from_sec(runSec)){
+            break;
+        }
+        if(now >= nextReportTime){
+            server_report(workers, workerNum, &report, game_clock_to_sec(now - startTime), 0);
+            nextReportTime += game_clock_from_sec(SERVER_REPORT_SEC);
+        }
+        // 止めるように指示されたことにすぐ気付けるように、短く眠る
+        game_clock_sleep_until(now + game_clock_from_sec(0.1) < nextReportTime ? now + game_clock_from_sec(0.1) : nextReportTime);
+    }
+    atomic_store(&serverStopping, 1);
+    for(int i = 0; i < workerNum; i++){
+        pthread_join(workers[i].thread, NULL);
+    }
+    // 全体の値は、ワーカーが止まった後に動かし始めた時からまとめて書き出す
+    report.time = startTime;
+    server_report(workers, workerNum, &report, game_clock_to_sec(game_clock_real_ns() - startTime), 1);
+
+    for(int i = 0; i < workerNum; i++){
+        worker_free(&workers[i]);
+    }
+    close(listenFd);
+    if(unixPath != NULL){
+        unlink(unixPath);
+    }
+    free(serverWords);
+    corpus_free(&corpus);
+    romaji_free();
+    return 0;
+}
+
+/**
+ * 拗音のパターンをファイルから読み込んで、入力判定の表を作る
+ *
+ * @param path 拗音がくるパターンのあるファイルのパス
+ *
+ * @return 0 : 成功 -1 : 失敗
+ */
+static int load_youon(const char *path){
+    FILE *fpInYouon; // 拗音がくるパターンのあるファイル用のポインタ
+
+    if((fpInYouon = fopen(path,"r")) == NULL){
+        printf("ファイルのオープンに失敗しました\nyouon.txtがあるかを確認してください\n");
+        return -1;
+    }
+    for(int i = 0; i < KANA_NUM; i++){
+        for(int j = 0; j < SMALL_KANA_NUM; j++){
+            if(fscanf(fpInYouon,"%d", &youon[i][j]) != 1){
+                printf("youon.txtの形式が正しくありません\n");
+                fclose(fpInYouon);
+                return -1;
+            }
+        }
+    }
+    fclose(fpInYouon);
+    if(romaji_init(youon) != 0){
+        printf("入力判定の表の作成に失敗しました\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 全てのセッションで共有する文字列を作る
+ * テキストファイルから読み込んだ時は仮名を文字の番号の列に変換し、最初の入力例も一度だけ作っておく。
+ * 文字の番号の列と入力例は、文字列の配列の後ろに続けて一つの領域に保存する
+ *
+ * @param corpus 読み込んだ文字列
+ *
+ * @return 0 : 成功 -1 : 落とせる文字列がない、またはメモリの確保に失敗した
+ */
+static int prepare_words(const Corpus *corpus){
+    CorpusWord word; // 取り出した文字列
+    RomajiCursor cursor; // 最初の入力例を作るための入力位置
+    RomajiExample example; // 最初の入力例
+    unsigned char code[KANA_LEN_MAX + 1]; // 変換した文字の番号の列
+    const unsigned char *wordCode; // 使う文字の番号の列
+    size_t textSize = (size_t)corpus->wordNum * (KANA_LEN_MAX + ROMAJI_EXAMPLE_SIZE); // 文字の番号の列と入力例に使う大きさの上限
+    char *text; // 文字の番号の列と入力例を保存する領域の次に書き込む位置
+    int exampleLen; // 入力例の文字数
+
+    serverWords = (ServerWord*) malloc(sizeof(ServerWord) * corpus->wordNum + textSize);
+    if(serverWords == NULL){
+        printf("文字列を保存するメモリの確保に失敗しました\n");
+        return -1;
+    }
+    text = (char*)(serverWords + corpus->wordNum);
+    serverWordNum = 0;
+    for(int i = 0; i < corpus->wordNum; i++){
+        if(corpus_get_word(corpus, i, &word) != 0){ // イメージの中で壊れている文字列は落とさない
+            fprintf(stderr, "%d番目の文字列はイメージの中で壊れているので落としません\n", i + 1);
+            continue;
+        }
+        wordCode = word.code;
+        if(wordCode == NULL){
+            word.codeLen = romaji_decode_kana(word.kana, code);
+            memcpy(text, code, word.codeLen);
+            wordCode = (const unsigned char*)text;
+            text += word.codeLen;
+        }
+        if(word.codeLen == 0){ // 打てる仮名がない文字列は落とさない
+            continue;
+        }
+        if(strlen(word.origin) > SERVER_ORIGIN_MAX){ // word の返事が SERVER_WORD_LINE_MAX に収まらない文字列は落とさない
+            fprintf(stderr, "%d番目の文字列は長すぎるので落としません\n", i + 1);
+            continue;
+        }
+        romaji_cursor_reset(&cursor, wordCode, word.codeLen);
+        romaji_example_reset(&example, &cursor, wordCode, word.codeLen, NULL);
+        exampleLen = ROMAJI_EXAMPLE_SIZE - 1 - example.head;
+        memcpy(text, example.text + example.head, exampleLen + 1);
+
+        serverWords[serverWordNum].origin = word.origin;
+        serverWords[serverWordNum].code = wordCode;
+        serverWords[serverWordNum].codeLen = word.codeLen;
+        serverWords[serverWordNum].example = text;
+        serverWordNum++;
+        text += exampleLen + 1;
+    }
+    if(serverWordNum == 0){
+        printf("落とせる文字列がありません\n");
+        free(serverWords);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 難易度ごとの値を決めて、落下を進める回数に直す
+ * 落ち始めた文字列はゲームと同じく一回ごとに fallSpeed / SIM_RATE だけ落ち、終了の線より下になった次の回で当たる
+ */
+static void prepare_levels(void){
+    for(int i = 0; i < SERVER_LEVEL_NUM; i++){
+        GameLevel level = {0}; // 難易度ごとに決まる値 (ゲームと同じ game_level_preset の値)
+
+        game_level_preset(i + 1, &level);
+        serverLevels[i].level = level;
+        serverLevels[i].fallSteps = (int)((SERVER_SPAWN_LINE - SERVER_END_LINE) / (level.fallSpeed / SIM_RATE)) + 1;
+        // 落とす間隔を超えた回で次の文字列が落ち始める
+        serverLevels[i].intervalSteps = (int)(level.fallInterval / SERVER_STEP_NS) + 1;
+    }
+}
+
+/**
+ * 接続を受け付けるソケットを作る
+ *
+ * @param port TCPのポート番号
+ * @param unixPath UNIXソケットのパス (NULLの時は 127.0.0.1 のTCP)
+ *
+ * @return ソケット -1 : 作れなかった
+ */
+static int open_listener(int port, const char *unixPath){
+    struct sockaddr_in inAddr = {0}; // TCPのアドレス
+    struct sockaddr_un unAddr = {0}; // UNIXソケットのアドレス
+    int listenFd; // 作ったソケット
+    int yes = 1; // ソケットのオプションに設定する値
+
+    if(unixPath != NULL){
+        if(strlen(unixPath) >= sizeof(unAddr.sun_path)){
+            printf("UNIXソケットのパスが長すぎます\n");
+            return -1;
+        }
+        unAddr.sun_family = AF_UNIX;
+        strcpy(unAddr.sun_path, unixPath);
+        unlink(unixPath);
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if(listenFd >= 0 && bind(listenFd, (struct sockaddr*)&unAddr, sizeof(unAddr)) != 0){
+            close(listenFd);
+            listenFd = -1;
+        }
+    }else{
+        inAddr.sin_family = AF_INET;
+        inAddr.sin_port = htons(port);
+        inAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if(listenFd >= 0){
+            setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+            if(bind(listenFd, (struct sockaddr*)&inAddr, sizeof(inAddr)) != 0){
+                close(listenFd);
+                listenFd = -1;
+            }
+        }
+    }
+    if(listenFd < 0 || listen(listenFd, SERVER_BACKLOG) != 0){
+        printf("接続を受け付けるソケットの作成に失敗しました\n");
+        if(listenFd >= 0)close(listenFd);
+        return -1;
+    }
+    return listenFd;
+}
+
+/**
+ * 開けるファイルの数を上限まで増やす (一つの接続に一つ使うので、何千もの接続を受け付けるのに必要)
+ */
+static void raise_fd_limit(void){
+    struct rlimit limit; // 開けるファイルの数
+
+    if(getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max){
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+/**
+ * Ctrl+C などで止めるように指示された時に呼ばれる
+ *
+ * @param sig シグナルの番号
+ */
+static void handle_stop(int sig){
+    (void)sig;
+    atomic_store(&serverStopping, 1);
+}
+
+/**
+ * 接続を受け付けて、セッションを進め続けるスレッド
+ * イベントを処理した後、SERVER_STEP_NS ごとに、文字列が落ち始めるか終了の線に当たる時間になったセッションの落下を進める
+ *
+ * @param arg ワーカー (ServerWorker*)
+ *
+ * @return NULL
+ */
+static void *worker_run(void *arg){
+    ServerWorker *worker = arg; // ワーカー
+    struct epoll_event events[SERVER_EVENT_MAX]; // 受け取ったイベント
+    long long nextTickTime = game_clock_real_ns(); // 次にセッションの落下を進める実際の時間
+    long long now; // 今の実際の時間
+    int eventNum; // 受け取ったイベントの数
+    int waitMs; // イベントを待つミリ秒
+    Session *session; // イベントが来たセッション
+    int playingNum; // ゲーム中のセッションの数
+    struct timespec cpuSpec; // スレッドが使ったCPU時間
+
+    while(atomic_load_explicit(&serverStopping, memory_order_relaxed) == 0){
+        now = game_clock_real_ns();
+        waitMs = nextTickTime > now ? (int)((nextTickTime - now + 999999) / 1000000) : 0;
+        eventNum = epoll_wait(worker->epollFd, events, SERVER_EVENT_MAX, waitMs);
+        now = game_clock_real_ns();
+        for(int i = 0; i < eventNum; i++){
+            if(events[i].data.ptr == &listenMark){
+                worker_accept(worker);
+                continue;
+            }
+            session = events[i].data.ptr;
+            if(session->fd < 0){ // 同じ回のイベントで閉じた
+                continue;
+            }
+            // 返事を送れるようになるのを待っていたセッションも、送った後に残りの命令を処理する
+            if(session_read(session, now) != 0){
+                session_flush(session); // quit やエラーの返事は送れるだけ送ってから閉じる
+                session_close(session);
+                continue;
+            }
+            if(session_flush(session) != 0){
+                session_close(session);
+            }
+        }
+        if(now >= nextTickTime){
+            // 閉じると一覧の最後のセッションが今の位置に来るので、後ろから進める
+            for(int i = worker->sessionNum - 1; i >= 0; i--){
+                session = worker->sessions[i];
+                if(session->nextEventTime > now){
+                    continue;
+                }
+                session_advance(session, now);
+                if(session_flush(session) != 0){
+                    session_close(session);
+                }
+            }
+            nextTickTime = now + SERVER_STEP_NS;
+            playingNum = 0;
+            for(int i = 0; i < worker->sessionNum; i++){
+                playingNum += worker->sessions[i]->isPlaying;
+            }
+            atomic_store_explicit(&worker->playingNum, playingNum, memory_order_relaxed);
+        }
+        worker_release(worker);
+    }
+    for(int i = worker->sessionNum - 1; i >= 0; i--){
+        session_close(worker->sessions[i]);
+    }
+    worker_release(worker);
+    if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuSpec) == 0){
+        worker->cpuTime = cpuSpec.tv_sec * NS_PER_SEC + cpuSpec.tv_nsec;
+    }
+    return NULL;
+}
+
+/**
+ * 受け付けを待つ接続を受け付けて、このワーカーのセッションにする
+ * 一度に受け付けるのは SERVER_ACCEPT_MAX 個までにして、残りは他のワーカーにも回す
+ *
+ * @param worker ワーカー
+ */
+static void worker_accept(ServerWorker *worker){
+    int fd; // 受け付けた接続
+    int yes = 1; // ソケットのオプションに設定する値
+
+    for(int i = 0; i < SERVER_ACCEPT_MAX; i++){
+        fd = accept4(worker->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(fd < 0){
+            if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+                fprintf(stderr, "接続の受け付けに失敗しました (%s)\n", strerror(errno));
+            }
+            return;
+        }
+        // 一文字ずつの返事をすぐに送る (UNIXソケットの時は設定できないが、必要もない)
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        if(session_open(worker, fd) == NULL){
+            close(fd);
+        }
+    }
+}
+
+/**
+ * 使っていないセッションを貸し出して、接続を待ち受ける
+ * 使っていないセッションがない時は SERVER_POOL_CHUNK 個まとめて確保する
+ *
+ * @param worker ワーカー
+ * @param fd 接続
+ *
+ * @return セッション NULL : メモリの確保か登録に失敗した
+ */
+static Session *session_open(ServerWorker *worker, int fd){
+    Session *session; // 貸し出すセッション
+    Session *chunk; // まとめて確保したセッション
+    void *grown; // 大きくした配列
+    struct epoll_event event; // epoll に登録するイベント
+
+    if(worker->freeList == NULL){
+        chunk = (Session*) calloc(SERVER_POOL_CHUNK, sizeof(Session));
+        grown = realloc(worker->chunks, sizeof(Session*) * (worker->chunkNum + 1));
+        if(chunk == NULL || grown == NULL){
+            free(chunk);
+            if(grown != NULL)worker->chunks = grown;
+            fprintf(stderr, "セッションのメモリの確保に失敗しました\n");
+            return NULL;
+        }
+        worker->chunks = grown;
+        worker->chunks[worker->chunkNum++] = chunk;
+        for(int i = SERVER_POOL_CHUNK - 1; i >= 0; i--){
+            chunk[i].nextFree = worker->freeList;
+            worker->freeList = &chunk[i];
+        }
+    }
+    if(worker->sessionNum == worker->sessionCap){
+        grown = realloc(worker->sessions, sizeof(Session*) * (worker->sessionCap + SERVER_POOL_CHUNK));
+        if(grown == NULL){
+            fprintf(stderr, "セッションの一覧のメモリの確保に失敗しました\n");
+            return NULL;
+        }
+        worker->sessions = grown;
+        worker->sessionCap += SERVER_POOL_CHUNK;
+    }
+
+    session = worker->freeList;
+    worker->freeList = session->nextFree;
+    memset(session, 0, offsetof(Session, in)); // 受け取った命令と返事の領域は長さを0にするだけでよい
+    session->worker = worker;
+    session->fd = fd;
+    session->inLen = 0;
+    session->outLen = 0;
+    session->nextEventTime = LLONG_MAX;
+    session->waitEvents = EPOLLIN | EPOLLRDHUP;
+    event.events = session->waitEvents;
+    event.data.ptr = session;
+    if(epoll_ctl(worker->epollFd, EPOLL_CTL_ADD, fd, &event) != 0){
+        session->nextFree = worker->freeList;
+        worker->freeList = session;
+        fprintf(stderr, "接続の登録に失敗しました\n");
+        return NULL;
+    }
+    session->listIndex = worker->sessionNum;
+    worker->sessions[worker->sessionNum++] = session;
+    atomic_store_explicit(&worker->openNum, worker->sessionNum, memory_order_relaxed);
+    return session;
+}
+
+/**
+ * 接続を閉じて、ワーカーの一覧から外す
+ * 同じ回のイベントがまだ残っているかもしれないので、使っていないセッションに戻すのは worker_release で行う
+ *
+ * @param session セッション
+ */
+static void session_close(Session *session){
+    ServerWorker *worker = session->worker; // セッションを持つワーカー
+    Session *last = worker->sessions[worker->sessionNum - 1]; // 一覧の最後のセッション
+
+    close(session->fd); // epoll からも外れる
+    session->fd = -1;
+    last->listIndex = session->listIndex;
+    worker->sessions[session->listIndex] = last;
+    worker->sessionNum--;
+    session->nextFree = worker->closedList;
+    worker->closedList = session;
+    atomic_store_explicit(&worker->openNum, worker->sessionNum, memory_order_relaxed);
+}
+
+/**
+ * 閉じたセッションを使っていないセッションに戻す
+ *
+ * @param worker ワーカー
+ */
+static void worker_release(ServerWorker *worker){
+    Session *session; // 戻すセッション
+
+    while(worker->closedList != NULL){
+        session = worker->closedList;
+        worker->closedList = session->nextFree;
+        session->nextFree = worker->freeList;
+        worker->freeList = session;
+    }
+}
+
+/**
+ * ワーカーのメモリを解放する (スレッドが終わった後に呼ぶ)
+ *
+ * @param worker ワーカー
+ */
+static void worker_free(ServerWorker *worker){
+    for(int i = 0; i < worker->chunkNum; i++){
+        free(worker->chunks[i]);
+    }
+    free(worker->chunks);
+    free(worker->sessions);
+    close(worker->epollFd);
+}
+
+/**
+ * 届いた命令を読めるだけ読んで、改行までそろった命令を順に処理する
+ * 送っていない返事が SERVER_OUT_HIGH を超えたら、送れるだけ送ってもまだ多い時は処理を止め、
+ * 残りの命令は in とカーネルの受信バッファに置いたまま、送れるようになってから続きを処理する。
+ * 一つの key の命令の途中で止めた時は、残りの文字を新しい key の命令として in に残す。
+ * そのため返事が多い命令を続けて送られても、返事を保存しきれずに接続を閉じることはない
+ * (止めている間に届いた命令は、続きを処理した時の時間で判定する)
+ *
+ * @param session セッション
+ * @param now 命令を受け取った実際の時間 (ナノ秒)
+ *
+ * @return 0 : 続ける -1 : 接続を閉じる
+ */
+static int session_read(Session *session, long long now){
+    ssize_t readNum; // 読んだバイト数
+    char *lineEnd; // 命令の終わりの改行
+    int lineStart = 0; // 処理していない命令の先頭の位置
+    int lineLen; // 改行を除いた命令の長さ
+    int isCr; // 命令が '\r' で終わっていたかどうか
+    int rest; // 命令の中の、処理していない文字の位置 (0は最後まで処理した)
+
+    session->isReadPaused = 0;
+    for(;;){
+        while((lineEnd = memchr(session->in + lineStart, '\n', session->inLen - lineStart)) != NULL){
+            if(session->outLen >= SERVER_OUT_HIGH && (session_flush(session) != 0 || session->outLen >= SERVER_OUT_HIGH)){
+                break;
+            }
+            lineLen = (int)(lineEnd - session->in) - lineStart;
+            isCr = lineLen > 0 && lineEnd[-1] == '\r';
+            session->in[lineStart + lineLen - isCr] = '\0';
+            rest = session_command(session, session->in + lineStart, now);
+            if(session->isQuitting || session->isBroken){
+                return -1;
+            }
+            if(rest > 0){ // 途中で止めた key の命令は、残りの文字を key の命令に書き直して残す
+                if(isCr){
+                    lineEnd[-1] = '\r';
+                }else{
+                    *lineEnd = '\n';
+                }
+                lineStart += rest - 4;
+                memcpy(session->in + lineStart, "key ", 4);
+                continue;
+            }
+            lineStart += lineLen + 1;
+        }
+        memmove(session->in, session->in + lineStart, session->inLen - lineStart);
+        session->inLen -= lineStart;
+        lineStart = 0;
+        if(session->outLen >= SERVER_OUT_HIGH){ // 返事を送れるようになるまで読まない
+            session->isReadPaused = 1;
+            return session_flush(session);
+        }
+        if(session->inLen == SERVER_LINE_SIZE){
+            session_send(session, "error line too long\n");
+            return -1;
+        }
+        readNum = recv(session->fd, session->in + session->inLen, SERVER_LINE_SIZE - session->inLen, 0);
+        if(readNum == 0){
+            return -1;
+        }
+        if(readNum < 0){
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+        }
+        session->inLen += (int)readNum;
+    }
+}
+
+/**
+ * 一つの命令を処理する
+ *
+ * @param session セッション
+ * @param line 改行を除いた命令
+ * @param now 命令を受け取った実際の時間 (ナノ秒)
+ *
+ * @return 命令の中の、返事が多くて判定しなかった最初の文字の位置 (0は最後まで処理した)
+ */
+static int session_command(Session *session, char *line, long long now){
+    int level; // 指定された難易度
+    unsigned long long seed; // 指定された乱数の種
+    int judgedNum; // 判定した文字の数
+
+    if(strncmp(line, "key ", 4) == 0){
+        judgedNum = session_key(session, line + 4, now);
+        return line[4 + judgedNum] == '\0' ? 0 : 4 + judgedNum;
+    }else if(sscanf(line, "start %d %llu", &level, &seed) == 2){
+        if(level < 1 || level > SERVER_LEVEL_NUM){
+            session_send(session, "error level\n");
+            return 0;
+        }
+        session_start(session, level, seed, now);
+    }else if(strcmp(line, "quit") == 0){
+        session->isQuitting = 1;
+    }else{
+        session_send(session, "error command\n");
+    }
+    return 0;
+}
+
+/**
+ * ゲームを始めて、最初の文字列を落とし始める
+ *
+ * @param session セッション
+ * @param level 難易度 (1 : Easy 2 : Normal 3 : Difficult)
+ * @param seed 落とす文字列を選ぶ乱数の種
+ * @param now 命令を受け取った実際の時間 (ナノ秒)
+ */
+static void session_start(Session *session, int level, unsigned long long seed, long long now){
+    session->isPlaying = 1;
+    session->level = &serverLevels[level - 1];
+    rng_seed(&session->rng, seed, 0);
+    session->startTime = now;
+    session->step = -1;
+    session->lastSpawnStep = -1;
+    session->wordHead = 0;
+    session->wordNum = 0;
+    session->nextId = 0;
+    session->completeNum = 0;
+    session->acceptNum = 0;
+    session->failureNum = 0;
+    session_advance(session, now);
+}
+
+/**
+ * 打った文字を一文字ずつ、一番早く落ち始めた文字列への入力として判定する
+ * 判定する前に、受け取った時間まで落下を進めておく
+ * 送っていない返事が SERVER_OUT_HIGH を超えたら、残りの文字は判定せずに止める
+ *
+ * @param session セッション
+ * @param chars 打った文字
+ * @param now 命令を受け取った実際の時間 (ナノ秒)
+ *
+ * @return 判定した文字の数
+ */
+static int session_key(Session *session, const char *chars, long long now){
+    SessionWord *word; // 入力先の文字列
+    const ServerWord *shared; // 入力先の共有の文字列
+    int keyNum = 0; // 判定したキー入力の数
+    const char *p = chars; // 判定する文字
+
+    if(session->isPlaying){
+        session_advance(session, now);
+    }
+    for(; *p != '\0' && session->outLen < SERVER_OUT_HIGH; p++){
+        if(session->isPlaying == 0 || session->wordNum == 0){ // ゲームと同じく、落ちている文字列がない時は読み捨てる
+            session_send(session, "ignored\n");
+            continue;
+        }
+        keyNum++;
+        word = &session->words[session->wordHead];
+        shared = &serverWords[word->wordIndex];
+        if(romaji_input(&word->cursor, shared->code, shared->codeLen, (unsigned char)*p) != 0){
+            session->failureNum++;
+            session_send(session, "failure %d\n", word->id);
+            continue;
+        }
+        session->acceptNum++;
+        if(word->cursor.node != 0){
+            session_send(session, "accept %d\n", word->id);
+            continue;
+        }
+        session_send(session, "complete %d\n", word->id);
+        session->wordHead = (session->wordHead + 1) % SERVER_WORD_MAX;
+        session->wordNum--;
+        session->completeNum++;
+        if(session->completeNum >= session->level->level.finishTypingNum){
+            session_over(session, 1);
+        }
+    }
+    atomic_fetch_add_explicit(&session->worker->keyNum, keyNum, memory_order_relaxed);
+    session_schedule(session);
+    return (int)(p - chars);
+}
+
+/**
+ * 指定した時間の回まで落下を進める
+ * 一回ずつ進めるのではなく、文字列が落ち始める回と終了の線に当たる回だけを順に処理する
+ *
+ * @param session セッション
+ * @param now 実際の時間 (ナノ秒)
+ */
+static void session_advance(Session *session, long long now){
+    int target = (int)((now - session->startTime) / SERVER_STEP_NS); // 進める回数
+    int spawnStep; // 次に文字列が落ち始める回数
+    int hitStep; // 次に文字列が終了の線に当たる回数
+
+    while(session->isPlaying){
+        spawnStep = session_spawn_step(session);
+        hitStep = session_hit_step(session);
+        if(spawnStep > target && hitStep > target){
+            break;
+        }
+        // ゲームと同じく、同じ回では落とし始めてから終了の線に当たったかを調べる
+        session->step = spawnStep < hitStep ? spawnStep : hitStep;
+        if(spawnStep == session->step){
+            session_spawn(session);
+        }
+        if(hitStep == session->step){
+            session_over(session, 0);
+        }
+    }
+    if(session->isPlaying && session->step < target){
+        session->step = target;
+    }
+    session_schedule(session);
+}
+
+/**
+ * 次に文字列が落ち始める回数を返す
+ * ゲームと同じく、落とす間隔を超えた時か落ちている文字列がない時に、終了に必要な数を超えない間だけ落とす
+ *
+ * @param session セッション
+ *
+ * @return 落ち始める回数 (INT_MAXはこれ以上落とさない)
+ */
+static int session_spawn_step(const Session *session){
+    int step; // 落ち始める回数
+
+    if(session->completeNum + 1 + session->wordNum > session->level->level.finishTypingNum
+       || session->wordNum == SERVER_WORD_MAX){
+        return INT_MAX;
+    }
+    step = session->wordNum == 0 ? session->step + 1 : session->lastSpawnStep + session->level->intervalSteps;
+    return step > session->step ? step : session->step + 1;
+}
+
+/**
+ * 次に文字列が終了の線に当たる回数を返す
+ * 全ての文字列は同じ速さで落ちるので、一番早く落ち始めた文字列が最初に当たる
+ *
+ * @param session セッション
+ *
+ * @return 当たる回数 (INT_MAXは落ちている文字列がない)
+ */
+static int session_hit_step(const Session *session){
+    if(session->wordNum == 0){
+        return INT_MAX;
+    }
+    return session->words[session->wordHead].spawnStep + session->level->fallSteps;
+}
+
+/**
+ * 共有の文字列から一つ選んで落とし始め、クライアントに知らせる
+ * 落ちている文字列と同じ文字列は、SERVER_PICK_RETRY 回まで選び直す
+ *
+ * @param session セッション
+ */
+static void session_spawn(Session *session){
+    SessionWord *word = &session->words[(session->wordHead + session->wordNum) % SERVER_WORD_MAX]; // 落とし始める文字列
+    int wordIndex = 0; // 選んだ共有の文字列の番号
+    int isFalling = 1; // 選んだ文字列が落ちているかどうか
+
+    for(int retry = 0; retry <= SERVER_PICK_RETRY && isFalling == 1; retry++){
+        wordIndex = (int)rng_range(&session->rng, (uint32_t)serverWordNum);
+        isFalling = 0;
+        for(int i = 0; i < session->wordNum; i++){
+            if(session->words[(session->wordHead + i) % SERVER_WORD_MAX].wordIndex == wordIndex){
+                isFalling = 1;
+                break;
+            }
+        }
+    }
+    word->wordIndex = wordIndex;
+    word->id = session->nextId++;
+    word->spawnStep = session->step;
+    romaji_cursor_reset(&word->cursor, serverWords[wordIndex].code, serverWords[wordIndex].codeLen);
+    session->wordNum++;
+    session->lastSpawnStep = session->step;
+    session_send(session, "word %d %s %s\n", word->id, serverWords[wordIndex].example, serverWords[wordIndex].origin);
+}
+
+/**
+ * ゲームを終えて、結果をクライアントに知らせる
+ * スコアはゲームと同じ game_score_of で、進めた落下の回数をゲームにかかった時間とする
+ *
+ * @param session セッション
+ * @param isClear 0 : 終了の線に当たった 1 : 終了に必要な数の文字列を入力し終えた
+ */
+static void session_over(Session *session, int isClear){
+    double gameTime = game_clock_to_sec((long long)session->step * SERVER_STEP_NS); // ゲームにかかった時間 (秒)
+    int score = game_score_of(session->acceptNum, session->failureNum, gameTime); // スコア
+
+    session->isPlaying = 0;
+    session_send(session, "over %s %d %d %d %d\n", isClear == 1 ? "clear" : "failure", score,
+                 session->acceptNum, session->failureNum, session->completeNum);
+    atomic_fetch_add_explicit(&session->worker->roundNum, 1, memory_order_relaxed);
+}
+
+/**
+ * 次に落下を進める必要がある実際の時間を決める
+ *
+ * @param session セッション
+ */
+static void session_schedule(Session *session){
+    int spawnStep; // 次に文字列が落ち始める回数
+    int hitStep; // 次に文字列が終了の線に当たる回数
+    int step; // 早い方の回数
+
+    if(session->isPlaying == 0){
+        session->nextEventTime = LLONG_MAX;
+        return;
+    }
+    spawnStep = session_spawn_step(session);
+    hitStep = session_hit_step(session);
+    step = spawnStep < hitStep ? spawnStep : hitStep;
+    session->nextEventTime = step == INT_MAX ? LLONG_MAX : session->startTime + (long long)step * SERVER_STEP_NS;
+}
+
+/**
+ * 返事を送る順に保存する
+ * 保存しきれない時は、クライアントが受け取れていないので接続を閉じる
+ *
+ * @param session セッション
+ * @param format 返事の書式
+ */
+static void session_send(Session *session, const char *format, ...){
+    va_list args; // 書式に埋め込む値
+    int len; // 返事の文字数
+
+    if(session->isBroken){
+        return;
+    }
+    va_start(args, format);
+    len = vsnprintf(session->out + session->outLen, SERVER_OUT_SIZE - session->outLen, format, args);
+    va_end(args);
+    if(len < 0 || len >= SERVER_OUT_SIZE - session->outLen){
+        session->isBroken = 1;
+        return;
+    }
+    session->outLen += len;
+}
+
+/**
+ * 保存した返事を送れるだけ送る
+ * 送りきれない時は書き込めるようになるのを待ち、送りきったら待つのをやめる。
+ * 命令を読むのを止めている間は、届いた命令では起きず、書き込めるようになった時に起きて続きを処理する
+ *
+ * @param session セッション
+ *
+ * @return 0 : 続ける -1 : 接続を閉じる
+ */
+static int session_flush(Session *session){
+    ssize_t sentNum = 0; // 送ったバイト数
+    struct epoll_event event; // epoll に登録するイベント
+    int waitEvents; // 待つイベント
+
+    if(session->fd < 0){
+        return 0;
+    }
+    if(session->isBroken){
+        return -1;
+    }
+    if(session->outLen > 0){
+        sentNum = send(session->fd, session->out, session->outLen, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if(sentNum < 0){
+            if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+                return -1;
+            }
+            sentNum = 0;
+        }
+        memmove(session->out, session->out + sentNum, session->outLen - sentNum);
+        session->outLen -= (int)sentNum;
+    }
+    waitEvents = session->isReadPaused ? EPOLLOUT : EPOLLIN | EPOLLRDHUP | (session->outLen > 0 ? EPOLLOUT : 0);
+    if(waitEvents != session->waitEvents){
+        event.events = waitEvents;
+        event.data.ptr = session;
+        if(epoll_ctl(session->worker->epollFd, EPOLL_CTL_MOD, session->fd, &event) != 0){
+            return -1;
+        }
+        session->waitEvents = waitEvents;
+    }
+    return 0;
+}
+
+/**
+ * 前回書き出してからの値を、一行のJSONで標準出力に書き出す
+ * ワーカーが使ったCPU時間は、動いている間はワーカーのスレッドのCPU時計から読む
+ *
+ * @param workers ワーカー
+ * @param workerNum ワーカーの数
+ * @param report 前回書き出した値 (今回の値で更新する)
+ * @param sec 動かし始めてからの秒数
+ * @param isTotal 0 : 前回からの値 1 : 動かし始めてからの全体の値
+ */
+static void server_report(ServerWorker *workers, int workerNum, ServerReport *report, double sec, int isTotal){
+    long long now = game_clock_real_ns(); // 今の実際の時間
+    long long cpuTime = 0; // ワーカーが使ったCPU時間の合計
+    unsigned long long keyNum = 0; // 判定したキー入力の数
+    unsigned long long roundNum = 0; // 終わったゲームの数
+    int openNum = 0; // 使っているセッションの数
+    int playingNum = 0; // ゲーム中のセッションの数
+    clockid_t cpuClock; // ワーカーのスレッドのCPU時計
+    struct timespec cpuSpec; // 読んだCPU時間
+    double wallSec; // 前回からの秒数
+    double cores; // 使ったコアの数
+    double playingAvg; // ゲーム中のセッションの数の平均
+
+    for(int i = 0; i < workerNum; i++){
+        if(isTotal == 1){
+            cpuTime += workers[i].cpuTime;
+        }else if(pthread_getcpuclockid(workers[i].thread, &cpuClock) == 0
+           && clock_gettime(cpuClock, &cpuSpec) == 0){
+            cpuTime += cpuSpec.tv_sec * NS_PER_SEC + cpuSpec.tv_nsec;
+        }
+        keyNum += atomic_load_explicit(&workers[i].keyNum, memory_order_relaxed);
+        roundNum += atomic_load_explicit(&workers[i].roundNum, memory_order_relaxed);
+        openNum += atomic_load_explicit(&workers[i].openNum, memory_order_relaxed);
+        playingNum += atomic_load_explicit(&workers[i].playingNum, memory_order_relaxed);
+    }
+    wallSec = game_clock_to_sec(now - report->time);
+    if(isTotal == 1){
+        // ワーカーのスレッドは終わっているので、それぞれが終わる時に書き込んだCPU時間を使う
+        cores = wallSec > 0 ? game_clock_to_sec(cpuTime) / wallSec : 0;
+        playingAvg = wallSec > 0 ? report->playingSec / wallSec : 0;
+        printf("{\"report\": \"total\", \"workers\": %d, \"words\": %d, \"session_bytes\": %zu, \"sec\": %.3f, "
+               "\"sessions_max\": %d, \"playing_avg\": %.1f, \"rounds\": %llu, \"keys\": %llu, \"keys_per_sec\": %.1f, "
+               "\"cpu_sec\": %.3f, \"cpu_cores\": %.3f, \"sessions_per_core\": %.1f}\n",
+               workerNum, serverWordNum, sizeof(Session), sec, report->sessionMax, playingAvg, roundNum, keyNum,
+               wallSec > 0 ? keyNum / wallSec : 0, game_clock_to_sec(cpuTime), cores, cores > 0 ? playingAvg / cores : 0);
+        fflush(stdout);
+        return;
+    }
+    cores = wallSec > 0 ? game_clock_to_sec(cpuTime - report->cpuTime) / wallSec : 0;
+    printf("{\"report\": \"interval\", \"sec\": %.3f, \"sessions\": %d, \"playing\": %d, \"rounds\": %llu, "
+           "\"keys_per_sec\": %.1f, \"cpu_cores\": %.3f, \"sessions_per_core\": %.1f}\n",
+           sec, openNum, playingNum, roundNum, wallSec > 0 ? (keyNum - report->keyNum) / wallSec : 0, cores,
+           cores > 0 ? playingNum / cores : 0);
+    fflush(stdout);
+    report->playingSec += playingNum * wallSec;
+    if(openNum > report->sessionMax)report->sessionMax = openNum;
+    report->time = now;
+    report->cpuTime = cpuTime;
+    report->keyNum = keyNum;
+}
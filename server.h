@@ -0,0 +1,33 @@
+/*
+ * falltyping-server と falltyping-client のやりとりの決まり
+ *
+ * 一行に一つの命令を送り、返事も一行ずつ返す。行の区切りは '\n'。
+ *
+ * クライアントからサーバへ
+ *   start LEVEL SEED   難易度 (1 : Easy 2 : Normal 3 : Difficult) と乱数の種を決めて、ゲームを始める
+ *   key CHARS          打った文字 (一文字ごとに一つ返事を返す)
+ *   quit               接続を閉じる
+ *
+ * サーバからクライアントへ
+ *   word ID EXAMPLE ORIGIN                      文字列が落ち始めた (EXAMPLE は最初の入力例、ORIGIN は行の終わりまで)
+ *   accept ID / complete ID / failure ID        キー入力の判定 (complete は文字列を入力し終えた時)
+ *   ignored                                     落ちている文字列がない、またはゲーム中でない時のキー入力
+ *   over RESULT SCORE ACCEPT FAILURE COMPLETE   ゲームが終わった (RESULT は clear か failure)
+ *   error MESSAGE                               命令が正しくない
+ * 一つの接続の返事は、命令を送った順に返す。
+ *
+ * 難易度ごとの値とスコアの計算はゲームと同じ (game_rules.c)。
+ * 落とす文字列の選び方だけはゲームと違う。ゲームは ShuffleBag で全部の文字列を一回ずつ選ぶが、
+ * サーバは決まった大きさのセッションを使い回すので文字列の数に合わせた袋を持てず、
+ * 毎回乱数で選び、落ちている文字列と同じ時だけ何回か選び直す。
+ * そのため同じ乱数の種でも、ゲームとサーバで落ちる文字列の順番は同じにならない。
+ */
+
+#ifndef FALLTYPING_SERVER_H
+#define FALLTYPING_SERVER_H
+
+#define SERVER_PORT 7650       // 何も指定しない時に使う、127.0.0.1 のポート番号
+#define SERVER_LINE_SIZE 256   // 一つの命令の最大の長さ (改行を含む)
+#define SERVER_LEVEL_NUM 3     // 難易度の数
+
+#endif
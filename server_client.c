@@ -0,0 +1,441 @@
+/*
+ * falltyping-client
+ * falltyping-server に同じマシンからたくさん接続して、決まった速さと間違える割合で打つ人を真似て遊ぶ、試験用のクライアント
+ * 一つのスレッドの epoll で全ての接続を進め、終わったら結果をJSONで標準出力に書き出す。
+ *
+ * 打つ人は一番早く落ち始めた文字列の入力例を先頭から打ち、間違える時は '!' を打つ。
+ * キー入力を送ってからその判定の返事が届くまでの時間を測り、p50/p99 も書き出す。
+ *
+ * 使い方
+ *   falltyping-client [-s 接続の数] [-r 一つの接続で遊ぶ回数] [-l 難易度] [-k 1秒に打つ数] [-e 間違える割合]
+ *                     [-p ポート番号 | -u UNIXソケットのパス] [-S 乱数の種]
+ *
+ * コンパイル (Linuxのみ)
+ *   cc -O2 -o falltyping-client server_client.c rng.c game_clock.c
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "romaji.h"
+#include "rng.h"
+#include "game_clock.h"
+#include "server.h"
+
+#define CLIENT_WORD_MAX 32          // 一つの接続で覚えておく落ちている文字列の最大の数
+#define CLIENT_PENDING_MAX 256      // 返事を待っているキー入力の最大の数
+#define CLIENT_SAMPLE_MAX 1000000   // 返事までの時間を保存するキー入力の数
+#define CLIENT_EVENT_MAX 256        // 一度に受け取る epoll のイベントの数
+#define CLIENT_TIMEOUT_SEC 600      // 全ての接続が終わるのを待つ最大の時間 (秒)
+
+/* ------ 構造体の宣言 ------*/
+// 落ちている文字列
+typedef struct{
+    int id;                             // サーバが付けた番号
+    char example[ROMAJI_EXAMPLE_SIZE];  // 入力例
+    int pos;                            // 次に打つ入力例の位置
+}ClientWord;
+
+// 一つの接続で打つ人
+typedef struct{
+    int fd;                      // 接続 (-1は閉じた)
+    Rng rng;                     // 打つ間隔と間違えるかを決める乱数
+    int roundLeft;               // 残りの遊ぶ回数
+    int isPlaying;               // ゲーム中かどうか
+    long long nextKeyTime;       // 次に打つ実際の時間 (ナノ秒)
+    ClientWord words[CLIENT_WORD_MAX]; // 落ちている文字列 (落ち始めた順のリングバッファ)
+    int wordHead;                // 一番早く落ち始めた文字列の位置
+    int wordNum;                 // 落ちている文字列の数
+    long long sentTime[CLIENT_PENDING_MAX]; // 返事を待っているキー入力を送った時間 (リングバッファ)
+    int pendingHead;             // 一番古い返事を待っているキー入力の位置
+    int pendingNum;              // 返事を待っているキー入力の数
+    char in[SERVER_LINE_SIZE];   // 改行までそろっていない返事
+    int inLen;                   // in の文字数
+}Player;
+
+// 全ての接続の結果
+typedef struct{
+    int roundNum;                // 終わったゲームの数
+    int clearNum;                // クリアしたゲームの数
+    int failureNum;              // 終了の線に当たったゲームの数
+    long long scoreSum;          // スコアの合計
+    long long keyNum;            // 送ったキー入力の数
+    int errorNum;                // 途中で閉じた接続と error の返事の数
+    long long *samples;          // 返事までの時間
+    int sampleNum;               // 保存した時間の数
+}ClientResult;
+
+/* ------ プロトタイプ宣言 ------ */
+static int connect_server(int port, const char *unixPath); // サーバに接続する
+static int send_line(Player *player, const char *line); // 一行を送る
+static void start_round(Player *player, int level); // 新しいゲームを始める
+static int read_lines(Player *player, ClientResult *result, int level, long long now); // 届いた返事を読んで処理する
+static void handle_line(Player *player, ClientResult *result, int level, char *line, long long now); // 一つの返事を処理する
+static void type_key(Player *player, ClientResult *result, double kps, double errorRate, long long now); // 一文字打つ
+static void close_player(Player *player); // 接続を閉じる
+static int compare_long(const void *a, const void *b); // qsort で時間を比べる
+
+/* ---------------------- */
+/* ------ メイン処理 ------ */
+/* ---------------------- */
+int main(int argc, char *argv[]) {
+    int playerNum = 100; // 接続の数
+    int roundNum = 1; // 一つの接続で遊ぶ回数
+    int level = 2; // 難易度
+    double kps = 6.0; // 1秒に打つ数
+    double errorRate = 0.05; // 間違える割合
+    int port = SERVER_PORT; // TCPのポート番号
+    const char *unixPath = NULL; // UNIXソケットのパス (NULLの時はTCP)
+    unsigned long long seed = 1; // 乱数の種
+    int option; // 読んだオプション
+    Player *players; // 接続ごとの打つ人
+    ClientResult result = {0}; // 全ての接続の結果
+    struct epoll_event event; // epoll に登録するイベント
+    struct epoll_event events[CLIENT_EVENT_MAX]; // 受け取ったイベント
+    struct rlimit limit; // 開けるファイルの数
+    int epollFd; // 全ての接続を待ち受ける epoll
+    int eventNum; // 受け取ったイベントの数
+    int openNum = 0; // 開いている接続の数
+    long long startTime; // 始めた実際の時間
+    long long now; // 今の実際の時間
+    Player *player; // イベントが来た接続
+    double sec; // かかった秒数
+
+    while((option = getopt(argc, argv, "s:r:l:k:e:p:u:S:")) != -1){
+        switch(option){
+            case 's': playerNum = atoi(optarg); break;
+            case 'r': roundNum = atoi(optarg); break;
+            case 'l': level = atoi(optarg); break;
+            case 'k': kps = atof(optarg); break;
+            case 'e': errorRate = atof(optarg); break;
+            case 'p': port = atoi(optarg); break;
+            case 'u': unixPath = optarg; break;
+            case 'S': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                printf("使い方: %s [-s 接続の数] [-r 遊ぶ回数] [-l 難易度] [-k 1秒に打つ数] [-e 間違える割合] [-p ポート番号 | -u UNIXソケットのパス] [-S 乱数の種]\n", argv[0]);
+                return 1;
+        }
+    }
+    if(playerNum < 1 || roundNum < 1 || level < 1 || level > SERVER_LEVEL_NUM || kps <= 0){
+        printf("接続の数、遊ぶ回数、難易度、1秒に打つ数の値が正しくありません\n");
+        return 1;
+    }
+    if(getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max){
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    players = (Player*) calloc(playerNum, sizeof(Player));
+    result.samples = (long long*) malloc(sizeof(long long) * CLIENT_SAMPLE_MAX);
+    if(players == NULL || result.samples == NULL || (epollFd = epoll_create1(0)) < 0){
+        printf("接続の準備に失敗しました\n");
+        return 1;
+    }
+
+    startTime = game_clock_real_ns();
+    for(int i = 0; i < playerNum; i++){
+        player = &players[i];
+        if((player->fd = connect_server(port, unixPath)) < 0){
+            printf("%d個目の接続に失敗しました (%s)\n", i + 1, strerror(errno));
+            return 1;
+        }
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.ptr = player;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, player->fd, &event);
+        rng_seed(&player->rng, seed, (uint64_t)i);
+        player->roundLeft = roundNum;
+        start_round(player, level);
+        openNum++;
+    }
+
+    while(openNum > 0 && game_clock_real_ns() - startTime < game_clock_from_sec(CLIENT_TIMEOUT_SEC)){
+        eventNum = epoll_wait(epollFd, events, CLIENT_EVENT_MAX, 1);
+        now = game_clock_real_ns();
+        for(int i = 0; i < eventNum; i++){
+            player = events[i].data.ptr;
+            if(player->fd >= 0 && read_lines(player, &result, level, now) != 0){
+                if(player->roundLeft > 0){ // 遊び終える前に閉じられた
+                    result.errorNum++;
+                }
+                close_player(player);
+                openNum--;
+            }
+        }
+        for(int i = 0; i < playerNum; i++){
+            if(players[i].fd >= 0 && players[i].isPlaying && players[i].nextKeyTime <= now){
+                type_key(&players[i], &result, kps, errorRate, now);
+            }
+        }
+    }
+    sec = game_clock_to_sec(game_clock_real_ns() - startTime);
+
+    qsort(result.samples, result.sampleNum, sizeof(long long), compare_long);
+    printf("{\n  \"sessions\": %d,\n  \"level\": %d,\n  \"kps\": %.1f,\n  \"error_rate\": %.3f,\n  \"sec\": %.3f,\n",
+           playerNum, level, kps, errorRate, sec);
+    printf("  \"rounds\": %d,\n  \"clear\": %d,\n  \"failure\": %d,\n  \"score_avg\": %.1f,\n  \"errors\": %d,\n",
+           result.roundNum, result.clearNum, result.failureNum,
+           result.roundNum > 0 ? (double)result.scoreSum / result.roundNum : 0, result.errorNum + openNum);
+    printf("  \"keys\": %lld,\n  \"keys_per_sec\": %.1f,\n", result.keyNum, sec > 0 ? result.keyNum / sec : 0);
+    if(result.sampleNum > 0){
+        printf("  \"rtt_us\": {\"p50\": %.1f, \"p99\": %.1f, \"max\": %.1f}\n",
+               result.samples[result.sampleNum / 2] / 1000.0,
+               result.samples[(int)(result.sampleNum * 0.99)] / 1000.0,
+               result.samples[result.sampleNum - 1] / 1000.0);
+    }else{
+        printf("  \"rtt_us\": null\n");
+    }
+    printf("}\n");
+
+    for(int i = 0; i < playerNum; i++){
+        close_player(&players[i]);
+    }
+    close(epollFd);
+    free(result.samples);
+    free(players);
+    return 0;
+}
+
+/**
+ * サーバに接続して、読み書きで待たないようにする
+ *
+ * @param port TCPのポート番号
+ * @param unixPath UNIXソケットのパス (NULLの時は 127.0.0.1 のTCP)
+ *
+ * @return 接続 -1 : 接続できなかった
+ */
+static int connect_server(int port, const char *unixPath){
+    struct sockaddr_in inAddr = {0}; // TCPのアドレス
+    struct sockaddr_un unAddr = {0}; // UNIXソケットのアドレス
+    int fd; // 接続
+    int yes = 1; // ソケットのオプションに設定する値
+    int result; // 接続の結果
+
+    if(unixPath != NULL){
+        unAddr.sun_family = AF_UNIX;
+        strncpy(unAddr.sun_path, unixPath, sizeof(unAddr.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        result = fd < 0 ? -1 : connect(fd, (struct sockaddr*)&unAddr, sizeof(unAddr));
+    }else{
+        inAddr.sin_family = AF_INET;
+        inAddr.sin_port = htons(port);
+        inAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        result = fd < 0 ? -1 : connect(fd, (struct sockaddr*)&inAddr, sizeof(inAddr));
+        if(result == 0){
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        }
+    }
+    if(result != 0){
+        if(fd >= 0)close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * 一行を送る
+ * 送りきれない時は、サーバが受け取れていないので失敗とする
+ *
+ * @param player 打つ人
+ * @param line 改行を含む一行
+ *
+ * @return 0 : 送った -1 : 送れなかった
+ */
+static int send_line(Player *player, const char *line){
+    size_t len = strlen(line); // 行の長さ
+
+    return send(player->fd, line, len, MSG_NOSIGNAL | MSG_DONTWAIT) == (ssize_t)len ? 0 : -1;
+}
+
+/**
+ * 新しいゲームを始める
+ *
+ * @param player 打つ人
+ * @param level 難易度
+ */
+static void start_round(Player *player, int level){
+    char line[64]; // 送る命令
+
+    snprintf(line, sizeof(line), "start %d %u\n", level, rng_next(&player->rng));
+    player->isPlaying = 1;
+    player->wordHead = 0;
+    player->wordNum = 0;
+    player->nextKeyTime = game_clock_real_ns();
+    send_line(player, line);
+}
+
+/**
+ * 届いた返事を読めるだけ読んで、改行までそろった返事を順に処理する
+ *
+ * @param player 打つ人
+ * @param result 全ての接続の結果
+ * @param level 難易度
+ * @param now 返事を受け取った実際の時間 (ナノ秒)
+ *
+ * @return 0 : 続ける -1 : 接続が閉じられた
+ */
+static int read_lines(Player *player, ClientResult *result, int level, long long now){
+    ssize_t readNum; // 読んだバイト数
+    char *lineEnd; // 返事の終わりの改行
+    int lineStart; // 処理していない返事の先頭の位置
+
+    for(;;){
+        readNum = recv(player->fd, player->in + player->inLen, SERVER_LINE_SIZE - player->inLen, MSG_DONTWAIT);
+        if(readNum == 0){
+            return -1;
+        }
+        if(readNum < 0){
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+        }
+        player->inLen += (int)readNum;
+        lineStart = 0;
+        while((lineEnd = memchr(player->in + lineStart, '\n', player->inLen - lineStart)) != NULL){
+            *lineEnd = '\0';
+            handle_line(player, result, level, player->in + lineStart, now);
+            lineStart = (int)(lineEnd - player->in) + 1;
+        }
+        if(lineStart == 0 && player->inLen == SERVER_LINE_SIZE){
+            return -1;
+        }
+        memmove(player->in, player->in + lineStart, player->inLen - lineStart);
+        player->inLen -= lineStart;
+    }
+}
+
+/**
+ * 一つの返事を処理する
+ *
+ * @param player 打つ人
+ * @param result 全ての接続の結果
+ * @param level 難易度
+ * @param line 改行を除いた返事
+ * @param now 返事を受け取った実際の時間 (ナノ秒)
+ */
+static void handle_line(Player *player, ClientResult *result, int level, char *line, long long now){
+    ClientWord *word; // 落ち始めた文字列
+    char isClear[16]; // ゲームの結果
+    int id; // 文字列の番号
+    int score; // スコア
+
+    if(sscanf(line, "word %d", &id) == 1){
+        if(player->wordNum == CLIENT_WORD_MAX){
+            return;
+        }
+        word = &player->words[(player->wordHead + player->wordNum) % CLIENT_WORD_MAX];
+        word->id = id;
+        word->pos = 0;
+        if(sscanf(line, "word %*d %127s", word->example) != 1){
+            return;
+        }
+        if(player->wordNum == 0){ // 打つ文字列がなかった時は、読んでから打ち始める
+            player->nextKeyTime = now + game_clock_from_sec(1.0 / 3);
+        }
+        player->wordNum++;
+        return;
+    }
+    if(sscanf(line, "over %15s %d", isClear, &score) == 2){
+        result->roundNum++;
+        result->scoreSum += score;
+        if(strcmp(isClear, "clear") == 0){
+            result->clearNum++;
+        }else{
+            result->failureNum++;
+        }
+        player->isPlaying = 0;
+        player->roundLeft--;
+        if(player->roundLeft > 0){
+            start_round(player, level);
+        }else{
+            send_line(player, "quit\n");
+        }
+        return;
+    }
+    if(strncmp(line, "error", 5) == 0){
+        result->errorNum++;
+        return;
+    }
+    // 残りはキー入力への返事なので、送った順に返事までの時間を数える
+    if(player->pendingNum > 0){
+        if(result->sampleNum < CLIENT_SAMPLE_MAX){
+            result->samples[result->sampleNum++] = now - player->sentTime[player->pendingHead];
+        }
+        player->pendingHead = (player->pendingHead + 1) % CLIENT_PENDING_MAX;
+        player->pendingNum--;
+    }
+    if(sscanf(line, "complete %d", &id) == 1 && player->wordNum > 0 && player->words[player->wordHead].id == id){
+        player->wordHead = (player->wordHead + 1) % CLIENT_WORD_MAX;
+        player->wordNum--;
+    }
+}
+
+/**
+ * 一番早く落ち始めた文字列の入力例の次の文字を打つ (間違える時は '!' を打つ)
+ * 入力例を打ち終えた時は、complete の返事が届くまで打たない
+ *
+ * @param player 打つ人
+ * @param result 全ての接続の結果
+ * @param kps 1秒に打つ数
+ * @param errorRate 間違える割合
+ * @param now 今の実際の時間 (ナノ秒)
+ */
+static void type_key(Player *player, ClientResult *result, double kps, double errorRate, long long now){
+    ClientWord *word; // 打つ文字列
+    char line[8] = "key x\n"; // 送る命令
+
+    // 打つ間隔は平均が 1/kps 秒になるようにばらつかせる
+    player->nextKeyTime = now + game_clock_from_sec((0.5 + rng_double(&player->rng)) / kps);
+    if(player->wordNum == 0 || player->pendingNum == CLIENT_PENDING_MAX){
+        return;
+    }
+    word = &player->words[player->wordHead];
+    if(word->example[word->pos] == '\0'){
+        return;
+    }
+    if(rng_double(&player->rng) < errorRate){
+        line[4] = '!';
+    }else{
+        line[4] = word->example[word->pos++];
+    }
+    if(send_line(player, line) != 0){
+        return;
+    }
+    player->sentTime[(player->pendingHead + player->pendingNum) % CLIENT_PENDING_MAX] = now;
+    player->pendingNum++;
+    result->keyNum++;
+}
+
+/**
+ * 接続を閉じる
+ *
+ * @param player 打つ人
+ */
+static void close_player(Player *player){
+    if(player->fd >= 0){
+        close(player->fd);
+        player->fd = -1;
+    }
+}
+
+/**
+ * qsort で時間を比べる
+ *
+ * @param a 一つ目の時間
+ * @param b 二つ目の時間
+ *
+ * @return a が小さい時は負、大きい時は正、等しい時は0
+ */
+static int compare_long(const void *a, const void *b){
+    long long x = *(const long long*)a; // 一つ目の時間
+    long long y = *(const long long*)b; // 二つ目の時間
+
+    return (x > y) - (x < y);
+}
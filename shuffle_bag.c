@@ -0,0 +1,127 @@
+/*
+ * 落とす文字列を選ぶシャッフルバッグ
+ */
+
+#include <stdlib.h>
+#include "shuffle_bag.h"
+
+/* ------ プロトタイプ宣言 ------ */
+static void swap_items(ShuffleBag *bag, int a, int b); // items の二つの位置を入れ替える
+
+/**
+ * 0からnum-1までの番号を入れた袋を作る
+ *
+ * @param bag 袋
+ * @param num 番号の数
+ * @param rng 使う乱数生成器
+ *
+ * @return 0:成功 -1:メモリの確保に失敗
+ */
+int shuffle_bag_init(ShuffleBag *bag, int num, Rng *rng){
+    bag->items = (int*) malloc((num > 0 ? num : 1) * sizeof(int));
+    bag->positions = (int*) malloc((num > 0 ? num : 1) * sizeof(int));
+    if(bag->items == NULL || bag->positions == NULL){
+        free(bag->items);
+        free(bag->positions);
+        return -1;
+    }
+    for(int i = 0; i < num; i++){
+        bag->items[i] = i;
+        bag->positions[i] = i;
+    }
+    bag->num = num;
+    bag->availableNum = num;
+    bag->freeNum = num;
+    bag->rng = rng;
+    return 0;
+}
+
+/**
+ * 袋のメモリを解放する
+ *
+ * @param bag 袋
+ */
+void shuffle_bag_free(ShuffleBag *bag){
+    free(bag->items);
+    free(bag->positions);
+    bag->items = NULL;
+    bag->positions = NULL;
+    bag->num = 0;
+    bag->availableNum = 0;
+    bag->freeNum = 0;
+}
+
+/**
+ * 袋から一つ選んで取り出す
+ * 袋が空の時は返された番号を全て戻してから選ぶ
+ *
+ * @param bag 袋
+ *
+ * @return 選んだ番号 全て取り出されていて選べない時は-1
+ */
+int shuffle_bag_draw(ShuffleBag *bag){
+    int pick; // 選んだ位置
+    int index; // 選んだ番号
+
+    if(bag->availableNum == 0){ // 空になったので、返された番号を戻す
+        bag->availableNum = bag->freeNum;
+    }
+    if(bag->availableNum == 0){
+        return -1;
+    }
+    // まだ選んでいない範囲から一つ選んで、その範囲の末尾と入れ替える
+    pick = (int)rng_range(bag->rng, (uint32_t)bag->availableNum);
+    swap_items(bag, pick, bag->availableNum - 1);
+    bag->availableNum--;
+    // 選んだ番号を、返されていない範囲に移す
+    swap_items(bag, bag->availableNum, bag->freeNum - 1);
+    bag->freeNum--;
+    index = bag->items[bag->freeNum];
+    return index;
+}
+
+/**
+ * 取り出した番号を返す 返した番号は袋が空になった時に戻る
+ *
+ * @param bag 袋
+ * @param index 返す番号
+ */
+void shuffle_bag_release(ShuffleBag *bag, int index){
+    if(index < 0 || bag->num <= index || bag->positions[index] < bag->freeNum){
+        return; // 取り出されていない
+    }
+    swap_items(bag, bag->positions[index], bag->freeNum);
+    bag->freeNum++;
+}
+
+/**
+ * 取り出した番号を、まだ選んでいない番号に戻す
+ * 候補として取り出したが使わなかった番号を、袋が空になるのを待たずにまた選べるようにする
+ *
+ * @param bag 袋
+ * @param index 戻す番号
+ */
+void shuffle_bag_unget(ShuffleBag *bag, int index){
+    if(index < 0 || bag->num <= index || bag->positions[index] < bag->freeNum){
+        return; // 取り出されていない
+    }
+    shuffle_bag_release(bag, index);
+    swap_items(bag, bag->positions[index], bag->availableNum);
+    bag->availableNum++;
+}
+
+/**
+ * items の二つの位置を入れ替えて、positions も合わせる
+ *
+ * @param bag 袋
+ * @param a 入れ替える位置
+ * @param b 入れ替える位置
+ */
+static void swap_items(ShuffleBag *bag, int a, int b){
+    int tmp = bag->items[a]; // 入れ替えるための一時的な変数
+
+    bag->items[a] = bag->items[b];
+    bag->items[b] = tmp;
+    bag->positions[bag->items[a]] = a;
+    bag->positions[bag->items[b]] = b;
+}
@@ -0,0 +1,36 @@
+/*
+ * 落とす文字列を選ぶシャッフルバッグ
+ * Fisher–Yates のシャッフルを一回に一要素ずつ進めるので、選ぶのはやり直しなしで一定の時間で終わる。
+ * 選んだ文字列は返すまで袋に戻らないので、落ちている文字列を同時にもう一度選ぶことはない。
+ * 袋が空になった時は、返された文字列を全て袋に戻して続ける。
+ *
+ * 配列 items は次の三つの範囲に分かれている
+ *   [0, availableNum)         まだ選んでいない文字列
+ *   [availableNum, freeNum)   選んで返された文字列 (袋が空になったら戻す)
+ *   [freeNum, num)            選んでまだ返されていない文字列
+ */
+
+#ifndef FALLTYPING_SHUFFLE_BAG_H
+#define FALLTYPING_SHUFFLE_BAG_H
+
+#include "rng.h"
+
+/* ------ 構造体の宣言 ------*/
+// シャッフルバッグ
+typedef struct{
+    int *items;       // 文字列の番号を並べた配列
+    int *positions;   // 文字列の番号ごとの items の中の位置
+    int num;          // 文字列の数
+    int availableNum; // まだ選んでいない文字列の数
+    int freeNum;      // 選べる、または袋に戻せる文字列の数
+    Rng *rng;         // 使う乱数生成器
+}ShuffleBag;
+
+/* ------ プロトタイプ宣言 ------ */
+int shuffle_bag_init(ShuffleBag *bag, int num, Rng *rng); // 0からnum-1までの番号を入れた袋を作る
+void shuffle_bag_free(ShuffleBag *bag); // 袋のメモリを解放する
+int shuffle_bag_draw(ShuffleBag *bag); // 袋から一つ選んで取り出す
+void shuffle_bag_release(ShuffleBag *bag, int index); // 取り出した番号を返す
+void shuffle_bag_unget(ShuffleBag *bag, int index); // 取り出した番号を、まだ選んでいない番号に戻す
+
+#endif
@@ -0,0 +1,186 @@
+/*
+ * 落ち始める位置の近くで、文字列が横方向に使っている範囲の一覧
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "span_index.h"
+
+#define SPAN_INDEX_FIRST_CAPACITY 16 // 最初に確保する範囲の数
+
+/**
+ * 空の一覧を作る
+ *
+ * @param index 一覧
+ * @param width 画面の幅
+ * @param margin 文字列の間に空ける幅
+ *
+ * @return 0:成功 -1:メモリの確保に失敗
+ */
+int span_index_init(SpanIndex *index, double width, double margin){
+    index->spans = (Span*) malloc(SPAN_INDEX_FIRST_CAPACITY * sizeof(Span));
+    if(index->spans == NULL){
+        return -1;
+    }
+    index->num = 0;
+    index->capacity = SPAN_INDEX_FIRST_CAPACITY;
+    index->width = width;
+    index->margin = margin;
+    return 0;
+}
+
+/**
+ * 一覧のメモリを解放する
+ *
+ * @param index 一覧
+ */
+void span_index_free(SpanIndex *index){
+    free(index->spans);
+    index->spans = NULL;
+    index->num = 0;
+    index->capacity = 0;
+}
+
+/**
+ * 範囲を左端の順になる位置に追加する
+ *
+ * @param index 一覧
+ * @param left 左端のx座標
+ * @param right 右端のx座標
+ * @param owner 文字列の番号
+ * @param expire 一覧から外すゲームの時間
+ *
+ * @return 0:成功 -1:メモリの確保に失敗
+ */
+int span_index_insert(SpanIndex *index, double left, double right, int owner, long long expire){
+    int low = 0, high = index->num; // 二分探索の範囲
+
+    if(index->num >= index->capacity){
+        Span *newSpans = (Span*) realloc(index->spans, index->capacity * 2 * sizeof(Span));
+        if(newSpans == NULL){
+            return -1;
+        }
+        index->spans = newSpans;
+        index->capacity *= 2;
+    }
+    while(low < high){
+        int mid = (low + high) / 2; // 真ん中の位置
+
+        if(index->spans[mid].left <= left){
+            low = mid + 1;
+        }else{
+            high = mid;
+        }
+    }
+    memmove(&index->spans[low + 1], &index->spans[low], (index->num - low) * sizeof(Span));
+    index->spans[low].left = left;
+    index->spans[low].right = right;
+    index->spans[low].owner = owner;
+    index->spans[low].expire = expire;
+    index->num++;
+    return 0;
+}
+
+/**
+ * 文字列の範囲を外す 入力が終わった文字列はもう重ならないので外す
+ *
+ * @param index 一覧
+ * @param owner 文字列の番号
+ */
+void span_index_remove(SpanIndex *index, int owner){
+    for(int i = 0; i < index->num; i++){
+        if(index->spans[i].owner == owner){
+            memmove(&index->spans[i], &index->spans[i + 1], (index->num - i - 1) * sizeof(Span));
+            index->num--;
+            return;
+        }
+    }
+}
+
+/**
+ * 落ち始める位置から離れて、時間を過ぎた範囲を外す
+ *
+ * @param index 一覧
+ * @param now 今のゲームの時間
+ */
+void span_index_expire(SpanIndex *index, long long now){
+    int kept = 0; // 残す範囲の数
+
+    for(int i = 0; i < index->num; i++){
+        if(now < index->spans[i].expire){
+            index->spans[kept] = index->spans[i];
+            kept++;
+        }
+    }
+    index->num = kept;
+}
+
+/**
+ * 幅 width の文字列を、使っている範囲に重ならない位置からランダムに選んで、左端のx座標を返す
+ * 置ける左端の範囲の長さの合計から一様に選ぶので、広い空きほど選ばれやすい
+ * どこにも置けない時は、一番広い空きの真ん中に置く
+ *
+ * @param index 一覧
+ * @param width 置く文字列の幅
+ * @param rng 乱数生成器
+ *
+ * @return 左端のx座標
+ */
+double span_index_place(const SpanIndex *index, double width, Rng *rng){
+    double limit = index->width - width; // 左端に置ける最大のx座標
+    double total = 0; // 置ける左端の範囲の長さの合計
+    double target = 0; // 選んだ長さ
+    double gapLeft = 0; // 今の空きの左端
+    double bestLeft = 0, bestRight = index->width; // 一番広い空き
+    double bestWidth = -1; // 一番広い空きの幅
+    double lastTo = 0; // 最後に見つけた置ける左端の最大
+
+    if(limit <= 0){ // 画面に収まらない時は左端から落とす
+        return 0;
+    }
+
+    // 範囲は左端の順に並んでいるので、前から順に空きを調べる 一回目は合計を、二回目は位置を求める
+    for(int pass = 0; pass < 2; pass++){
+        gapLeft = 0;
+        if(pass == 1){
+            target = rng_double(rng) * total;
+        }
+        for(int i = 0; i <= index->num; i++){
+            double gapRight = i < index->num ? index->spans[i].left - index->margin : index->width; // 今の空きの右端
+            double from = gapLeft; // 置ける左端の最小
+            double to = (gapRight < index->width ? gapRight : index->width) - width; // 置ける左端の最大
+
+            if(to > limit)to = limit;
+            if(pass == 0 && gapRight - gapLeft > bestWidth){
+                bestWidth = gapRight - gapLeft;
+                bestLeft = gapLeft;
+                bestRight = gapRight;
+            }
+            if(from <= to){
+                if(pass == 0){
+                    total += to - from;
+                }else if(target <= to - from){
+                    return from + target;
+                }else{
+                    target -= to - from;
+                    lastTo = to;
+                }
+            }
+            if(i < index->num && index->spans[i].right + index->margin > gapLeft){
+                gapLeft = index->spans[i].right + index->margin;
+            }
+        }
+        if(pass == 0 && total <= 0){
+            break;
+        }
+    }
+    if(total > 0){ // 丸めの誤差で最後まで進んだ時は、最後の空きに置く
+        return lastTo;
+    }
+
+    // どこにも置けない時は、一番広い空きの真ん中に置いて、重なりをできるだけ小さくする
+    target = (bestLeft + bestRight) / 2 - width / 2;
+    if(target < 0)target = 0;
+    if(target > limit)target = limit;
+    return target;
+}
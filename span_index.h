@@ -0,0 +1,41 @@
+/*
+ * 落ち始める位置の近くで、文字列が横方向に使っている範囲の一覧
+ * 新しく落とす文字列の位置を、すでに落ちている文字列に重ならない空きから選ぶのに使う。
+ * 文字列は全て同じ速さで落ちるので、落ち始めてから一定の時間が経った文字列は、
+ * 落ち始める位置から十分離れていて重ならない。その時間を過ぎた範囲は一覧から外す。
+ *
+ * 範囲は左端の順に並べて保存し、追加する位置は二分探索で探す。
+ */
+
+#ifndef FALLTYPING_SPAN_INDEX_H
+#define FALLTYPING_SPAN_INDEX_H
+
+#include "rng.h"
+
+/* ------ 構造体の宣言 ------*/
+// 一つの文字列が使っている範囲
+typedef struct{
+    double left;      // 左端のx座標
+    double right;     // 右端のx座標
+    int owner;        // 文字列の番号
+    long long expire; // 一覧から外すゲームの時間 (ナノ秒)
+}Span;
+
+// 使っている範囲の一覧
+typedef struct{
+    Span *spans;   // 左端の順に並べた範囲
+    int num;       // 範囲の数
+    int capacity;  // 確保した範囲の数
+    double width;  // 画面の幅
+    double margin; // 文字列の間に空ける幅
+}SpanIndex;
+
+/* ------ プロトタイプ宣言 ------ */
+int span_index_init(SpanIndex *index, double width, double margin); // 空の一覧を作る
+void span_index_free(SpanIndex *index); // 一覧のメモリを解放する
+int span_index_insert(SpanIndex *index, double left, double right, int owner, long long expire); // 範囲を追加する
+void span_index_remove(SpanIndex *index, int owner); // 文字列の範囲を外す
+void span_index_expire(SpanIndex *index, long long now); // 時間を過ぎた範囲を外す
+double span_index_place(const SpanIndex *index, double width, Rng *rng); // 重ならない位置を選ぶ
+
+#endif
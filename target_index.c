@@ -0,0 +1,189 @@
+/*
+ * 落ちている文字列のどれにでも入力できるようにするための、最初の一文字の索引
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "target_index.h"
+
+#define TARGET_QUEUE_FIRST_CAPACITY 8 // 列に最初に確保する要素の数
+
+/* ------ プロトタイプ宣言 ------ */
+static int queue_push(const TargetIndex *index, TargetQueue *queue, int strIndex); // 列の末尾に追加する
+
+/**
+ * 空の索引を作る
+ *
+ * @param index 索引
+ * @param capacity 文字列の数
+ *
+ * @return 0:成功 -1:メモリの確保に失敗
+ */
+int target_index_init(TargetIndex *index, int capacity){
+    memset(index->queues, 0, sizeof(index->queues));
+    index->generations = (unsigned int*) calloc(capacity > 0 ? capacity : 1, sizeof(unsigned int));
+    index->isListed = (int*) calloc(capacity > 0 ? capacity : 1, sizeof(int));
+    index->capacity = capacity;
+    if(index->generations == NULL || index->isListed == NULL){
+        target_index_free(index);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 索引のメモリを解放する
+ *
+ * @param index 索引
+ */
+void target_index_free(TargetIndex *index){
+    for(int i = 0; i < ROMAJI_CHAR_NUM; i++){
+        free(index->queues[i].entries);
+        index->queues[i].entries = NULL;
+        index->queues[i].head = 0;
+        index->queues[i].tail = 0;
+        index->queues[i].capacity = 0;
+    }
+    free(index->generations);
+    free(index->isListed);
+    index->generations = NULL;
+    index->isListed = NULL;
+    index->capacity = 0;
+}
+
+/**
+ * 最初に打てる文字ごとの列に文字列を追加する
+ *
+ * @param index 索引
+ * @param strIndex 文字列の番号
+ * @param keys 最初に打てる文字の集合 (romaji_next_keys の返り値)
+ *
+ * @return 0:成功 -1:番号が範囲外か、メモリの確保に失敗
+ */
+int target_index_add(TargetIndex *index, int strIndex, unsigned int keys){
+    if(strIndex < 0 || index->capacity <= strIndex){
+        return -1;
+    }
+    target_index_remove(index, strIndex); // 前に追加した時の要素は古い要素にする
+    index->isListed[strIndex] = 1;
+    for(int i = 0; i < ROMAJI_CHAR_NUM; i++){
+        if((keys & (1u << i)) != 0 && queue_push(index, &index->queues[i], strIndex) != 0){
+            target_index_remove(index, strIndex);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * 文字列を索引から外す 列の中の要素は世代の番号が古くなり、先頭に来た時に捨てられる
+ *
+ * @param index 索引
+ * @param strIndex 文字列の番号
+ */
+void target_index_remove(TargetIndex *index, int strIndex){
+    if(strIndex < 0 || index->capacity <= strIndex || index->isListed[strIndex] == 0){
+        return;
+    }
+    index->generations[strIndex]++;
+    index->isListed[strIndex] = 0;
+}
+
+/**
+ * 入力された文字で始まる文字列のうち、一番早く追加したものを返す
+ * 返した文字列は外さないので、入力先に決めた時に target_index_remove で外すこと
+ *
+ * @param index 索引
+ * @param ch 入力された文字
+ *
+ * @return 文字列の番号 ない時は-1
+ */
+int target_index_find(TargetIndex *index, unsigned int ch){
+    int charIndex = romaji_char_index(ch); // 遷移の番号
+    TargetQueue *queue; // 入力された文字の列
+
+    if(charIndex < 0){
+        return -1;
+    }
+    queue = &index->queues[charIndex];
+    while(queue->head < queue->tail){
+        TargetEntry *entry = &queue->entries[queue->head]; // 先頭の要素
+
+        if(index->isListed[entry->index] == 1 && index->generations[entry->index] == entry->generation){
+            return entry->index;
+        }
+        queue->head++; // 古い要素は捨てる
+    }
+    return -1;
+}
+
+/**
+ * 入力された文字で始まる文字列を、追加した順に全て返す
+ * 返した文字列は外さないので、入力先の候補にした時に target_index_remove で外すこと
+ *
+ * @param index 索引
+ * @param ch 入力された文字
+ * @param strIndexes 文字列の番号を保存する配列
+ * @param max 保存できる番号の数
+ *
+ * @return 保存した番号の数
+ */
+int target_index_collect(TargetIndex *index, unsigned int ch, int *strIndexes, int max){
+    int charIndex = romaji_char_index(ch); // 遷移の番号
+    TargetQueue *queue; // 入力された文字の列
+    int num = 0; // 保存した番号の数
+
+    if(charIndex < 0 || target_index_find(index, ch) == -1){ // 先頭の古い要素も捨てておく
+        return 0;
+    }
+    queue = &index->queues[charIndex];
+    for(int i = queue->head; i < queue->tail && num < max; i++){
+        TargetEntry entry = queue->entries[i]; // 調べる要素
+
+        if(index->isListed[entry.index] == 1 && index->generations[entry.index] == entry.generation){
+            strIndexes[num++] = entry.index;
+        }
+    }
+    return num;
+}
+
+/**
+ * 列の末尾に追加する 空きがない時は、古い要素を捨てて詰めるか、大きく確保し直す
+ * 一つの文字列は最初に打てる文字の全ての列に並ぶので、打たれなかった文字の列には先頭に来ない古い要素が残る。
+ * 詰める時は先頭だけでなく列の全ての古い要素を捨てるので、列の大きさは索引に入っている文字列の数の2倍を超えず、
+ * ゲームをどれだけ長く続けてもメモリは増え続けない。
+ *
+ * @param index 索引
+ * @param queue 列
+ * @param strIndex 文字列の番号
+ *
+ * @return 0:成功 -1:メモリの確保に失敗
+ */
+static int queue_push(const TargetIndex *index, TargetQueue *queue, int strIndex){
+    if(queue->tail >= queue->capacity){
+        int num = 0; // 残っている要素の数
+
+        for(int i = queue->head; i < queue->tail; i++){
+            TargetEntry entry = queue->entries[i]; // 残すかどうかを調べる要素
+
+            if(index->isListed[entry.index] == 1 && index->generations[entry.index] == entry.generation){
+                queue->entries[num++] = entry;
+            }
+        }
+        queue->head = 0;
+        queue->tail = num;
+        if(num >= queue->capacity / 2){
+            int capacity = queue->capacity == 0 ? TARGET_QUEUE_FIRST_CAPACITY : queue->capacity * 2; // 新しく確保する数
+            TargetEntry *newEntries = (TargetEntry*) realloc(queue->entries, capacity * sizeof(TargetEntry));
+            if(newEntries == NULL){
+                return -1;
+            }
+            queue->entries = newEntries;
+            queue->capacity = capacity;
+        }
+    }
+    queue->entries[queue->tail].index = strIndex;
+    queue->entries[queue->tail].generation = index->generations[strIndex];
+    queue->tail++;
+    return 0;
+}
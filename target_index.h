@@ -0,0 +1,49 @@
+/*
+ * 落ちている文字列のどれにでも入力できるようにするための、最初の一文字の索引
+ * 文字列の最初に打てる文字は入力判定の表から決まるので、落とした時に打てる文字ごとの列に文字列を並べておく。
+ * キー入力が来たら、その文字の列の先頭を見るだけで入力先が決まり、文字列を一つずつ比べる必要はない。
+ *
+ * 列は落とした順に並ぶので、同じ文字で始まる文字列が複数ある時は、一番早く落ち始めた
+ * (一番終わりの線に近い) 文字列が選ばれる。入力先を続くキー入力で絞り込む時は、同じ文字で始まる文字列を
+ * 落とした順に全て取り出せる。
+ * 入力先に決まった文字列と入力が終わった文字列は外す。外した文字列は世代の番号を進めて古い要素として扱い、
+ * 列の先頭に来た時か、列に空きがなくなった時に捨てるので、外すのも選ぶのもならして一定の時間で終わる。
+ */
+
+#ifndef FALLTYPING_TARGET_INDEX_H
+#define FALLTYPING_TARGET_INDEX_H
+
+#include "romaji.h"
+
+/* ------ 構造体の宣言 ------*/
+// 列の一つの要素
+typedef struct{
+    int index;               // 文字列の番号
+    unsigned int generation; // 追加した時の文字列の世代の番号
+}TargetEntry;
+
+// 一つの文字で始まる文字列の列
+typedef struct{
+    TargetEntry *entries; // 要素の配列
+    int head;             // 先頭の要素の位置
+    int tail;             // 末尾の次の位置
+    int capacity;         // 確保した要素の数
+}TargetQueue;
+
+// 最初の一文字の索引
+typedef struct{
+    TargetQueue queues[ROMAJI_CHAR_NUM]; // 入力文字ごとの列
+    unsigned int *generations;           // 文字列の番号ごとの世代の番号
+    int *isListed;                       // 文字列の番号ごとに、索引に入っているかどうか
+    int capacity;                        // 文字列の数
+}TargetIndex;
+
+/* ------ プロトタイプ宣言 ------ */
+int target_index_init(TargetIndex *index, int capacity); // 空の索引を作る
+void target_index_free(TargetIndex *index); // 索引のメモリを解放する
+int target_index_add(TargetIndex *index, int strIndex, unsigned int keys); // 最初に打てる文字ごとの列に文字列を追加する
+void target_index_remove(TargetIndex *index, int strIndex); // 文字列を索引から外す
+int target_index_find(TargetIndex *index, unsigned int ch); // 入力された文字で始まる文字列を返す
+int target_index_collect(TargetIndex *index, unsigned int ch, int *strIndexes, int max); // 入力された文字で始まる文字列を全て返す
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * 文字列の描画範囲を覚えておくキャッシュ
+ * オープンアドレス法のハッシュ表で、埋まってきたら全て捨てて作り直す。
+ */
+
+#include <string.h>
+#include "render.h"
+#include "text_metrics.h"
+
+/* ------ 構造体の宣言 ------*/
+// キャッシュの一つの要素
+typedef struct{
+    int isUsed;                      // 使っているかどうか
+    double size;                     // フォントの大きさ
+    char text[TEXT_METRICS_KEY_LEN]; // 文字列
+    double width;                    // 描画範囲の幅
+    double height;                   // 描画範囲の高さ
+}TextMetricsEntry;
+
+/* ------ プロトタイプ宣言 ------ */
+static unsigned int hash_key(double size, const char *text); // フォントの大きさと文字列からハッシュ値を計算する
+static void measure(double size, const char *text, double *width, double *height); // レンダラで描画範囲を調べる
+
+/* ------ グローバル変数の宣言 ------*/
+static TextMetricsEntry entries[TEXT_METRICS_CAPACITY]; // キャッシュの要素
+static int entryNum = 0; // 使っている要素の数
+static int measureLayerId = 0; // 描画範囲を調べるのに使うレイヤ
+static double measureFontSize = -1; // 描画範囲を調べるレイヤに設定したフォントの大きさ
+
+/**
+ * 描画範囲を調べるのに使うレイヤを設定して、キャッシュを空にする
+ * このレイヤのフォントの大きさは描画範囲を調べる度に変わるので、描画には使わない
+ *
+ * @param layerId 描画範囲を調べるのに使うレイヤのid
+ */
+void text_metrics_init(int layerId){
+    measureLayerId = layerId;
+    measureFontSize = -1;
+    text_metrics_clear();
+}
+
+/**
+ * 文字列の描画範囲を返す
+ * キャッシュになければレンダラで調べて保存する。長すぎる文字列は保存せずに毎回調べる
+ *
+ * @param size フォントの大きさ
+ * @param text 文字列
+ * @param width 描画範囲の幅を保存する変数
+ * @param height 描画範囲の高さを保存する変数
+ */
+void text_metrics_measure(double size, const char *text, double *width, double *height){
+    unsigned int index; // 調べる要素の番号
+    TextMetricsEntry *entry; // 調べる要素
+
+    if(strlen(text) >= TEXT_METRICS_KEY_LEN){
+        measure(size, text, width, height);
+        return;
+    }
+    index = hash_key(size, text) & (TEXT_METRICS_CAPACITY - 1);
+    while(entries[index].isUsed == 1){
+        entry = &entries[index];
+        if(entry->size == size && strcmp(entry->text, text) == 0){
+            *width = entry->width;
+            *height = entry->height;
+            return;
+        }
+        index = (index + 1) & (TEXT_METRICS_CAPACITY - 1);
+    }
+
+    // なかった時は調べて保存する 表の3/4が埋まったら全て捨てて作り直す
+    measure(size, text, width, height);
+    if(entryNum >= TEXT_METRICS_CAPACITY / 4 * 3){
+        text_metrics_clear();
+        index = hash_key(size, text) & (TEXT_METRICS_CAPACITY - 1);
+    }
+    entry = &entries[index];
+    entry->isUsed = 1;
+    entry->size = size;
+    strcpy(entry->text, text);
+    entry->width = *width;
+    entry->height = *height;
+    entryNum++;
+}
+
+/**
+ * キャッシュを空にする
+ */
+void text_metrics_clear(void){
+    memset(entries, 0, sizeof(entries));
+    entryNum = 0;
+}
+
+/**
+ * フォントの大きさと文字列から FNV-1a でハッシュ値を計算する
+ *
+ * @param size フォントの大きさ
+ * @param text 文字列
+ *
+ * @return ハッシュ値
+ */
+static unsigned int hash_key(double size, const char *text){
+    unsigned int hash = 2166136261u; // ハッシュ値
+    unsigned int sizeKey = (unsigned int)(size * 16); // フォントの大きさを整数にしたもの
+
+    for(int i = 0; i < 4; i++){
+        hash ^= (sizeKey >> (i * 8)) & 0xFF;
+        hash *= 16777619u;
+    }
+    for(const unsigned char *p = (const unsigned char*)text; *p != '\0'; p++){
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * 描画範囲を調べるレイヤでフォントの大きさを合わせて、レンダラで描画範囲を調べる
+ *
+ * @param size フォントの大きさ
+ * @param text 文字列
+ * @param width 描画範囲の幅を保存する変数
+ * @param height 描画範囲の高さを保存する変数
+ */
+static void measure(double size, const char *text, double *width, double *height){
+    if(measureFontSize != size){
+        render_set_font(measureLayerId, size);
+        measureFontSize = size;
+    }
+    render_text_size(measureLayerId, width, height, "%s", text);
+}
@@ -0,0 +1,19 @@
+/*
+ * 文字列の描画範囲を覚えておくキャッシュ
+ * 描画範囲はフォントの大きさと文字列が同じなら変わらないので、一度調べた値を使い回す。
+ * フォントの種類はゲーム全体で一つなので、キーはフォントの大きさと文字列の組にする。
+ * キャッシュは鍵で守らないので、一度に一つのスレッドだけが使う (ゲーム中はゲームを進めるスレッドが使う)。
+ */
+
+#ifndef FALLTYPING_TEXT_METRICS_H
+#define FALLTYPING_TEXT_METRICS_H
+
+#define TEXT_METRICS_KEY_LEN 64   // キャッシュに保存する文字列の最大の長さ (終端を含む)
+#define TEXT_METRICS_CAPACITY 1024 // キャッシュに保存できる数 (2の累乗)
+
+/* ------ プロトタイプ宣言 ------ */
+void text_metrics_init(int layerId); // 描画範囲を調べるのに使うレイヤを設定して、キャッシュを空にする
+void text_metrics_measure(double size, const char *text, double *width, double *height); // 文字列の描画範囲を返す
+void text_metrics_clear(void); // キャッシュを空にする
+
+#endif
@@ -0,0 +1,214 @@
+/*
+ * デバッグ用のトレース
+ * 複数のスレッドから書き込めるように、要素ごとに番号を持つリングバッファ (Vyukov の有界キュー) を使う。
+ * 読み出すのはバックグラウンドのスレッドだけなので、読み出す位置は原子的な変数にしない。
+ */
+
+#ifdef FALLTYPING_TRACE
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "game_clock.h"
+#include "trace.h"
+
+/* ------ 構造体の宣言 ------*/
+// リングバッファの一つの記録
+typedef struct{
+    atomic_size_t sequence;    // この要素に書き込める、または読み出せる位置を表す番号
+    long long time;            // 記録した時間 (ナノ秒)
+    char text[TRACE_TEXT_LEN]; // 記録の文字列
+}TraceRecord;
+
+/* ------ プロトタイプ宣言 ------ */
+static int site_allow(TraceSite *site, long long now, unsigned long long *suppressedNum); // 場所ごとの回数を確かめる
+static void ring_write(long long now, const char *format, ...); // 記録をリングバッファに書き込む
+static void *flush_thread(void *arg); // 一定の間隔で記録を書き出すスレッド
+static void flush_records(void); // リングバッファにある記録を全て書き出す
+
+/* ------ グローバル変数の宣言 ------*/
+static TraceRecord records[TRACE_RING_SIZE]; // リングバッファ
+static atomic_size_t writePos; // 次に書き込む位置
+static size_t readPos = 0; // 次に読み出す位置 (書き出すスレッドだけが使う)
+static atomic_ullong droppedNum; // いっぱいで捨てた記録の数
+static atomic_int isRunning; // 書き出すスレッドが動いているかどうか
+static pthread_t thread; // 書き出すスレッド
+static FILE *out = NULL; // 書き出し先
+static long long startTime = 0; // トレースを始めた時間
+
+/**
+ * 書き出し先を開いて、書き出すスレッドを動かす
+ */
+void trace_init(void){
+    const char *path = getenv("FALLTYPING_TRACE_FILE"); // 書き出し先のパス
+
+    for(size_t i = 0; i < TRACE_RING_SIZE; i++){
+        atomic_init(&records[i].sequence, i);
+    }
+    atomic_init(&writePos, 0);
+    atomic_init(&droppedNum, 0);
+    readPos = 0;
+    startTime = game_clock_real_ns();
+
+    out = stderr;
+    if(path != NULL && (out = fopen(path, "w")) == NULL){
+        printf("ファイルのオープンに失敗しました\n%sに書き出せるかを確認してください\n", path);
+        out = stderr;
+    }
+    atomic_init(&isRunning, 1);
+    if(pthread_create(&thread, NULL, flush_thread, NULL) != 0){
+        printf("トレースのスレッドの作成に失敗しました\n");
+        atomic_store(&isRunning, 0);
+    }
+}
+
+/**
+ * 残っている記録を書き出して、スレッドを止める
+ */
+void trace_shutdown(void){
+    if(atomic_exchange(&isRunning, 0) == 1){
+        pthread_join(thread, NULL);
+    }
+    flush_records();
+    if(out != NULL && out != stderr){
+        fclose(out);
+    }
+    out = NULL;
+}
+
+/**
+ * TRACE を書いた場所ごとの回数を確かめて、記録をリングバッファに書き込む
+ * 前の区間で記録しなかった数があれば、先にその数を記録する
+ *
+ * @param site TRACE を書いた場所
+ * @param format 記録する文字列の書式
+ */
+void trace_write(TraceSite *site, const char *format, ...){
+    long long now = game_clock_real_ns(); // 記録する時間
+    unsigned long long suppressedNum = 0; // 前の区間で記録しなかった数
+    char text[TRACE_TEXT_LEN]; // 記録の文字列
+    va_list args;
+
+    if(site_allow(site, now, &suppressedNum) == 0){
+        return;
+    }
+    if(suppressedNum != 0){
+        ring_write(now, "suppressed %llu %s:%d", suppressedNum, site->file, site->line);
+    }
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    ring_write(now, "%s", text);
+}
+
+/**
+ * TRACE を書いた場所の今の区間で、まだ記録してよいかを確かめる
+ * 区間が終わっていれば新しい区間を始め、前の区間で記録しなかった数を返す
+ * 区間を始めるのは compare_exchange に勝った一つのスレッドだけなので、数え直しは一回になる
+ *
+ * @param site TRACE を書いた場所
+ * @param now 今の時間 (ナノ秒)
+ * @param suppressedNum 新しい区間を始めた時に、前の区間で記録しなかった数を保存する変数
+ *
+ * @return 1:記録する 0:記録しない
+ */
+static int site_allow(TraceSite *site, long long now, unsigned long long *suppressedNum){
+    long long start = atomic_load_explicit(&site->windowStart, memory_order_relaxed); // 今の区間が始まった時間
+
+    if(now - start >= TRACE_SITE_WINDOW_MS * 1000000LL &&
+       atomic_compare_exchange_strong_explicit(&site->windowStart, &start, now, memory_order_relaxed, memory_order_relaxed)){
+        atomic_store_explicit(&site->count, 0, memory_order_relaxed);
+        *suppressedNum = atomic_exchange_explicit(&site->suppressedNum, 0, memory_order_relaxed);
+    }
+    if(atomic_fetch_add_explicit(&site->count, 1, memory_order_relaxed) < TRACE_SITE_LIMIT){
+        return 1;
+    }
+    atomic_fetch_add_explicit(&site->suppressedNum, 1, memory_order_relaxed);
+    return 0;
+}
+
+/**
+ * 記録をリングバッファに書き込む
+ * ロックもシステムコールも使わない。リングバッファがいっぱいの時は捨てる
+ *
+ * @param now 記録する時間 (ナノ秒)
+ * @param format 記録する文字列の書式
+ */
+static void ring_write(long long now, const char *format, ...){
+    size_t pos = atomic_load_explicit(&writePos, memory_order_relaxed); // 書き込む位置
+    TraceRecord *record; // 書き込む要素
+    va_list args;
+
+    while(1){
+        record = &records[pos & (TRACE_RING_SIZE - 1)];
+        size_t sequence = atomic_load_explicit(&record->sequence, memory_order_acquire); // 要素の番号
+        long long diff = (long long)sequence - (long long)pos; // 書き込めるかどうかの差
+
+        if(diff == 0){ // 空いているので、この位置を取る
+            if(atomic_compare_exchange_weak_explicit(&writePos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)){
+                break;
+            }
+        }else if(diff < 0){ // まだ読み出されていないので、いっぱい
+            atomic_fetch_add_explicit(&droppedNum, 1, memory_order_relaxed);
+            return;
+        }else{ // ほかのスレッドが先に取ったので、位置を読み直す
+            pos = atomic_load_explicit(&writePos, memory_order_relaxed);
+        }
+    }
+
+    record->time = now;
+    va_start(args, format);
+    vsnprintf(record->text, sizeof(record->text), format, args);
+    va_end(args);
+    atomic_store_explicit(&record->sequence, pos + 1, memory_order_release);
+}
+
+/**
+ * 一定の間隔で記録を書き出すスレッド
+ *
+ * @param arg 使わない
+ *
+ * @return NULL
+ */
+static void *flush_thread(void *arg){
+    struct timespec interval = {0, TRACE_FLUSH_MS * 1000000L}; // 書き出す間隔
+
+    (void)arg;
+    while(atomic_load(&isRunning) == 1){
+        flush_records();
+        nanosleep(&interval, NULL);
+    }
+    return NULL;
+}
+
+/**
+ * リングバッファにある記録を、書き込まれた順に全て書き出す
+ * 一行は「トレースを始めてからの時間(マイクロ秒) 記録の文字列」の形式
+ */
+static void flush_records(void){
+    unsigned long long dropped; // 前に書き出してから捨てた記録の数
+
+    if(out == NULL){
+        return;
+    }
+    while(1){
+        TraceRecord *record = &records[readPos & (TRACE_RING_SIZE - 1)]; // 読み出す要素
+
+        if(atomic_load_explicit(&record->sequence, memory_order_acquire) != readPos + 1){
+            break; // まだ書き込まれていない
+        }
+        fprintf(out, "%lld %s\n", (record->time - startTime) / 1000, record->text);
+        atomic_store_explicit(&record->sequence, readPos + TRACE_RING_SIZE, memory_order_release);
+        readPos++;
+    }
+    if((dropped = atomic_exchange_explicit(&droppedNum, 0, memory_order_relaxed)) != 0){
+        fprintf(out, "%lld dropped %llu\n", (game_clock_real_ns() - startTime) / 1000, dropped);
+    }
+    fflush(out);
+}
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * デバッグ用のトレース
+ * FALLTYPING_TRACE を定義してコンパイルした時だけ有効になり、定義しない時は TRACE の引数も評価されない。
+ * 有効な時、TRACE はロックを使わないリングバッファに一行の記録を書き込むだけで、
+ * ファイルへの書き出しはバックグラウンドのスレッドがまとめて行う。
+ * リングバッファがいっぱいの時は記録を捨てて、捨てた数を後で書き出す。
+ * TRACE を書いた場所ごとに、TRACE_SITE_WINDOW_MS ミリ秒の間に TRACE_SITE_LIMIT 回より多くは記録しない。
+ * 毎フレーム通る場所に書いても他の場所の記録が捨てられないようにするためで、
+ * 記録しなかった数は、その場所の次の区間の最初の記録の前に書き出す。
+ *
+ * 書き出し先は環境変数 FALLTYPING_TRACE_FILE で指定する。指定しない時は標準エラー出力に書き出す。
+ *
+ * コンパイル (有効にする時)
+ *   -DFALLTYPING_TRACE -pthread を付けて、trace.c と一緒にコンパイルする
+ */
+
+#ifndef FALLTYPING_TRACE_H
+#define FALLTYPING_TRACE_H
+
+#define TRACE_RING_SIZE 4096   // リングバッファに保存できる記録の数 (2の累乗)
+#define TRACE_TEXT_LEN 120     // 一つの記録の文字列の最大の長さ (終端を含む)
+#define TRACE_FLUSH_MS 10      // バックグラウンドのスレッドが書き出す間隔 (ミリ秒)
+#define TRACE_SITE_WINDOW_MS 1000 // TRACE を書いた場所ごとに記録の回数を数える区間の長さ (ミリ秒)
+#define TRACE_SITE_LIMIT 200   // TRACE を書いた場所ごとに、一つの区間で記録する最大の回数
+
+#ifdef FALLTYPING_TRACE
+
+#include <stdatomic.h>
+
+/* ------ 構造体の宣言 ------*/
+// TRACE を書いた場所ごとの記録の回数 (TRACE の中で static に置くので、0で初期化される)
+typedef struct{
+    const char *file;              // 書いたファイルの名前
+    int line;                      // 書いた行
+    atomic_llong windowStart;      // 今の区間が始まった時間 (ナノ秒)
+    atomic_int count;              // 今の区間で記録しようとした回数
+    atomic_ullong suppressedNum;   // 今の区間で記録しなかった回数
+}TraceSite;
+
+/* ------ プロトタイプ宣言 ------ */
+void trace_init(void); // 書き出し先を開いて、書き出すスレッドを動かす
+void trace_shutdown(void); // 残っている記録を書き出して、スレッドを止める
+void trace_write(TraceSite *site, const char *format, ...); // 場所ごとの回数を確かめて、記録をリングバッファに書き込む
+
+#define TRACE_INIT() trace_init()
+#define TRACE_SHUTDOWN() trace_shutdown()
+#define TRACE(...) do{ \
+        static TraceSite traceSite = {.file = __FILE__, .line = __LINE__}; \
+        trace_write(&traceSite, __VA_ARGS__); \
+    }while(0)
+
+#else
+
+#define TRACE_INIT() ((void)0)
+#define TRACE_SHUTDOWN() ((void)0)
+#define TRACE(...) ((void)0)
+
+#endif
+
+#endif